@@ -0,0 +1,312 @@
+#include "assetpack.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <iterator>
+
+#ifdef SEGANKU_LZ4
+#include <lz4.h>
+#endif
+
+// identifies asset pack files, the last byte is the terminating zero
+static const char ASSET_PACK_MAGIC[8] = "SGKPACK";
+
+MappedFile AssetPack::packFile;
+const AssetPack::TocEntry *AssetPack::entries = nullptr;
+std::uint32_t AssetPack::entryCount = 0;
+
+const char *Asset::getData() const
+{
+	return data;
+}
+
+size_t Asset::getSize() const
+{
+	return size;
+}
+
+bool AssetPack::open(const std::string &packPath)
+{
+	close();
+
+	if (!packFile.open(packPath)) {
+		return false;
+	}
+
+	const char *data = packFile.getData();
+	std::uint64_t size = packFile.getSize();
+
+	PackHeader header;
+	if (size < sizeof(header)) {
+		close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION
+	        || size < sizeof(PackHeader) + std::uint64_t(header.entryCount) * sizeof(TocEntry)) {
+		std::cerr << "ERROR: " << packPath << " is not a valid asset pack" << std::endl;
+		close();
+		return false;
+	}
+
+	// the table of contents is used in place, so check every entry once here instead of at every read
+	const TocEntry *toc = reinterpret_cast<const TocEntry*>(data + sizeof(PackHeader));
+	for (std::uint32_t i = 0; i < header.entryCount; ++i) {
+		const TocEntry &entry = toc[i];
+		bool valid = entry.pathOffset <= size && entry.pathLength <= size - entry.pathOffset
+		        && entry.dataOffset % ALIGNMENT == 0 && entry.dataOffset <= size && entry.storedSize <= size - entry.dataOffset
+		        && (entry.compression == NONE ? entry.storedSize == entry.size : entry.compression == LZ4);
+
+		// sorted by path without duplicates, so entries can be found by binary search
+		if (valid && i > 0) {
+			const TocEntry &previous = toc[i - 1];
+			int order = std::memcmp(data + previous.pathOffset, data + entry.pathOffset, (std::min)(previous.pathLength, entry.pathLength));
+			valid = order < 0 || (order == 0 && previous.pathLength < entry.pathLength);
+		}
+
+		if (!valid) {
+			std::cerr << "ERROR: damaged asset pack " << packPath << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	entries = toc;
+	entryCount = header.entryCount;
+	return true;
+}
+
+void AssetPack::close()
+{
+	entries = nullptr;
+	entryCount = 0;
+	packFile.close();
+}
+
+bool AssetPack::isOpen()
+{
+	return packFile.isOpen();
+}
+
+bool AssetPack::contains(const std::string &path)
+{
+	return findEntry(normalizePath(path)) != nullptr;
+}
+
+bool AssetPack::read(const std::string &path, Asset &asset)
+{
+	asset = Asset();
+
+	const TocEntry *entry = findEntry(normalizePath(path));
+	if (entry) {
+		const char *storedData = packFile.getData() + entry->dataOffset;
+
+		if (entry->compression == NONE) {
+			asset.data = storedData;
+			asset.size = size_t(entry->size);
+			return true;
+		}
+
+#ifdef SEGANKU_LZ4
+		if (entry->size <= INT_MAX && entry->storedSize <= INT_MAX) {
+			std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>(size_t(entry->size));
+			int decompressedSize = LZ4_decompress_safe(storedData, buffer->data(), int(entry->storedSize), int(entry->size));
+			if (decompressedSize == int(entry->size)) {
+				asset.buffer = buffer;
+				asset.data = buffer->data();
+				asset.size = buffer->size();
+				return true;
+			}
+		}
+		std::cerr << "ERROR: could not decompress asset " << path << std::endl;
+#else
+		std::cerr << "ERROR: asset " << path << " is compressed, but this build has no lz4 support" << std::endl;
+#endif
+		return false;
+	}
+
+	// not packed, use the loose file
+	std::shared_ptr<MappedFile> looseFile = std::make_shared<MappedFile>();
+	if (!looseFile->open(path)) {
+		return false;
+	}
+	asset.looseFile = looseFile;
+	asset.data = looseFile->getData();
+	asset.size = looseFile->getSize();
+	return true;
+}
+
+bool AssetPack::write(const std::string &packPath, const std::vector<std::string> &paths, bool compress)
+{
+#ifndef SEGANKU_LZ4
+	if (compress) {
+		std::cerr << "ERROR: cannot compress the asset pack, this build has no lz4 support" << std::endl;
+		return false;
+	}
+#endif
+
+	// the table of contents is sorted by the normalized paths
+	std::vector<std::pair<std::string, std::string>> files;  // normalized path and loose file path
+	for (const std::string &path : paths) {
+		files.push_back(std::make_pair(normalizePath(path), path));
+	}
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end(),
+		[](const std::pair<std::string, std::string> &a, const std::pair<std::string, std::string> &b) { return a.first == b.first; }), files.end());
+
+	PackHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.entryCount = std::uint32_t(files.size());
+
+	std::vector<TocEntry> toc(files.size());
+	std::uint64_t offset = sizeof(PackHeader) + toc.size() * sizeof(TocEntry);
+	for (size_t i = 0; i < files.size(); ++i) {
+		std::memset(&toc[i], 0, sizeof(TocEntry));
+		toc[i].pathOffset = std::uint32_t(offset);
+		toc[i].pathLength = std::uint32_t(files[i].first.size());
+		offset += files[i].first.size();
+	}
+
+	// write to a temporary file first, so a failed write never leaves a damaged pack behind
+	std::string temporaryPath = packPath + ".tmp";
+	{
+		std::ofstream pack(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!pack) {
+			std::cerr << "ERROR: cannot write asset pack " << temporaryPath << std::endl;
+			return false;
+		}
+
+		// the table of contents is written again once the data offsets are known
+		pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		pack.write(reinterpret_cast<const char*>(toc.data()), toc.size() * sizeof(TocEntry));
+		for (const std::pair<std::string, std::string> &file : files) {
+			pack.write(file.first.data(), file.first.size());
+		}
+
+		const char padding[ALIGNMENT] = {};
+		for (size_t i = 0; i < files.size(); ++i) {
+			std::ifstream looseFile(files[i].second, std::ios::binary);
+			std::vector<char> content;
+			if (looseFile) {
+				content.assign(std::istreambuf_iterator<char>(looseFile), std::istreambuf_iterator<char>());
+			}
+			if (!looseFile || looseFile.bad()) {
+				std::cerr << "ERROR: cannot read asset " << files[i].second << std::endl;
+				pack.close();
+				std::remove(temporaryPath.c_str());
+				return false;
+			}
+
+			toc[i].size = content.size();
+			toc[i].compression = NONE;
+
+#ifdef SEGANKU_LZ4
+			// keep the asset uncompressed if compressing does not make it smaller, then it can be used in place
+			if (compress && content.size() <= INT_MAX / 2) {
+				std::vector<char> compressed(LZ4_compressBound(int(content.size())));
+				int compressedSize = LZ4_compress_default(content.data(), compressed.data(), int(content.size()), int(compressed.size()));
+				if (compressedSize > 0 && size_t(compressedSize) < content.size()) {
+					compressed.resize(compressedSize);
+					content.swap(compressed);
+					toc[i].compression = LZ4;
+				}
+			}
+#endif
+
+			toc[i].storedSize = content.size();
+			toc[i].dataOffset = offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			offset += content.size();
+
+			pack.write(padding, toc[i].dataOffset - std::uint64_t(pack.tellp()));
+			pack.write(content.data(), content.size());
+		}
+
+		pack.seekp(sizeof(PackHeader));
+		pack.write(reinterpret_cast<const char*>(toc.data()), toc.size() * sizeof(TocEntry));
+
+		if (!pack) {
+			std::cerr << "ERROR: cannot write asset pack " << temporaryPath << std::endl;
+			pack.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::remove(packPath.c_str());
+	if (std::rename(temporaryPath.c_str(), packPath.c_str()) != 0) {
+		std::cerr << "ERROR: cannot write asset pack " << packPath << std::endl;
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool AssetPack::isCompressionAvailable()
+{
+#ifdef SEGANKU_LZ4
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::string AssetPack::normalizePath(const std::string &path)
+{
+	std::vector<std::string> segments;
+	size_t start = 0;
+	while (start <= path.size()) {
+		size_t end = path.find_first_of("/\\", start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		std::string segment = path.substr(start, end - start);
+		start = end + 1;
+
+		if (segment.empty() || segment == ".") {
+			continue;
+		}
+		if (segment == ".." && !segments.empty() && segments.back() != "..") {
+			segments.pop_back();
+		}
+		else {
+			segments.push_back(segment);
+		}
+	}
+
+	std::string normalizedPath = (!path.empty() && (path[0] == '/' || path[0] == '\\')) ? "/" : "";
+	for (const std::string &segment : segments) {
+		if (!normalizedPath.empty() && normalizedPath != "/") {
+			normalizedPath += '/';
+		}
+		normalizedPath += segment;
+	}
+	return normalizedPath;
+}
+
+const AssetPack::TocEntry *AssetPack::findEntry(const std::string &normalizedPath)
+{
+	const char *data = packFile.getData();
+
+	std::uint32_t first = 0, last = entryCount;
+	while (first < last) {
+		std::uint32_t middle = first + (last - first) / 2;
+		int order = normalizedPath.compare(0, std::string::npos, data + entries[middle].pathOffset, entries[middle].pathLength);
+		if (order == 0) {
+			return &entries[middle];
+		}
+		if (order < 0) {
+			last = middle;
+		}
+		else {
+			first = middle + 1;
+		}
+	}
+	return nullptr;
+}
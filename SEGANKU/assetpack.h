@@ -0,0 +1,137 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "mappedfile.h"
+
+/**
+ * @brief An Asset is the content of one asset file. It points into the mapped asset pack if the file is stored
+ * there uncompressed, otherwise it keeps the mapped loose file or the decompressed data alive.
+ * Copies share the data.
+ */
+class Asset
+{
+	friend class AssetPack;
+
+	const char *data = nullptr;
+	size_t size = 0;
+
+	std::shared_ptr<MappedFile> looseFile;
+	std::shared_ptr<std::vector<char>> buffer;
+
+public:
+	/**
+	 * @return the first byte of the asset, nullptr if nothing is loaded
+	 */
+	const char *getData() const;
+
+	/**
+	 * @return the size of the asset in bytes
+	 */
+	size_t getSize() const;
+};
+
+
+/**
+ * @brief The AssetPack holds all asset files of the game (baked models, textures, shaders and fonts) in one file,
+ * which is mapped into memory once at start. Assets are looked up by the same relative path as the loose file,
+ * uncompressed assets are used in place without copying.
+ * Assets not contained in the pack, or all assets if no pack is open, are read from the loose files,
+ * so development builds work without building a pack.
+ *
+ * layout: a PackHeader, a TocEntry for every asset sorted by path, the paths, then the data of every asset
+ * aligned to 16 bytes, optionally compressed with lz4 (needs SEGANKU_LZ4).
+ * Reading is thread safe once the pack is open.
+ */
+class AssetPack
+{
+public:
+	/**
+	 * @brief map an asset pack, closing the pack opened before
+	 * @param packPath the pack file
+	 * @return false if the file does not exist or is not a valid asset pack
+	 */
+	static bool open(const std::string &packPath);
+
+	/**
+	 * @brief release the mapped pack, assets read from it stay valid only if they were decompressed
+	 */
+	static void close();
+
+	static bool isOpen();
+
+	/**
+	 * @brief check if the open pack contains an asset
+	 * @param path the relative path of the asset
+	 */
+	static bool contains(const std::string &path);
+
+	/**
+	 * @brief get the content of an asset from the pack, or from the loose file if it is not in the pack
+	 * @param path the relative path of the asset
+	 * @param asset is set to the content of the asset
+	 * @return false if the asset is neither in the pack nor a loose file
+	 */
+	static bool read(const std::string &path, Asset &asset);
+
+	/**
+	 * @brief write an asset pack containing the given loose files
+	 * @param packPath the pack file to write
+	 * @param paths the relative paths of the files to pack
+	 * @param compress compress assets with lz4 where it makes them smaller
+	 * @return false if a file could not be read or the pack could not be written
+	 */
+	static bool write(const std::string &packPath, const std::vector<std::string> &paths, bool compress);
+
+	/**
+	 * @return true if this build can read and write lz4 compressed assets
+	 */
+	static bool isCompressionAvailable();
+
+	/**
+	 * @brief bring a relative path into the form used to look up assets:
+	 * forward slashes, no "." segments and no ".." segments after a directory name
+	 */
+	static std::string normalizePath(const std::string &path);
+
+private:
+	static const std::uint32_t VERSION = 1;
+	static const size_t ALIGNMENT = 16;
+
+	enum Compression {
+		NONE = 0,
+		LZ4 = 1
+	};
+
+	struct PackHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t entryCount;
+	};
+
+	struct TocEntry {
+		std::uint64_t dataOffset;
+		std::uint64_t storedSize;     // size in the pack
+		std::uint64_t size;           // size after decompression
+		std::uint32_t pathOffset;
+		std::uint32_t pathLength;
+		std::uint32_t compression;
+		std::uint32_t reserved;
+	};
+
+	static MappedFile packFile;
+	static const TocEntry *entries;
+	static std::uint32_t entryCount;
+
+	/**
+	 * @brief binary search the table of contents
+	 * @return the entry of the normalized path, nullptr if there is none
+	 */
+	static const TocEntry *findEntry(const std::string &normalizedPath);
+};
+
+#endif // ASSETPACK_H
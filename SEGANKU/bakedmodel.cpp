@@ -0,0 +1,226 @@
+#include "bakedmodel.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+// identifies baked model files, the last byte is the terminating zero
+static const char BAKED_MODEL_MAGIC[8] = "SGKMESH";
+
+/**
+ * @brief round an offset up to the next multiple of alignment
+ */
+static std::uint64_t alignOffset(std::uint64_t offset, std::uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+BakedModel::BakedModel()
+{
+}
+
+BakedModel::~BakedModel()
+{
+	close();
+}
+
+std::string BakedModel::getBakedPath(const std::string &modelPath)
+{
+	size_t extension = modelPath.find_last_of('.');
+	size_t directory = modelPath.find_last_of('/');
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory)) {
+		return modelPath + ".mesh";
+	}
+	return modelPath.substr(0, extension) + ".mesh";
+}
+
+bool BakedModel::isUpToDate(const std::string &modelPath)
+{
+	Asset bakedFile;
+	FileHeader header;
+	if (!AssetPack::read(getBakedPath(modelPath), bakedFile) || bakedFile.getSize() < sizeof(header)) {
+		return false;
+	}
+	std::memcpy(&header, bakedFile.getData(), sizeof(header));
+	return isValidHeader(header, modelPath);
+}
+
+bool BakedModel::bake(const std::string &modelPath)
+{
+	std::vector<Geometry::MeshData> meshes;
+	if (!Geometry::importMeshes(modelPath, meshes)) {
+		return false;
+	}
+	return write(modelPath, meshes);
+}
+
+bool BakedModel::write(const std::string &modelPath, const std::vector<Geometry::MeshData> &meshes)
+{
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, BAKED_MODEL_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.surfaceCount = std::uint32_t(meshes.size());
+	if (!MappedFile::getFileInfo(modelPath, header.sourceSize, header.sourceModificationTime)) {
+		std::cerr << "ERROR: cannot bake missing model file " << modelPath << std::endl;
+		return false;
+	}
+
+	// lay out the texture paths after the records and the arrays after the paths
+	std::vector<SurfaceRecord> records(meshes.size());
+	std::uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(SurfaceRecord);
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		for (int j = 0; j < 3; ++j) {
+			records[i].texturePathOffsets[j] = std::uint32_t(offset);
+			records[i].texturePathLengths[j] = std::uint32_t(meshes[i].texturePaths[j].size());
+			offset += meshes[i].texturePaths[j].size();
+		}
+	}
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		glm::vec3 center, farthestPoint;
+		Surface::calculateBoundingSphere(meshes[i].vertices.data(), meshes[i].vertices.size(), center, farthestPoint);
+		for (int j = 0; j < 3; ++j) {
+			records[i].boundingSphereCenter[j] = center[j];
+			records[i].boundingSphereFarthestPoint[j] = farthestPoint[j];
+		}
+
+		records[i].vertexCount = std::uint32_t(meshes[i].vertices.size());
+		records[i].vertexOffset = offset = alignOffset(offset, ALIGNMENT);
+		offset += meshes[i].vertices.size() * sizeof(Vertex);
+
+		records[i].indexCount = std::uint32_t(meshes[i].indices.size());
+		records[i].indexOffset = offset = alignOffset(offset, ALIGNMENT);
+		offset += meshes[i].indices.size() * sizeof(GLuint);
+	}
+
+	// write to a temporary file first, so a failed bake never leaves a damaged file behind
+	std::string bakedPath = getBakedPath(modelPath);
+	std::string temporaryPath = bakedPath + ".tmp";
+	{
+		std::ofstream bakedFile(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!bakedFile) {
+			std::cerr << "ERROR: cannot write baked model " << temporaryPath << std::endl;
+			return false;
+		}
+
+		bakedFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		bakedFile.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(SurfaceRecord));
+		for (const Geometry::MeshData &mesh : meshes) {
+			for (int j = 0; j < 3; ++j) {
+				bakedFile.write(mesh.texturePaths[j].data(), mesh.texturePaths[j].size());
+			}
+		}
+
+		const char padding[ALIGNMENT] = {};
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			bakedFile.write(padding, records[i].vertexOffset - std::uint64_t(bakedFile.tellp()));
+			bakedFile.write(reinterpret_cast<const char*>(meshes[i].vertices.data()), meshes[i].vertices.size() * sizeof(Vertex));
+			bakedFile.write(padding, records[i].indexOffset - std::uint64_t(bakedFile.tellp()));
+			bakedFile.write(reinterpret_cast<const char*>(meshes[i].indices.data()), meshes[i].indices.size() * sizeof(GLuint));
+		}
+
+		if (!bakedFile) {
+			std::cerr << "ERROR: cannot write baked model " << temporaryPath << std::endl;
+			bakedFile.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::remove(bakedPath.c_str());
+	if (std::rename(temporaryPath.c_str(), bakedPath.c_str()) != 0) {
+		std::cerr << "ERROR: cannot write baked model " << bakedPath << std::endl;
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool BakedModel::load(const std::string &modelPath)
+{
+	close();
+
+	if (!AssetPack::read(getBakedPath(modelPath), file)) {
+		return false;
+	}
+
+	const char *data = file.getData();
+	std::uint64_t size = file.getSize();
+
+	FileHeader header;
+	if (size < sizeof(header)) {
+		close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (!isValidHeader(header, modelPath)
+	        || size < sizeof(FileHeader) + std::uint64_t(header.surfaceCount) * sizeof(SurfaceRecord)) {
+		close();
+		return false;
+	}
+
+	// check every range before pointing into the file, a damaged file falls back to the model file
+	surfaces.resize(header.surfaceCount);
+	for (size_t i = 0; i < surfaces.size(); ++i) {
+		SurfaceRecord record;
+		std::memcpy(&record, data + sizeof(FileHeader) + i * sizeof(SurfaceRecord), sizeof(record));
+
+		bool valid = record.vertexOffset % ALIGNMENT == 0 && record.indexOffset % ALIGNMENT == 0
+		        && record.vertexOffset <= size && record.vertexCount <= (size - record.vertexOffset) / sizeof(Vertex)
+		        && record.indexOffset <= size && record.indexCount <= (size - record.indexOffset) / sizeof(GLuint);
+		for (int j = 0; j < 3; ++j) {
+			valid = valid && record.texturePathOffsets[j] <= size && record.texturePathLengths[j] <= size - record.texturePathOffsets[j];
+		}
+		for (std::uint32_t j = 0; valid && j < record.indexCount; ++j) {
+			valid = reinterpret_cast<const GLuint*>(data + record.indexOffset)[j] < record.vertexCount;
+		}
+		if (!valid) {
+			std::cerr << "ERROR: damaged baked model " << getBakedPath(modelPath) << std::endl;
+			close();
+			return false;
+		}
+
+		SurfaceView &surface = surfaces[i];
+		surface.vertices = reinterpret_cast<const Vertex*>(data + record.vertexOffset);
+		surface.vertexCount = record.vertexCount;
+		surface.indices = reinterpret_cast<const GLuint*>(data + record.indexOffset);
+		surface.indexCount = record.indexCount;
+		surface.boundingSphereCenter = glm::vec3(record.boundingSphereCenter[0], record.boundingSphereCenter[1], record.boundingSphereCenter[2]);
+		surface.boundingSphereFarthestPoint = glm::vec3(record.boundingSphereFarthestPoint[0], record.boundingSphereFarthestPoint[1], record.boundingSphereFarthestPoint[2]);
+		for (int j = 0; j < 3; ++j) {
+			surface.texturePaths[j].assign(data + record.texturePathOffsets[j], record.texturePathLengths[j]);
+		}
+	}
+
+	return true;
+}
+
+void BakedModel::close()
+{
+	surfaces.clear();
+	file = Asset();
+}
+
+const std::vector<BakedModel::SurfaceView> &BakedModel::getSurfaces() const
+{
+	return surfaces;
+}
+
+bool BakedModel::isValidHeader(const FileHeader &header, const std::string &modelPath)
+{
+	if (std::memcmp(header.magic, BAKED_MODEL_MAGIC, sizeof(header.magic)) != 0
+	        || header.version != VERSION || header.vertexSize != sizeof(Vertex)) {
+		return false;
+	}
+
+	// the model file may be left out of a release, then the baked file is all there is
+	std::uint64_t sourceSize;
+	std::int64_t sourceModificationTime;
+	if (!MappedFile::getFileInfo(modelPath, sourceSize, sourceModificationTime)) {
+		return true;
+	}
+	return sourceSize == header.sourceSize && sourceModificationTime == header.sourceModificationTime;
+}
@@ -0,0 +1,126 @@
+#ifndef BAKEDMODEL_H
+#define BAKEDMODEL_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "geometry.h"
+#include "mappedfile.h"
+#include "assetpack.h"
+
+/**
+ * @brief A BakedModel is a model converted to a binary file that is mapped into memory and uploaded as it is,
+ * instead of parsing the model file with assimp at every start.
+ * The baked file is stored next to the model file with the extension .mesh, or in the asset pack under that path.
+ * It remembers the size and modification time of the model file it was baked from and is not used anymore
+ * once the model file changes.
+ *
+ * layout: a FileHeader, a SurfaceRecord for every surface, the texture paths, then the vertex and index arrays
+ * of all surfaces, each aligned to 16 bytes. All values are stored in the byte order of the machine that baked it.
+ */
+class BakedModel
+{
+public:
+
+	/**
+	 * @brief a surface of a loaded baked model, vertices and indices point into the mapped file
+	 */
+	struct SurfaceView {
+		const Vertex *vertices;
+		size_t vertexCount;
+		const GLuint *indices;
+		size_t indexCount;
+
+		glm::vec3 boundingSphereCenter;
+		glm::vec3 boundingSphereFarthestPoint;
+
+		// paths of the diffuse, specular and normal texture relative to the model directory, empty if there is none
+		std::string texturePaths[3];
+	};
+
+	BakedModel();
+	~BakedModel();
+
+	/**
+	 * @brief get the path of the baked file belonging to a model file
+	 */
+	static std::string getBakedPath(const std::string &modelPath);
+
+	/**
+	 * @brief check if the baked file of a model file exists and was baked from the current model file.
+	 * if the model file itself does not exist, every valid baked file is up to date.
+	 * @param modelPath the model file
+	 */
+	static bool isUpToDate(const std::string &modelPath);
+
+	/**
+	 * @brief parse a model file and write its baked file
+	 * @param modelPath the model file
+	 * @return false if the model could not be parsed or the baked file could not be written
+	 */
+	static bool bake(const std::string &modelPath);
+
+	/**
+	 * @brief write the baked file of a model file
+	 * @param modelPath the model file the meshes were read from
+	 * @param meshes the mesh data of the model
+	 * @return false if the baked file could not be written
+	 */
+	static bool write(const std::string &modelPath, const std::vector<Geometry::MeshData> &meshes);
+
+	/**
+	 * @brief map the baked file of a model file from the asset pack or the loose file, closing the model loaded before
+	 * @param modelPath the model file
+	 * @return false if there is no baked file, it is out of date or damaged
+	 */
+	bool load(const std::string &modelPath);
+
+	/**
+	 * @brief release the baked file, the surface views become invalid
+	 */
+	void close();
+
+	/**
+	 * @brief get the surfaces of the loaded model, valid until the model is closed
+	 */
+	const std::vector<SurfaceView> &getSurfaces() const;
+
+private:
+	static const std::uint32_t VERSION = 1;
+	static const size_t ALIGNMENT = 16;
+
+	struct FileHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t vertexSize;
+		std::uint64_t sourceSize;
+		std::int64_t sourceModificationTime;
+		std::uint32_t surfaceCount;
+		std::uint32_t reserved;
+	};
+
+	struct SurfaceRecord {
+		std::uint64_t vertexOffset;
+		std::uint64_t indexOffset;
+		std::uint32_t vertexCount;
+		std::uint32_t indexCount;
+		float boundingSphereCenter[3];
+		float boundingSphereFarthestPoint[3];
+		std::uint32_t texturePathOffsets[3];
+		std::uint32_t texturePathLengths[3];
+	};
+
+	Asset file;
+	std::vector<SurfaceView> surfaces;
+
+	/**
+	 * @brief check if a header belongs to this version and to the current model file
+	 */
+	static bool isValidHeader(const FileHeader &header, const std::string &modelPath);
+};
+
+#endif // BAKEDMODEL_H
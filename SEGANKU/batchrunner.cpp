@@ -0,0 +1,150 @@
+#include "batchrunner.h"
+
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+BatchRunner::BatchRunner(int gameCount_, int threadCount_, unsigned int baseSeed_, Agent agent_)
+	: gameCount(gameCount_)
+	, threadCount(threadCount_)
+	, baseSeed(baseSeed_)
+	, agent(agent_)
+	, nextGame(0)
+	, finishedGames(0)
+{
+#ifndef SEGANKU_BULLET_NO_PROFILE
+	// every stepSimulation records into bullet's global profiler, which allocates its nodes without locking
+	if (threadCount > 1) {
+		std::cerr << "WARNING: bullet is built with its profiler (no BT_NO_PROFILE), playing the games on a single thread. "
+		          << "build with the bundled bullet to play them in parallel." << std::endl;
+		threadCount = 1;
+	}
+#endif
+}
+
+BatchRunner::~BatchRunner()
+{
+}
+
+void BatchRunner::run()
+{
+	results.assign(gameCount, GameResult());
+	nextGame = 0;
+	finishedGames = 0;
+
+	std::cout << "PLAYING " << gameCount << " GAMES ON " << threadCount << " THREADS" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// the worlds share nothing but the loaded models and the terrain bvh cache, so the games scale with the number of threads.
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threadCount; ++i) {
+		workers.push_back(std::thread(&BatchRunner::runWorker, this));
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BatchRunner::runWorker()
+{
+	int progressInterval = (std::max)(gameCount / 10, 1);
+
+	for (int game = nextGame++; game < gameCount; game = nextGame++) {
+		results[game] = playGame(baseSeed + game);
+
+		int finished = ++finishedGames;
+		if (finished % progressInterval == 0) {
+			std::lock_guard<std::mutex> lock(outputMutex);
+			std::cout << "finished " << finished << " / " << gameCount << " games" << std::endl;
+		}
+	}
+}
+
+BatchRunner::GameResult BatchRunner::playGame(unsigned int seed)
+{
+	ScriptedInputSource input(agent == RANDOM_AGENT ? ScriptedInputSource::randomScript(seed) : ScriptedInputSource::wanderScript());
+	GameWorld world(&input, 1.0f, seed);
+
+	double stepSize = world.getSimulationClock()->getStepSize();
+	int defenseCount = 0;
+
+	while (!world.isGameOver()) {
+		input.advance(float(stepSize));
+		world.advance(stepSize);
+
+		// defend against the eagle as soon as it comes into reach
+		Eagle *eagle = world.getEagle();
+		if (eagle->getState() == ATTACKING && eagle->isInTargetDefenseReach() && world.activateDefense()) {
+			++defenseCount;
+		}
+	}
+
+	GameResult result;
+	result.seed = seed;
+	result.outcome = world.getOutcome();
+	result.duration = world.getElapsedTime();
+	result.foodCount = world.getPlayer()->getFoodCount();
+	result.defenseCount = defenseCount;
+	return result;
+}
+
+bool BatchRunner::writeCsv(const std::string &filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		std::cerr << "ERROR: Could not write batch results to " << filePath << std::endl;
+		return false;
+	}
+
+	const char *outcomeNames[] = { "running", "won", "eaten", "starved" };
+
+	file << "seed,outcome,duration,food,defenses\n";
+	for (const GameResult &result : results) {
+		file << result.seed << ',' << outcomeNames[result.outcome] << ',' << result.duration << ','
+		     << result.foodCount << ',' << result.defenseCount << '\n';
+	}
+	return true;
+}
+
+void BatchRunner::printSummary() const
+{
+	int outcomeCounts[4] = { 0, 0, 0, 0 };
+	double totalDuration = 0;
+	double totalFood = 0;
+	double totalDefenses = 0;
+	for (const GameResult &result : results) {
+		++outcomeCounts[result.outcome];
+		totalDuration += result.duration;
+		totalFood += result.foodCount;
+		totalDefenses += result.defenseCount;
+	}
+
+	int games = (std::max)(int(results.size()), 1);
+	std::cout << "games: " << results.size() << ", won: " << 100.0 * outcomeCounts[GameWorld::WON] / games
+	          << "%, eaten: " << 100.0 * outcomeCounts[GameWorld::EATEN] / games
+	          << "%, starved: " << 100.0 * outcomeCounts[GameWorld::STARVED] / games << "%" << std::endl;
+	std::cout << "average duration: " << totalDuration / games << " s, food: " << totalFood / games
+	          << ", defenses: " << totalDefenses / games << std::endl;
+	std::cout << "wall time: " << wallTime << " s (" << results.size() / wallTime << " games per s, "
+	          << totalDuration / wallTime << " simulated s per wall s)" << std::endl;
+}
+
+const std::vector<BatchRunner::GameResult> &BatchRunner::getResults() const
+{
+	return results;
+}
+
+double BatchRunner::getGamesPerSecond() const
+{
+	return wallTime > 0 ? results.size() / wallTime : 0;
+}
+
+int BatchRunner::getThreadCount() const
+{
+	return threadCount;
+}
@@ -0,0 +1,92 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+#include "gameworld.h"
+
+/**
+ * @brief The BatchRunner plays many independent headless games in parallel on a pool of worker threads,
+ * to collect outcome statistics for balancing the gameplay values.
+ * Every game runs in its own GameWorld seeded with baseSeed + game index, so any single game can be
+ * replayed by its seed. The player is controlled by an agent, which also activates the defense
+ * whenever the attacking eagle comes into reach.
+ */
+class BatchRunner
+{
+public:
+	enum Agent { SCRIPTED_AGENT, RANDOM_AGENT };
+
+	struct GameResult {
+		unsigned int seed;
+		GameWorld::Outcome outcome;
+		double duration;        // simulated seconds until the game ended
+		int foodCount;          // carrots eaten
+		int defenseCount;       // successful defense activations
+	};
+
+	/**
+	 * @param gameCount_ number of games to play
+	 * @param threadCount_ number of worker threads, each plays one game at a time.
+	 *        limited to 1 unless bullet is built without its profiler (SEGANKU_BULLET_NO_PROFILE), which the bundled bullet is
+	 * @param baseSeed_ seed of the first game, the following games use consecutive seeds
+	 * @param agent_ the agent controlling the player
+	 */
+	BatchRunner(int gameCount_, int threadCount_, unsigned int baseSeed_, Agent agent_);
+	~BatchRunner();
+
+	/**
+	 * @brief play all games, returns when they are finished
+	 */
+	void run();
+
+	/**
+	 * @brief write one line per game to a csv file
+	 * @param filePath the path of the file to write
+	 * @return false if the file could not be written
+	 */
+	bool writeCsv(const std::string &filePath) const;
+
+	/**
+	 * @brief print the outcome rates, averages and throughput of the last run
+	 */
+	void printSummary() const;
+
+	const std::vector<GameResult> &getResults() const;
+
+	/**
+	 * @return the number of games played per wall clock second in the last run
+	 */
+	double getGamesPerSecond() const;
+
+	int getThreadCount() const;
+
+private:
+	int gameCount;
+	int threadCount;
+	unsigned int baseSeed;
+	Agent agent;
+
+	std::vector<GameResult> results; // indexed by game, each entry is written by exactly one worker
+	std::atomic<int> nextGame;       // index of the next game to be taken by a worker
+	std::atomic<int> finishedGames;
+	std::mutex outputMutex;          // serializes progress output of the workers
+	double wallTime = 0;
+
+	/**
+	 * @brief take and play games until none are left
+	 */
+	void runWorker();
+
+	/**
+	 * @brief play a single game until it is over
+	 * @param seed the seed of the game world and the random agent
+	 * @return the result of the game
+	 */
+	GameResult playGame(unsigned int seed);
+};
+
+#endif // BATCHRUNNER_H
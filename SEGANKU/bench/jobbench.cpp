@@ -0,0 +1,196 @@
+/**
+ * seganku_jobbench: measures how the JobSystem scales from 1 to N threads.
+ *
+ * usage: seganku_jobbench [--threads N] [--repetitions N]
+ *
+ * every workload is run with 0 to N-1 workers, the calling thread always takes part as well.
+ * the workloads are
+ * - particles: a parallelFor integrating particles like ParticleSystem::update, memory bound
+ * - fork/join: recursive task groups summing a series, compute bound with many small jobs
+ * - scratch: a parallelFor sorting chunks in per thread scratch memory
+ */
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "../jobsystem.h"
+
+const size_t PARTICLE_COUNT = 2000000;
+const int PARTICLE_STEPS = 10;
+const int FORK_JOIN_DEPTH = 12;
+const int FORK_JOIN_LEAF_TERMS = 10000;
+const size_t SCRATCH_ELEMENT_COUNT = 4000000;
+const size_t SCRATCH_CHUNK_SIZE = 4096;
+
+struct BenchParticle {
+	glm::vec3 pos, velocity;
+	float viewDepth;
+	float timeToLive;
+};
+
+double runParticles(JobSystem &jobs, std::vector<BenchParticle> &particles)
+{
+	const float timeDelta = 1.0f / 60.0f;
+	const glm::mat4 modelViewMat(1.0f);
+
+	for (int step = 0; step < PARTICLE_STEPS; ++step) {
+		jobs.parallelFor(0, particles.size(), 1024, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				BenchParticle &particle = particles[i];
+				particle.timeToLive -= timeDelta;
+				particle.velocity += glm::vec3(0.0f, -9.81f, 0.0f) * timeDelta * 0.1f;
+				particle.pos += particle.velocity * timeDelta;
+				particle.viewDepth = -(modelViewMat * glm::vec4(particle.pos, 1)).z;
+			}
+		});
+	}
+
+	double checksum = 0;
+	for (const BenchParticle &particle : particles) {
+		checksum += particle.viewDepth;
+	}
+	return checksum;
+}
+
+double sumSeries(JobSystem &jobs, int first, int depth)
+{
+	if (depth == 0) {
+		double sum = 0;
+		for (int i = first; i < first + FORK_JOIN_LEAF_TERMS; ++i) {
+			sum += std::sin(double(i)) / (1.0 + i);
+		}
+		return sum;
+	}
+
+	// fork the upper half, compute the lower half on this thread, then join
+	int half = FORK_JOIN_LEAF_TERMS << (depth - 1);
+	double upper = 0;
+	JobSystem::TaskGroup group;
+	jobs.run(group, [&jobs, &upper, first, half, depth]() { upper = sumSeries(jobs, first + half, depth - 1); });
+	double lower = sumSeries(jobs, first, depth - 1);
+	jobs.wait(group);
+	return lower + upper;
+}
+
+double runForkJoin(JobSystem &jobs)
+{
+	return sumSeries(jobs, 0, FORK_JOIN_DEPTH);
+}
+
+double runScratch(JobSystem &jobs, const std::vector<unsigned int> &values)
+{
+	std::vector<double> chunkMedians((values.size() + SCRATCH_CHUNK_SIZE - 1) / SCRATCH_CHUNK_SIZE);
+
+	jobs.parallelFor(0, chunkMedians.size(), 4, [&](size_t begin, size_t end) {
+		JobSystem::ScratchAllocator &scratch = JobSystem::getScratch();
+		for (size_t chunk = begin; chunk < end; ++chunk) {
+			JobSystem::ScratchAllocator::Scope scope(scratch);
+
+			size_t first = chunk * SCRATCH_CHUNK_SIZE;
+			size_t count = (std::min)(SCRATCH_CHUNK_SIZE, values.size() - first);
+			unsigned int *sorted = scratch.allocate<unsigned int>(count);
+			std::memcpy(sorted, values.data() + first, count * sizeof(unsigned int));
+			std::sort(sorted, sorted + count);
+			chunkMedians[chunk] = sorted[count / 2];
+		}
+	});
+
+	double checksum = 0;
+	for (double median : chunkMedians) {
+		checksum += median;
+	}
+	return checksum;
+}
+
+/**
+ * @brief run the workload the given number of times and return the fastest run in ms
+ */
+template<typename Workload>
+double measure(int repetitions, double &checksum, const Workload &workload)
+{
+	double best = 0;
+	for (int i = 0; i < repetitions; ++i) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		checksum = workload();
+		double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || time < best) {
+			best = time;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	int maxThreads = JobSystem::getDefaultWorkerCount() + 1;
+	int repetitions = 3;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (arg == "--threads" && i + 1 < argc) {
+			maxThreads = (std::max)(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--repetitions" && i + 1 < argc) {
+			repetitions = (std::max)(std::atoi(argv[++i]), 1);
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--threads N] [--repetitions N]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<BenchParticle> initialParticles(PARTICLE_COUNT);
+	for (size_t i = 0; i < initialParticles.size(); ++i) {
+		initialParticles[i].pos = glm::vec3(float(i % 100), 0, float(i / 100));
+		initialParticles[i].velocity = glm::vec3(1, 3, 0.5f);
+		initialParticles[i].viewDepth = 0;
+		initialParticles[i].timeToLive = 15;
+	}
+
+	std::vector<unsigned int> values(SCRATCH_ELEMENT_COUNT);
+	unsigned int state = 12345;
+	for (unsigned int &value : values) {
+		state = state * 1664525u + 1013904223u;
+		value = state;
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "threads  particles ms (speedup)  fork/join ms (speedup)  scratch ms (speedup)" << std::endl;
+
+	double baseTimes[3] = { 0, 0, 0 };
+	for (int threads = 1; threads <= maxThreads; ++threads) {
+		JobSystem jobs(threads - 1);
+
+		double checksums[3];
+		double times[3];
+		times[0] = measure(repetitions, checksums[0], [&]() {
+			std::vector<BenchParticle> particles(initialParticles);
+			return runParticles(jobs, particles);
+		});
+		times[1] = measure(repetitions, checksums[1], [&]() { return runForkJoin(jobs); });
+		times[2] = measure(repetitions, checksums[2], [&]() { return runScratch(jobs, values); });
+
+		if (threads == 1) {
+			std::copy(times, times + 3, baseTimes);
+		}
+
+		std::cout << std::setw(7) << threads;
+		for (int i = 0; i < 3; ++i) {
+			std::cout << "  " << std::setw(12) << times[i] << " (" << std::setw(5) << baseTimes[i] / times[i] << "x)";
+		}
+		// print the checksums so the work cannot be optimized away
+		std::cout << "   [" << checksums[0] << ", " << checksums[1] << ", " << checksums[2] << "]" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
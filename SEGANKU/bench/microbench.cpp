@@ -0,0 +1,397 @@
+/**
+ * seganku_microbench: measures the cpu hot paths of the engine in isolation, without window and opengl context.
+ *
+ * usage: seganku_microbench [--repetitions N] [--filter <name part>] [--output <csv file>]
+ *
+ * every benchmark is run the given number of times and the fastest run is reported, one csv row per
+ * benchmark and size on stdout (and in the output file if given), so runs of different commits can be diffed:
+ *     benchmark,size,operations,ns_per_op,total_ms,checksum
+ * the checksum depends only on the work done, a changed checksum means a changed result, not a changed speed.
+ *
+ * the benchmarks are
+ * - sceneobject_compose: SceneObject rotations and translations, which update the matrix and its inverse
+ * - sceneobject_inverse: SceneObject::setTransform, which inverts the matrix
+ * - frustum_check: Camera::checkSphereInFrustum over a set of spheres
+ * - particle_update: ParticleSystem::update with 1k, 10k and 100k particles, on one thread and with a JobSystem
+ * - poisson_sample: PoissonDiskSampler::generatePoissonSample
+ * - terrain_height: TerrainHeightField::getHeight at random points
+ * - terrain_height_scan: the linear vertex scan the height field replaced, at the first of the same points
+ * - surface_bounding_sphere: Surface::calculateBoundingSphere
+ */
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../glstate.h"
+#include "../sceneobject.h"
+#include "../camera.h"
+#include "../surface.h"
+#include "../terrainheightfield.h"
+#include "../poissondisksampler.h"
+#include "../effects/particlesystem.h"
+#include "../jobsystem.h"
+
+const int TRANSFORM_OPERATIONS = 1000000;
+const int SPHERE_COUNTS[2] = { 1000, 100000 };
+const int FRUSTUM_PASSES = 10;
+const int PARTICLE_COUNTS[3] = { 1000, 10000, 100000 };
+const int PARTICLE_STEPS = 20;
+const int POISSON_SAMPLE_SIZES[2] = { 80, 1000 };
+const int TERRAIN_GRID_SIZE = 256;          // vertices per side of the generated terrain
+const float TERRAIN_EXTENT = 200.0f;        // side length of the generated terrain
+const int TERRAIN_QUERIES = 1000000;
+const int TERRAIN_SCAN_QUERIES = 1000;     // the scan visits every vertex per query, so it gets fewer queries
+const float TERRAIN_SCAN_DISTANCE = 0.5f;  // the distance the objects of the world were placed with
+const int SURFACE_VERTEX_COUNTS[2] = { 10000, 1000000 };
+
+// the seed of all random inputs, so every run measures the same work
+const unsigned int RANDOM_SEED = 12345;
+
+struct Result {
+	std::string benchmark;
+	int size;
+	long long operations;
+	double totalTime;  // ms of the fastest run
+	double checksum;
+};
+
+/**
+ * @brief run the workload the given number of times and keep the fastest run
+ * @param prepare function run before every run of the workload, not measured
+ * @param workload function doing the measured work and returning a checksum of its result
+ */
+template<typename Prepare, typename Workload>
+Result measure(const std::string &benchmark, int size, long long operations, int repetitions, const Prepare &prepare, const Workload &workload)
+{
+	Result result;
+	result.benchmark = benchmark;
+	result.size = size;
+	result.operations = operations;
+	result.totalTime = 0;
+	result.checksum = 0;
+
+	for (int i = 0; i < repetitions; ++i) {
+		prepare();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		result.checksum = workload();
+		double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || time < result.totalTime) {
+			result.totalTime = time;
+		}
+	}
+	return result;
+}
+
+template<typename Workload>
+Result measure(const std::string &benchmark, int size, long long operations, int repetitions, const Workload &workload)
+{
+	return measure(benchmark, size, operations, repetitions, []() {}, workload);
+}
+
+double runTransformCompose()
+{
+	SceneObject object(glm::mat4(1.0f));
+	for (int i = 0; i < TRANSFORM_OPERATIONS / 2; ++i) {
+		object.rotateY(0.001f, SceneObject::RIGHT);
+		object.translate(glm::vec3(0.001f, 0, 0.002f), SceneObject::LEFT);
+	}
+
+	glm::vec3 location = object.getLocation();
+	return location.x + location.y + location.z + object.getInverseMatrix()[3].x;
+}
+
+double runTransformInverse(const std::vector<glm::mat4> &matrices)
+{
+	SceneObject object(glm::mat4(1.0f));
+	double checksum = 0;
+	for (int i = 0; i < TRANSFORM_OPERATIONS; ++i) {
+		object.setTransform(matrices[i % matrices.size()]);
+		checksum += object.getInverseMatrix()[3].x;
+	}
+	return checksum;
+}
+
+double runFrustumCheck(Camera &camera, const glm::mat4 &viewMat, const std::vector<glm::vec3> &centers, const std::vector<glm::vec3> &farthestPoints)
+{
+	// the renderer combines the matrices once per frame
+	glm::mat4 viewProjMat = camera.getProjectionMatrix() * viewMat;
+	int visibleCount = 0;
+	for (int pass = 0; pass < FRUSTUM_PASSES; ++pass) {
+		for (size_t i = 0; i < centers.size(); ++i) {
+			if (Camera::checkSphereInFrustum(centers[i], farthestPoints[i], viewProjMat)) {
+				++visibleCount;
+			}
+		}
+	}
+	return visibleCount;
+}
+
+/**
+ * @brief create a particle system holding the given number of particles that live for the whole benchmark
+ */
+std::unique_ptr<ParticleSystem> createParticleSystem(int particleCount, JobSystem *jobs)
+{
+	// all particles are spawned in the first step
+	std::unique_ptr<ParticleSystem> particleSystem(new ParticleSystem(glm::mat4(1.0f), "", particleCount, particleCount * 60.0f, 1.0e6f, 0.1f));
+	particleSystem->seedRandom(RANDOM_SEED);
+	particleSystem->setJobSystem(jobs);
+	particleSystem->respawn(glm::vec3(0));
+	particleSystem->update(1.0f / 60.0f, glm::mat4(1.0f));
+	return particleSystem;
+}
+
+double runParticleUpdate(ParticleSystem &particleSystem, const glm::mat4 &viewMat)
+{
+	for (int step = 0; step < PARTICLE_STEPS; ++step) {
+		particleSystem.update(1.0f / 60.0f, viewMat);
+	}
+
+	const std::vector<float> &instanceData = particleSystem.getInstanceData();
+	double checksum = 0;
+	for (size_t i = 0; i < instanceData.size(); i += 4) {
+		checksum += instanceData[i] + instanceData[i + 1] + instanceData[i + 2];
+	}
+	return checksum;
+}
+
+double runPoissonSample(int sampleSize)
+{
+	// the minimal distance shrinks with the number of samples, like for the objects placed in the world
+	std::mt19937 randGen(RANDOM_SEED);
+	std::vector<glm::vec2> positions = PoissonDiskSampler::generatePoissonSample(sampleSize, 0.4f / std::sqrt(sampleSize / 80.0f), randGen);
+
+	double checksum = 0;
+	for (const glm::vec2 &position : positions) {
+		checksum += position.x + position.y;
+	}
+	return checksum;
+}
+
+/**
+ * @brief generate the vertices of a hilly square grid centered at the origin
+ */
+std::vector<Vertex> generateTerrainVertices()
+{
+	std::vector<Vertex> vertices(TERRAIN_GRID_SIZE * TERRAIN_GRID_SIZE);
+	float spacing = TERRAIN_EXTENT / (TERRAIN_GRID_SIZE - 1);
+	for (int z = 0; z < TERRAIN_GRID_SIZE; ++z) {
+		for (int x = 0; x < TERRAIN_GRID_SIZE; ++x) {
+			Vertex &vertex = vertices[z * TERRAIN_GRID_SIZE + x];
+			float posX = x * spacing - TERRAIN_EXTENT / 2, posZ = z * spacing - TERRAIN_EXTENT / 2;
+			vertex.position = glm::vec3(posX, 3 * std::sin(posX * 0.1f) * std::cos(posZ * 0.07f), posZ);
+			vertex.normal = glm::vec3(0, 1, 0);
+			vertex.uv = glm::vec2(float(x) / TERRAIN_GRID_SIZE, float(z) / TERRAIN_GRID_SIZE);
+		}
+	}
+	return vertices;
+}
+
+/**
+ * @brief generate the indices of two triangles per cell of the grid
+ */
+std::vector<GLuint> generateTerrainIndices()
+{
+	std::vector<GLuint> indices;
+	indices.reserve((TERRAIN_GRID_SIZE - 1) * (TERRAIN_GRID_SIZE - 1) * 6);
+	for (int z = 0; z < TERRAIN_GRID_SIZE - 1; ++z) {
+		for (int x = 0; x < TERRAIN_GRID_SIZE - 1; ++x) {
+			GLuint corner = z * TERRAIN_GRID_SIZE + x;
+			GLuint cellIndices[6] = { corner, corner + TERRAIN_GRID_SIZE, corner + 1, corner + 1, corner + TERRAIN_GRID_SIZE, corner + TERRAIN_GRID_SIZE + 1 };
+			indices.insert(indices.end(), cellIndices, cellIndices + 6);
+		}
+	}
+	return indices;
+}
+
+double runTerrainHeight(const TerrainHeightField &heightField, const std::vector<glm::vec2> &points)
+{
+	double checksum = 0;
+	for (const glm::vec2 &point : points) {
+		checksum += heightField.getHeight(point);
+	}
+	return checksum;
+}
+
+/**
+ * @brief the height query used before TerrainHeightField: the height of the first vertex found within
+ * maxDistanceXY in x and z, or 0 if there is none.
+ * the old function also copied all vertices on every call, this is left out, so the result is a lower bound of its cost.
+ */
+float scanTerrainHeight(const std::vector<Vertex> &vertices, const glm::vec2 &point, float maxDistanceXY)
+{
+	for (const Vertex &vertex : vertices) {
+		if (point.x > vertex.position.x - maxDistanceXY && point.x < vertex.position.x + maxDistanceXY &&
+		    point.y > vertex.position.z - maxDistanceXY && point.y < vertex.position.z + maxDistanceXY) {
+			return vertex.position.y;
+		}
+	}
+	return 0.0f;
+}
+
+double runTerrainHeightScan(const std::vector<Vertex> &vertices, const std::vector<glm::vec2> &points)
+{
+	double checksum = 0;
+	for (int i = 0; i < TERRAIN_SCAN_QUERIES; ++i) {
+		checksum += scanTerrainHeight(vertices, points[i], TERRAIN_SCAN_DISTANCE);
+	}
+	return checksum;
+}
+
+double runSurfaceBoundingSphere(const std::vector<Vertex> &vertices)
+{
+	glm::vec3 center, farthestPoint;
+	Surface::calculateBoundingSphere(vertices.data(), vertices.size(), center, farthestPoint);
+	return center.x + center.y + center.z + farthestPoint.x + farthestPoint.y + farthestPoint.z;
+}
+
+int main(int argc, char **argv)
+{
+	int repetitions = 5;
+	std::string filter;
+	std::string outputPath;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if (arg == "--repetitions" && i + 1 < argc) {
+			repetitions = (std::max)(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--filter" && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (arg == "--output" && i + 1 < argc) {
+			outputPath = argv[++i];
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--repetitions N] [--filter <name part>] [--output <csv file>]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// nothing is drawn, surfaces and particle systems only keep their data
+	GLState::contextAvailable = false;
+
+	std::mt19937 randGen(RANDOM_SEED);
+	std::uniform_real_distribution<float> randDistribution(-1.0f, 1.0f);
+
+	std::vector<Result> results;
+	auto selected = [&filter](const std::string &benchmark) { return benchmark.find(filter) != std::string::npos; };
+
+	if (selected("sceneobject_compose")) {
+		results.push_back(measure("sceneobject_compose", 1, TRANSFORM_OPERATIONS, repetitions, []() { return runTransformCompose(); }));
+	}
+
+	if (selected("sceneobject_inverse")) {
+		std::vector<glm::mat4> matrices(1024);
+		for (glm::mat4 &matrix : matrices) {
+			matrix = glm::translate(glm::mat4(1.0f), 50.0f * glm::vec3(randDistribution(randGen), randDistribution(randGen), randDistribution(randGen)));
+			matrix = glm::rotate(matrix, glm::pi<float>() * randDistribution(randGen), glm::vec3(0, 1, 0));
+			matrix = glm::scale(matrix, glm::vec3(1.5f + randDistribution(randGen)));
+		}
+		results.push_back(measure("sceneobject_inverse", 1, TRANSFORM_OPERATIONS, repetitions, [&]() { return runTransformInverse(matrices); }));
+	}
+
+	if (selected("frustum_check")) {
+		// the player camera, looking over the terrain from above its center
+		Camera camera(glm::mat4(1.0f), glm::radians(80.0f), 4.0f / 3.0f, 0.2f, 200.0f);
+		glm::mat4 viewMat = glm::lookAt(glm::vec3(0, 5, 0), glm::vec3(10, 3, 10), glm::vec3(0, 1, 0));
+
+		for (int sphereCount : SPHERE_COUNTS) {
+			std::vector<glm::vec3> centers(sphereCount), farthestPoints(sphereCount);
+			for (int i = 0; i < sphereCount; ++i) {
+				centers[i] = glm::vec3(100 * randDistribution(randGen), 5 * randDistribution(randGen), 100 * randDistribution(randGen));
+				farthestPoints[i] = centers[i] + glm::vec3(2 + randDistribution(randGen), 0, 0);
+			}
+			results.push_back(measure("frustum_check", sphereCount, (long long)sphereCount * FRUSTUM_PASSES, repetitions,
+				[&]() { return runFrustumCheck(camera, viewMat, centers, farthestPoints); }));
+		}
+	}
+
+	if (selected("particle_update")) {
+		glm::mat4 viewMat = glm::lookAt(glm::vec3(0, 5, 20), glm::vec3(0), glm::vec3(0, 1, 0));
+		JobSystem jobs;
+
+		for (int particleCount : PARTICLE_COUNTS) {
+			// every run starts from the same particles, spawning them is not measured
+			std::unique_ptr<ParticleSystem> particleSystem;
+			results.push_back(measure("particle_update", particleCount, PARTICLE_STEPS, repetitions,
+				[&]() { particleSystem = createParticleSystem(particleCount, nullptr); },
+				[&]() { return runParticleUpdate(*particleSystem, viewMat); }));
+			results.push_back(measure("particle_update_jobs", particleCount, PARTICLE_STEPS, repetitions,
+				[&]() { particleSystem = createParticleSystem(particleCount, &jobs); },
+				[&]() { return runParticleUpdate(*particleSystem, viewMat); }));
+		}
+	}
+
+	if (selected("poisson_sample")) {
+		for (int sampleSize : POISSON_SAMPLE_SIZES) {
+			results.push_back(measure("poisson_sample", sampleSize, 1, repetitions, [sampleSize]() { return runPoissonSample(sampleSize); }));
+		}
+	}
+
+	if (selected("terrain_height") || selected("terrain_height_scan")) {
+		std::shared_ptr<Texture> noTexture;
+		Surface terrainSurface(generateTerrainVertices(), generateTerrainIndices(), noTexture, noTexture, noTexture);
+		TerrainHeightField heightField(&terrainSurface, glm::mat4(1.0f), 0.25f);
+
+		std::vector<glm::vec2> points(TERRAIN_QUERIES);
+		for (glm::vec2 &point : points) {
+			point = 0.5f * TERRAIN_EXTENT * glm::vec2(randDistribution(randGen), randDistribution(randGen));
+		}
+		if (selected("terrain_height")) {
+			results.push_back(measure("terrain_height", TERRAIN_GRID_SIZE, TERRAIN_QUERIES, repetitions, [&]() { return runTerrainHeight(heightField, points); }));
+		}
+		if (selected("terrain_height_scan")) {
+			results.push_back(measure("terrain_height_scan", TERRAIN_GRID_SIZE, TERRAIN_SCAN_QUERIES, repetitions,
+				[&]() { return runTerrainHeightScan(terrainSurface.getVertices(), points); }));
+		}
+	}
+
+	if (selected("surface_bounding_sphere")) {
+		for (int vertexCount : SURFACE_VERTEX_COUNTS) {
+			std::vector<Vertex> vertices(vertexCount);
+			for (Vertex &vertex : vertices) {
+				vertex.position = 10.0f * glm::vec3(randDistribution(randGen), randDistribution(randGen), randDistribution(randGen));
+				vertex.normal = glm::vec3(0, 1, 0);
+				vertex.uv = glm::vec2(0);
+			}
+			results.push_back(measure("surface_bounding_sphere", vertexCount, vertexCount, repetitions, [&]() { return runSurfaceBoundingSphere(vertices); }));
+		}
+	}
+
+	std::ostringstream csv;
+	csv << "benchmark,size,operations,ns_per_op,total_ms,checksum\n";
+	for (const Result &result : results) {
+		csv << result.benchmark << ',' << result.size << ',' << result.operations << ','
+		    << std::fixed << std::setprecision(3) << result.totalTime * 1.0e6 / result.operations << ',' << result.totalTime << ','
+		    << std::setprecision(6) << std::scientific << result.checksum << '\n';
+		csv.unsetf(std::ios::floatfield);
+	}
+
+	std::cout << csv.str();
+
+	if (!outputPath.empty()) {
+		std::ofstream file(outputPath);
+		if (!file) {
+			std::cerr << "ERROR: Could not write results to " << outputPath << std::endl;
+			return EXIT_FAILURE;
+		}
+		file << csv.str();
+	}
+
+	return EXIT_SUCCESS;
+}
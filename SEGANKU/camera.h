@@ -102,11 +102,14 @@ public:
 	 * lies completely within the view frustum.
 	 * note that the farthest point is passed instead of the radius to apply matrices
 	 * to do the checks in clip space.
+	 * this only uses the given matrix, so the render thread can cull with the matrices of a snapshot
+	 * while the simulation thread changes the camera.
 	 * @param sphereCenter the center of the sphere in world space
 	 * @param sphereFarthestPoint the farthest point from sphere center in world space
+	 * @param viewProjMat the projection matrix times the view matrix
 	 * @return whether the sphere lies completely within the view frustum
 	 */
-	bool checkSphereInFrustum(const glm::vec3 &sphereCenterWorldSpace, const glm::vec3 &sphereFarthestPointWorldSpace, const glm::mat4 &viewMat);
+	static bool checkSphereInFrustum(const glm::vec3 &sphereCenterWorldSpace, const glm::vec3 &sphereFarthestPointWorldSpace, const glm::mat4 &viewProjMat);
 
 };
 
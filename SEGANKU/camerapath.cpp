@@ -0,0 +1,168 @@
+#include "camerapath.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+CameraPath::CameraPath()
+{
+}
+
+CameraPath CameraPath::circleTerrain(const TerrainHeightField *heightField, float duration)
+{
+	CameraPath path;
+
+	glm::vec2 boundsMin = heightField->getBoundsMin(), boundsMax = heightField->getBoundsMax();
+	glm::vec2 center = (boundsMin + boundsMax) * 0.5f;
+	float maxRadius = glm::min(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y) * 0.4f;
+
+	// one circle around the center, coming close in between, looking ahead along the path
+	const int keyframeCount = 32;
+	for (int i = 0; i <= keyframeCount; ++i) {
+		float t = float(i) / keyframeCount;
+		float angle = t * 2 * glm::pi<float>();
+		float radius = maxRadius * (0.6f + 0.4f * glm::cos(2 * angle));
+
+		glm::vec2 position2D = center + radius * glm::vec2(glm::cos(angle), glm::sin(angle));
+		glm::vec2 target2D = center + radius * glm::vec2(glm::cos(angle + 0.5f), glm::sin(angle + 0.5f));
+
+		glm::vec3 position(position2D.x, heightField->getHeight(position2D) + 3.0f, position2D.y);
+		glm::vec3 target(target2D.x, heightField->getHeight(target2D) + 1.5f, target2D.y);
+		path.addKeyframe(t * duration, position, target);
+	}
+
+	return path;
+}
+
+void CameraPath::addKeyframe(float time, const glm::vec3 &position, const glm::vec3 &target)
+{
+	Keyframe keyframe;
+	keyframe.time = time;
+	keyframe.position = position;
+	keyframe.target = target;
+	keyframes.push_back(keyframe);
+}
+
+bool CameraPath::load(const std::string &filePath)
+{
+	std::ifstream file(filePath);
+	if (!file) {
+		std::cerr << "ERROR: Could not read camera path " << filePath << std::endl;
+		return false;
+	}
+
+	keyframes.clear();
+
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		Keyframe keyframe;
+		std::istringstream values(line);
+		if ((values >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+		            >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z).fail()) {
+			std::cerr << "ERROR: Invalid keyframe in camera path " << filePath << ": " << line << std::endl;
+			return false;
+		}
+		keyframes.push_back(keyframe);
+	}
+
+	if (keyframes.size() < 2) {
+		std::cerr << "ERROR: Camera path " << filePath << " needs at least two keyframes" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool CameraPath::save(const std::string &filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		std::cerr << "ERROR: Could not write camera path " << filePath << std::endl;
+		return false;
+	}
+
+	file << "# time position.x position.y position.z target.x target.y target.z\n";
+	for (const Keyframe &keyframe : keyframes) {
+		file << keyframe.time << ' ' << keyframe.position.x << ' ' << keyframe.position.y << ' ' << keyframe.position.z << ' '
+		     << keyframe.target.x << ' ' << keyframe.target.y << ' ' << keyframe.target.z << '\n';
+	}
+
+	return true;
+}
+
+float CameraPath::getDuration() const
+{
+	return keyframes.empty() ? 0.0f : keyframes.back().time;
+}
+
+int CameraPath::getKeyframeCount() const
+{
+	return int(keyframes.size());
+}
+
+glm::vec3 CameraPath::getPosition(float time) const
+{
+	int segment;
+	float t;
+	findSegment(time, segment, t);
+	return interpolate(&Keyframe::position, segment, t);
+}
+
+glm::mat4 CameraPath::getViewMatrix(float time) const
+{
+	int segment;
+	float t;
+	findSegment(time, segment, t);
+	return glm::lookAt(interpolate(&Keyframe::position, segment, t), interpolate(&Keyframe::target, segment, t), glm::vec3(0, 1, 0));
+}
+
+void CameraPath::findSegment(float time, int &segment, float &t) const
+{
+	if (keyframes.size() < 2 || time <= keyframes.front().time) {
+		segment = 0;
+		t = 0;
+		return;
+	}
+	if (time >= keyframes.back().time) {
+		segment = int(keyframes.size()) - 2;
+		t = 1;
+		return;
+	}
+
+	// the first keyframe after the time
+	std::vector<Keyframe>::const_iterator next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+		[](float time, const Keyframe &keyframe) { return time < keyframe.time; });
+	segment = int(next - keyframes.begin()) - 1;
+
+	float segmentDuration = next->time - keyframes[segment].time;
+	t = segmentDuration > 0 ? (time - keyframes[segment].time) / segmentDuration : 0.0f;
+}
+
+glm::vec3 CameraPath::interpolate(glm::vec3 Keyframe::*attribute, int segment, float t) const
+{
+	if (keyframes.empty()) {
+		return glm::vec3(0);
+	}
+	if (keyframes.size() == 1) {
+		return keyframes[0].*attribute;
+	}
+
+	// catmull-rom spline through the keyframes, the end keyframes are repeated
+	int last = int(keyframes.size()) - 1;
+	const glm::vec3 &p0 = keyframes[(std::max)(segment - 1, 0)].*attribute;
+	const glm::vec3 &p1 = keyframes[segment].*attribute;
+	const glm::vec3 &p2 = keyframes[(std::min)(segment + 1, last)].*attribute;
+	const glm::vec3 &p3 = keyframes[(std::min)(segment + 2, last)].*attribute;
+
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
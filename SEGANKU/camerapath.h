@@ -0,0 +1,87 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "terrainheightfield.h"
+
+/**
+ * @brief A CameraPath is a sequence of camera keyframes, each with a time, a position and a point
+ * looked at, between which the camera moves along a Catmull-Rom spline.
+ * Paths are recorded while playing and replayed by the benchmark, so every run sees the same frames.
+ *
+ * Path files are text, one keyframe per line: time px py pz tx ty tz. Lines starting with # are ignored.
+ */
+class CameraPath
+{
+public:
+	struct Keyframe {
+		float time;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+
+	CameraPath();
+
+	/**
+	 * @brief a path circling the terrain center at a varying distance, for when no recorded path is given
+	 * @param heightField the terrain, the camera is kept above it
+	 * @param duration the duration of the path in seconds
+	 */
+	static CameraPath circleTerrain(const TerrainHeightField *heightField, float duration);
+
+	/**
+	 * @brief append a keyframe, keyframes must be added in order of time
+	 */
+	void addKeyframe(float time, const glm::vec3 &position, const glm::vec3 &target);
+
+	/**
+	 * @brief load keyframes from a path file, replacing the current ones
+	 * @return false if the file could not be read or contains less than two keyframes
+	 */
+	bool load(const std::string &filePath);
+
+	/**
+	 * @brief write the keyframes to a path file
+	 * @return false if the file could not be written
+	 */
+	bool save(const std::string &filePath) const;
+
+	/**
+	 * @return the time of the last keyframe
+	 */
+	float getDuration() const;
+
+	int getKeyframeCount() const;
+
+	/**
+	 * @brief get the interpolated camera position at the given time
+	 */
+	glm::vec3 getPosition(float time) const;
+
+	/**
+	 * @brief get the interpolated view matrix at the given time
+	 */
+	glm::mat4 getViewMatrix(float time) const;
+
+private:
+	std::vector<Keyframe> keyframes;
+
+	/**
+	 * @brief find the keyframe segment containing the time
+	 * @param segment is set to the index of the keyframe starting the segment
+	 * @param t is set to the position within the segment in [0, 1]
+	 */
+	void findSegment(float time, int &segment, float &t) const;
+
+	/**
+	 * @brief interpolate a keyframe attribute between keyframe segment and segment + 1
+	 */
+	glm::vec3 interpolate(glm::vec3 Keyframe::*attribute, int segment, float t) const;
+};
+
+#endif // CAMERAPATH_H
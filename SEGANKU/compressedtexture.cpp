@@ -0,0 +1,452 @@
+#include "compressedtexture.h"
+#include "texture.h"
+#include "mappedfile.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+
+// identifies compressed texture files, the last byte is the terminating zero
+static const char COMPRESSED_TEXTURE_MAGIC[8] = "SGKCTEX";
+
+// the color bounding box is shrunk by 1/16 of its size on each side, so single outliers do not stretch the endpoints
+static const int INSET_SHIFT = 4;
+
+// set by detectSupport on the context thread, read by any thread afterwards
+static bool compressionSupported = false;
+
+/**
+ * @brief pack an 8 bit color into 5:6:5 bits
+ */
+static std::uint16_t packColor565(const int color[3])
+{
+	return std::uint16_t(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+/**
+ * @brief unpack a 5:6:5 color into 8 bits per channel, as the gpu does
+ */
+static void unpackColor565(std::uint16_t packed, int color[3])
+{
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * @brief write a value of the given number of bytes in little endian byte order
+ */
+static void writeLittleEndian(std::uint64_t value, int byteCount, std::uint8_t *out)
+{
+	for (int i = 0; i < byteCount; ++i) {
+		out[i] = std::uint8_t(value >> (8 * i));
+	}
+}
+
+CompressedTexture::CompressedTexture()
+	: format(BC1)
+{
+}
+
+CompressedTexture::~CompressedTexture()
+{
+	close();
+}
+
+std::string CompressedTexture::getCompressedPath(const std::string &imagePath)
+{
+	return imagePath + ".ctex";
+}
+
+bool CompressedTexture::isUpToDate(const std::string &imagePath)
+{
+	Asset compressedFile;
+	FileHeader header;
+	if (!AssetPack::read(getCompressedPath(imagePath), compressedFile) || compressedFile.getSize() < sizeof(header)) {
+		return false;
+	}
+	std::memcpy(&header, compressedFile.getData(), sizeof(header));
+	return isValidHeader(header, imagePath);
+}
+
+bool CompressedTexture::bake(const std::string &imagePath)
+{
+	fipImage image;
+	if (!Texture::decode(imagePath, image)) {
+		return false;
+	}
+
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, COMPRESSED_TEXTURE_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.width = image.getWidth();
+	header.height = image.getHeight();
+	if (!MappedFile::getFileInfo(imagePath, header.sourceSize, header.sourceModificationTime)) {
+		std::cerr << "ERROR: cannot bake missing image " << imagePath << std::endl;
+		return false;
+	}
+
+	// read the texels in rgba order, freeimage stores them in the byte order of the platform
+	bool hadAlpha = image.getBitsPerPixel() == 32;
+	if (!image.convertTo32Bits()) {
+		std::cerr << "ERROR: cannot convert image " << imagePath << std::endl;
+		return false;
+	}
+	std::vector<std::uint8_t> texels(size_t(header.width) * header.height * 4);
+	bool transparent = false;
+	for (unsigned int y = 0; y < header.height; ++y) {
+		const BYTE *scanLine = image.getScanLine(y);
+		for (unsigned int x = 0; x < header.width; ++x) {
+			std::uint8_t *texel = &texels[(size_t(y) * header.width + x) * 4];
+			texel[0] = scanLine[4 * x + FI_RGBA_RED];
+			texel[1] = scanLine[4 * x + FI_RGBA_GREEN];
+			texel[2] = scanLine[4 * x + FI_RGBA_BLUE];
+			texel[3] = hadAlpha ? scanLine[4 * x + FI_RGBA_ALPHA] : 255;
+			transparent = transparent || texel[3] < 255;
+		}
+	}
+	Format format = transparent ? BC3 : BC1;
+	header.format = format;
+
+	// build and compress the mip chain down to 1x1, the same levels glGenerateMipmap would create
+	std::vector<std::vector<std::uint8_t>> levelBlocks;
+	std::vector<LevelRecord> records;
+	unsigned int width = header.width, height = header.height;
+	while (true) {
+		levelBlocks.push_back(std::vector<std::uint8_t>());
+		encodeLevel(format, texels, width, height, levelBlocks.back());
+
+		LevelRecord record;
+		std::memset(&record, 0, sizeof(record));
+		record.width = width;
+		record.height = height;
+		record.size = levelBlocks.back().size();
+		records.push_back(record);
+
+		if (width == 1 && height == 1) {
+			break;
+		}
+		std::vector<std::uint8_t> halved;
+		downsample(texels, width, height, halved);
+		texels.swap(halved);
+		width = (std::max)(width / 2, 1u);
+		height = (std::max)(height / 2, 1u);
+	}
+	header.levelCount = std::uint32_t(records.size());
+
+	std::uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(LevelRecord);
+	for (LevelRecord &record : records) {
+		record.offset = offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		offset += record.size;
+	}
+
+	// write to a temporary file first, so a failed bake never leaves a damaged file behind
+	std::string compressedPath = getCompressedPath(imagePath);
+	std::string temporaryPath = compressedPath + ".tmp";
+	{
+		std::ofstream compressedFile(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!compressedFile) {
+			std::cerr << "ERROR: cannot write compressed texture " << temporaryPath << std::endl;
+			return false;
+		}
+
+		compressedFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		compressedFile.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(LevelRecord));
+
+		const char padding[ALIGNMENT] = {};
+		for (size_t i = 0; i < records.size(); ++i) {
+			compressedFile.write(padding, records[i].offset - std::uint64_t(compressedFile.tellp()));
+			compressedFile.write(reinterpret_cast<const char*>(levelBlocks[i].data()), levelBlocks[i].size());
+		}
+
+		if (!compressedFile) {
+			std::cerr << "ERROR: cannot write compressed texture " << temporaryPath << std::endl;
+			compressedFile.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::remove(compressedPath.c_str());
+	if (std::rename(temporaryPath.c_str(), compressedPath.c_str()) != 0) {
+		std::cerr << "ERROR: cannot write compressed texture " << compressedPath << std::endl;
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void CompressedTexture::detectSupport()
+{
+	// the extension string of a core profile can only be queried one by one
+	compressionSupported = false;
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount; ++i) {
+		const char *extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (extension && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0) {
+			compressionSupported = true;
+		}
+	}
+}
+
+bool CompressedTexture::isSupported()
+{
+	return compressionSupported;
+}
+
+bool CompressedTexture::load(const std::string &imagePath)
+{
+	close();
+
+	if (!AssetPack::read(getCompressedPath(imagePath), file)) {
+		return false;
+	}
+
+	const char *data = file.getData();
+	std::uint64_t size = file.getSize();
+
+	FileHeader header;
+	if (size < sizeof(header)) {
+		close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (!isValidHeader(header, imagePath) || (header.format != BC1 && header.format != BC3)
+	        || size < sizeof(FileHeader) + std::uint64_t(header.levelCount) * sizeof(LevelRecord)) {
+		close();
+		return false;
+	}
+	format = Format(header.format);
+
+	// the levels must halve down from the full size, and every range must lie in the file
+	levels.resize(header.levelCount);
+	unsigned int width = header.width, height = header.height;
+	for (size_t i = 0; i < levels.size(); ++i) {
+		LevelRecord record;
+		std::memcpy(&record, data + sizeof(FileHeader) + i * sizeof(LevelRecord), sizeof(record));
+
+		if (record.width != width || record.height != height || record.size != getLevelSize(format, width, height)
+		        || record.offset % ALIGNMENT != 0 || record.offset > size || record.size > size - record.offset) {
+			std::cerr << "ERROR: damaged compressed texture " << getCompressedPath(imagePath) << std::endl;
+			close();
+			return false;
+		}
+
+		levels[i].data = data + record.offset;
+		levels[i].size = size_t(record.size);
+		levels[i].width = width;
+		levels[i].height = height;
+
+		width = (std::max)(width / 2, 1u);
+		height = (std::max)(height / 2, 1u);
+	}
+
+	return !levels.empty();
+}
+
+void CompressedTexture::close()
+{
+	levels.clear();
+	file = Asset();
+}
+
+CompressedTexture::Format CompressedTexture::getFormat() const
+{
+	return format;
+}
+
+GLenum CompressedTexture::getGLFormat() const
+{
+	return format == BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+const std::vector<CompressedTexture::Level> &CompressedTexture::getLevels() const
+{
+	return levels;
+}
+
+void CompressedTexture::encodeBC1Block(const std::uint8_t *texels, std::uint8_t *block)
+{
+	// the endpoints are the corners of the bounding box of the colors
+	int minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			minColor[c] = (std::min)(minColor[c], int(texels[4 * i + c]));
+			maxColor[c] = (std::max)(maxColor[c], int(texels[4 * i + c]));
+		}
+	}
+
+	// take the diagonal of the box the colors lie along: if green or blue falls while red rises, swap their ends
+	int center[3];
+	for (int c = 0; c < 3; ++c) {
+		center[c] = (minColor[c] + maxColor[c]) / 2;
+	}
+	int covariance[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		int red = texels[4 * i] - center[0];
+		covariance[1] += red * (texels[4 * i + 1] - center[1]);
+		covariance[2] += red * (texels[4 * i + 2] - center[2]);
+	}
+	for (int c = 1; c < 3; ++c) {
+		if (covariance[c] < 0) {
+			std::swap(minColor[c], maxColor[c]);
+		}
+	}
+
+	for (int c = 0; c < 3; ++c) {
+		int inset = (maxColor[c] - minColor[c]) >> INSET_SHIFT;
+		minColor[c] += inset;
+		maxColor[c] -= inset;
+	}
+
+	// color0 > color1 selects the mode with four colors, equal endpoints leave all indices at color0
+	std::uint16_t color0 = packColor565(maxColor), color1 = packColor565(minColor);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	std::uint32_t indices = 0;
+	if (color0 != color1) {
+		int palette[4][3];
+		unpackColor565(color0, palette[0]);
+		unpackColor565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			int bestIndex = 0, bestDistance = INT_MAX;
+			for (int j = 0; j < 4; ++j) {
+				int distance = 0;
+				for (int c = 0; c < 3; ++c) {
+					int difference = int(texels[4 * i + c]) - palette[j][c];
+					distance += difference * difference;
+				}
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = j;
+				}
+			}
+			indices |= std::uint32_t(bestIndex) << (2 * i);
+		}
+	}
+
+	writeLittleEndian(color0, 2, block);
+	writeLittleEndian(color1, 2, block + 2);
+	writeLittleEndian(indices, 4, block + 4);
+}
+
+void CompressedTexture::encodeBC3Block(const std::uint8_t *texels, std::uint8_t *block)
+{
+	int minAlpha = 255, maxAlpha = 0;
+	for (int i = 0; i < 16; ++i) {
+		minAlpha = (std::min)(minAlpha, int(texels[4 * i + 3]));
+		maxAlpha = (std::max)(maxAlpha, int(texels[4 * i + 3]));
+	}
+
+	// alpha0 > alpha1 selects the mode with eight interpolated alphas, equal endpoints leave all indices at alpha0
+	std::uint64_t indices = 0;
+	if (maxAlpha != minAlpha) {
+		int palette[8];
+		palette[0] = maxAlpha;
+		palette[1] = minAlpha;
+		for (int j = 2; j < 8; ++j) {
+			palette[j] = ((8 - j) * maxAlpha + (j - 1) * minAlpha) / 7;
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			int bestIndex = 0, bestDistance = INT_MAX;
+			for (int j = 0; j < 8; ++j) {
+				int distance = std::abs(int(texels[4 * i + 3]) - palette[j]);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = j;
+				}
+			}
+			indices |= std::uint64_t(bestIndex) << (3 * i);
+		}
+	}
+
+	block[0] = std::uint8_t(maxAlpha);
+	block[1] = std::uint8_t(minAlpha);
+	writeLittleEndian(indices, 6, block + 2);
+	encodeBC1Block(texels, block + 8);
+}
+
+bool CompressedTexture::isValidHeader(const FileHeader &header, const std::string &imagePath)
+{
+	if (std::memcmp(header.magic, COMPRESSED_TEXTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION
+	        || header.width == 0 || header.height == 0) {
+		return false;
+	}
+
+	// the image may be left out of a release, then the compressed file is all there is
+	std::uint64_t sourceSize;
+	std::int64_t sourceModificationTime;
+	if (!MappedFile::getFileInfo(imagePath, sourceSize, sourceModificationTime)) {
+		return true;
+	}
+	return sourceSize == header.sourceSize && sourceModificationTime == header.sourceModificationTime;
+}
+
+size_t CompressedTexture::getLevelSize(Format format, unsigned int width, unsigned int height)
+{
+	size_t blockSize = format == BC3 ? 16 : 8;
+	return size_t((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+void CompressedTexture::encodeLevel(Format format, const std::vector<std::uint8_t> &texels, unsigned int width, unsigned int height, std::vector<std::uint8_t> &blocks)
+{
+	size_t blockSize = format == BC3 ? 16 : 8;
+	blocks.resize(getLevelSize(format, width, height));
+
+	// blocks reaching over the edge repeat the last row and column
+	std::uint8_t blockTexels[16 * 4];
+	size_t offset = 0;
+	for (unsigned int blockY = 0; blockY < height; blockY += 4) {
+		for (unsigned int blockX = 0; blockX < width; blockX += 4) {
+			for (unsigned int y = 0; y < 4; ++y) {
+				for (unsigned int x = 0; x < 4; ++x) {
+					unsigned int texelX = (std::min)(blockX + x, width - 1), texelY = (std::min)(blockY + y, height - 1);
+					std::memcpy(&blockTexels[4 * (4 * y + x)], &texels[(size_t(texelY) * width + texelX) * 4], 4);
+				}
+			}
+
+			if (format == BC3) {
+				encodeBC3Block(blockTexels, &blocks[offset]);
+			}
+			else {
+				encodeBC1Block(blockTexels, &blocks[offset]);
+			}
+			offset += blockSize;
+		}
+	}
+}
+
+void CompressedTexture::downsample(const std::vector<std::uint8_t> &texels, unsigned int width, unsigned int height, std::vector<std::uint8_t> &halved)
+{
+	unsigned int halvedWidth = (std::max)(width / 2, 1u), halvedHeight = (std::max)(height / 2, 1u);
+	halved.resize(size_t(halvedWidth) * halvedHeight * 4);
+
+	// average 2x2 texels, or 2x1 where a dimension is already 1
+	for (unsigned int y = 0; y < halvedHeight; ++y) {
+		unsigned int y0 = (std::min)(2 * y, height - 1), y1 = (std::min)(2 * y + 1, height - 1);
+		for (unsigned int x = 0; x < halvedWidth; ++x) {
+			unsigned int x0 = (std::min)(2 * x, width - 1), x1 = (std::min)(2 * x + 1, width - 1);
+			for (int c = 0; c < 4; ++c) {
+				int sum = texels[(size_t(y0) * width + x0) * 4 + c] + texels[(size_t(y0) * width + x1) * 4 + c]
+				        + texels[(size_t(y1) * width + x0) * 4 + c] + texels[(size_t(y1) * width + x1) * 4 + c];
+				halved[(size_t(y) * halvedWidth + x) * 4 + c] = std::uint8_t((sum + 2) / 4);
+			}
+		}
+	}
+}
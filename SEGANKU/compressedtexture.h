@@ -0,0 +1,162 @@
+#ifndef COMPRESSEDTEXTURE_H
+#define COMPRESSEDTEXTURE_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "assetpack.h"
+
+/**
+ * @brief A CompressedTexture is an image converted offline to a block compressed texture with its full mip chain,
+ * which is uploaded with glCompressedTexImage2D as it is instead of decoding the image and generating the mipmaps
+ * at every start. Opaque images are stored as BC1 (4 bits per texel), images with alpha as BC3 (8 bits per texel),
+ * compared to 24 or 32 bits per texel uncompressed. Both are encoded on the cpu, so baking needs no gpu.
+ * The compressed file is stored next to the image with the extension .ctex appended, or in the asset pack under that path.
+ * It remembers the size and modification time of the image it was baked from and is not used anymore once the image changes.
+ *
+ * layout: a FileHeader, a LevelRecord for every mip level from the full size down to 1x1, then the blocks of every level
+ * aligned to 16 bytes. The block rows start at the first row of the image like the rows passed to glTexImage2D.
+ */
+class CompressedTexture
+{
+public:
+
+	enum Format {
+		BC1 = 1,
+		BC3 = 2
+	};
+
+	/**
+	 * @brief a mip level of a loaded texture, the data points into the compressed file
+	 */
+	struct Level {
+		const char *data;
+		size_t size;
+		unsigned int width;
+		unsigned int height;
+	};
+
+	CompressedTexture();
+	~CompressedTexture();
+
+	/**
+	 * @brief get the path of the compressed file belonging to an image
+	 */
+	static std::string getCompressedPath(const std::string &imagePath);
+
+	/**
+	 * @brief check if the compressed file of an image exists and was baked from the current image.
+	 * if the image itself does not exist, every valid compressed file is up to date.
+	 */
+	static bool isUpToDate(const std::string &imagePath);
+
+	/**
+	 * @brief decode an image, build its mip chain, compress every level and write the compressed file
+	 * @param imagePath the image
+	 * @return false if the image could not be decoded or the compressed file could not be written
+	 */
+	static bool bake(const std::string &imagePath);
+
+	/**
+	 * @brief query if the opengl context can sample block compressed textures, to be called once on the context thread
+	 */
+	static void detectSupport();
+
+	/**
+	 * @brief check if compressed textures can be uploaded, false until detectSupport found them supported
+	 */
+	static bool isSupported();
+
+	/**
+	 * @brief map the compressed file of an image from the asset pack or the loose file, closing the texture loaded before
+	 * @param imagePath the image
+	 * @return false if there is no compressed file, it is out of date or damaged
+	 */
+	bool load(const std::string &imagePath);
+
+	/**
+	 * @brief release the compressed file, the levels become invalid
+	 */
+	void close();
+
+	Format getFormat() const;
+
+	/**
+	 * @brief get the opengl internal format of the blocks
+	 */
+	GLenum getGLFormat() const;
+
+	/**
+	 * @brief get the mip levels of the loaded texture, the full size first, valid until the texture is closed
+	 */
+	const std::vector<Level> &getLevels() const;
+
+	/**
+	 * @brief compress a 4x4 block of texels to 8 bytes of BC1
+	 * @param texels 16 texels of 4 bytes in rgba order, row by row
+	 * @param block is set to the compressed block
+	 */
+	static void encodeBC1Block(const std::uint8_t *texels, std::uint8_t *block);
+
+	/**
+	 * @brief compress a 4x4 block of texels to 16 bytes of BC3, the alpha block followed by the color block
+	 * @param texels 16 texels of 4 bytes in rgba order, row by row
+	 * @param block is set to the compressed block
+	 */
+	static void encodeBC3Block(const std::uint8_t *texels, std::uint8_t *block);
+
+private:
+	static const std::uint32_t VERSION = 1;
+	static const size_t ALIGNMENT = 16;
+
+	struct FileHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t format;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levelCount;
+		std::uint32_t reserved;
+		std::uint64_t sourceSize;
+		std::int64_t sourceModificationTime;
+	};
+
+	struct LevelRecord {
+		std::uint64_t offset;
+		std::uint64_t size;
+		std::uint32_t width;
+		std::uint32_t height;
+	};
+
+	Asset file;
+	Format format;
+	std::vector<Level> levels;
+
+	/**
+	 * @brief check if a header belongs to this version and to the current image
+	 */
+	static bool isValidHeader(const FileHeader &header, const std::string &imagePath);
+
+	/**
+	 * @brief get the size of a compressed level
+	 */
+	static size_t getLevelSize(Format format, unsigned int width, unsigned int height);
+
+	/**
+	 * @brief compress a level given as rgba texels
+	 * @param texels the level, width * height texels of 4 bytes in rgba order
+	 * @param blocks is set to the compressed level
+	 */
+	static void encodeLevel(Format format, const std::vector<std::uint8_t> &texels, unsigned int width, unsigned int height, std::vector<std::uint8_t> &blocks);
+
+	/**
+	 * @brief halve a level with a box filter, dimensions of 1 stay 1
+	 */
+	static void downsample(const std::vector<std::uint8_t> &texels, unsigned int width, unsigned int height, std::vector<std::uint8_t> &halved);
+};
+
+#endif // COMPRESSEDTEXTURE_H
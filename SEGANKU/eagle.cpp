@@ -31,7 +31,7 @@ void Eagle::update(float timeDelta, const glm::vec3 &targetPos_, bool targetHidd
 
 		if (!targetHidden && timeSinceLastAttack > timeIntervalToNextAttack) {
 			timeSinceLastAttack = 0;
-			int t = (float)rand()/RAND_MAX;
+			float t = randDistribution(randGen);
 			timeIntervalToNextAttack = t * ATTACK_WAIT_TIME_MIN + (1-t) * ATTACK_WAIT_TIME_MAX;
 			state = ATTACKING;
 		}
@@ -105,3 +105,8 @@ void Eagle::resetEagle()
 	targetDefenseActive = false;
 }
 
+void Eagle::seedRandom(unsigned int seed)
+{
+	randGen.seed(seed);
+}
+
@@ -6,6 +6,7 @@
 
 #include <btBulletDynamicsCommon.h>
 #include <glm/gtx/vector_angle.hpp>
+#include <random>
 #include "geometry.h"
 
 enum EagleState
@@ -41,6 +42,10 @@ class Eagle : public Geometry
 	bool targetHidden = false;
 	bool targetDefenseActive = false;
 
+	// each eagle has its own random generator, so independent games can run in parallel and be reproduced
+	std::mt19937 randGen;
+	std::uniform_real_distribution<float> randDistribution = std::uniform_real_distribution<float>(0.0f, 1.0f);
+
 
 public:
 	Eagle(const glm::mat4 &matrix, const std::string &filePath);
@@ -68,6 +73,12 @@ public:
 
 	void resetEagle();
 
+	/**
+	 * @brief seed the random generator deciding when the eagle attacks
+	 * @param seed the seed
+	 */
+	void seedRandom(unsigned int seed);
+
 private:
 };
 
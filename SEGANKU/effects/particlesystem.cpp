@@ -1,4 +1,5 @@
 #include "particlesystem.h"
+#include "../geometry.h"
 
 // vertex positions and uvs defining a quad, used to render particles.
 static const GLfloat quadVertices[] = {
@@ -12,6 +13,9 @@ static const GLfloat quadVertices[] = {
      1.0f,  1.0f,  1.0f, 1.0f
 };
 
+// the minimal number of particles simulated by one job, smaller systems are not worth distributing
+static const size_t PARTICLES_PER_JOB = 256;
+
 /**
  * used to sort vector of shared_ptr by their pointed values of type T
  */
@@ -30,15 +34,20 @@ ParticleSystem::ParticleSystem(const glm::mat4 &matrix_, const std::string &text
     , gravity(gravity_)
 {
 
+	// without an opengl context the particles are only simulated
+	if (!GLState::contextAvailable) {
+		return;
+	}
+
 	particleShader = new Shader("../SEGANKU/shaders/particles.vert", "../SEGANKU/shaders/particles.frag");
-	particleTexture = new Texture(texturePath, true);
-	std::cout << "loaded texture: " << texturePath << std::endl;
+	// the smoke is first seen when the defense is activated, so its texture may stream in while the game runs
+	particleTexture = Geometry::requestTexture(texturePath, true);
 
 
 	// generate vertex array object (vao) bindings. the vao simply stores the state of the subsequent bindings
 	// so that they can be reactived quickly later, instead of doing it all over again
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	GLState::bindVertexArray(vao);
 
 
 	// setup particle quad vertices buffer (shared among all particles using instancing)
@@ -68,50 +77,75 @@ ParticleSystem::ParticleSystem(const glm::mat4 &matrix_, const std::string &text
 	glBindBuffer(GL_ARRAY_BUFFER, particleInstanceDataVBO);
 	glVertexAttribPointer(particleInstanceDataAttribIndex, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0); // 4 elements (xyz + size)
 
+	// the attrib divisors are part of the vao state, so they only need to be set once here.
+	// the divisor defines after how many drawn instances the attribute advances (0 = never).
+	glVertexAttribDivisor(particleQuadVerticesAttribIndex, 0); // quad vertex buffer              (always use same vertices)
+	glVertexAttribDivisor(particleInstanceDataAttribIndex, 1); // particle instance data buffer   (advance for each instance)
+
 
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 }
 
 ParticleSystem::~ParticleSystem()
 {
+	if (!particleShader) {
+		return; // gl resources were never created
+	}
+
 	glDeleteBuffers(1, &particleQuadVBO);
 	glDeleteBuffers(1, &particleInstanceDataVBO);
+	glDeleteVertexArrays(1, &vao);
+	GLState::invalidate();
 
 	delete particleShader;
-	delete particleTexture;
 }
 
-void ParticleSystem::draw(const glm::mat4 &viewMat, const glm::mat4 &projMat, const glm::vec3 &color)
+void ParticleSystem::draw(const glm::vec3 &color)
+{
+	draw(color, getMatrix(), particleInstanceData);
+}
+
+void ParticleSystem::draw(const glm::vec3 &color, const glm::mat4 &modelMat, const std::vector<float> &instanceData)
 {
 
 	particleShader->useShader();
 
-	// pass matrices to shader
-	GLint modelViewMatLocation = glGetUniformLocation(particleShader->programHandle, "modelViewMat"); // get uniform location in shader
-	glUniformMatrix4fv(modelViewMatLocation, 1, GL_FALSE, glm::value_ptr(viewMat * getMatrix())); // shader location, count, transpose?, value pointer
-	GLint projMatLocation = glGetUniformLocation(particleShader->programHandle, "projMat");
-	glUniformMatrix4fv(projMatLocation, 1, GL_FALSE, glm::value_ptr(projMat));
+	// UPDATE BUFFER
+
+	// note about buffer updates when streaming:
+	// when streaming (i.e. alternately writing and reading frequently) the GL implementation
+	// might delay buffer write operations until it has finished all draw calls from that buffer.
+	// to avoid such lockdowns, buffer respecification ('orphaning') can be used,
+	// whereby glBufferData is called with NULL data pointer and same other arguments as initially.
+	// most implementations will then allocate a new memory block and bind it to the buffer handle
+	// while still using the old memory block for drawing, until all drawing has been completed.
+
+	// update particle instance data
+	glBindBuffer(GL_ARRAY_BUFFER, particleInstanceDataVBO);
+	glBufferData(GL_ARRAY_BUFFER, maxParticleCount * 4 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(GLfloat), instanceData.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// pass model matrix to shader (view and projection matrix are part of the FrameData block)
+	particleShader->modelMat.set(modelMat);
 
 	// pass texture to shader
-	GLint particleTexLocation = glGetUniformLocation(particleShader->programHandle, "particleTexture"); // get uniform location in shader
-	glUniform1i(particleTexLocation, 0); // bind shader texture location with texture unit 0
-	particleTexture->bind(0); // activate texture unit 0 and bind texture to it
+	// unit 3 has no sampler bound, so the texture is sampled with its own filter parameters
+	particleShader->uniform("particleTexture").set(3); // bind shader texture location with texture unit 3
+	particleTexture->bind(3); // activate texture unit 3 and bind texture to it
 
 	// pass color
-	glUniform3f(glGetUniformLocation(particleShader->programHandle, "color"), color.x, color.y, color.z);
+	particleShader->uniform("color").set(color);
 
 
 	// for instanced drawing we use glDrawArraysInstanced, which behaves like glDrawArrays,
 	// but also advances the used buffer attributes after a given number of drawn instances,
-	// depending on the glVertexAttribDivisor value assigned for that buffer,
+	// depending on the glVertexAttribDivisor value assigned for that buffer (stored in the vao),
 	// which divides the instances into the number of different attributes to be assigned.
-	glBindVertexArray(vao);
-	glVertexAttribDivisor(0, 0); // quad vertex buffer              (always use same vertices)
-	glVertexAttribDivisor(1, 1); // particle instance data buffer   (advance for each instance)
-	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, particles.size()); // mode, first index, last index, instance count
-	glBindVertexArray(0);
+	GLState::bindVertexArray(vao);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instanceData.size() / 4); // mode, first index, last index, instance count
 
 
 }
@@ -144,32 +178,45 @@ void ParticleSystem::update(float timeDelta, const glm::mat4 &viewMat)
 
 	glm::mat4 modelViewMat = viewMat * getMatrix();
 
-	for (unsigned int i = 0; i < particles.size(); ++i) {
-		std::shared_ptr<Particle> particle = particles[i];
+	// particles are independent of each other, so ranges of them can be simulated in parallel
+	auto simulate = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			Particle *particle = particles[i].get();
 
-		particle->timeToLive -= timeDelta;
-		if (particle->timeToLive < 0) {
-			particles.erase(particles.begin()+i);
-			continue;
-		}
+			particle->timeToLive -= timeDelta;
+			if (particle->timeToLive < 0) {
+				continue; // removed below
+			}
 
-		// simulate gravitational acceleration
-		particle->velocity += glm::vec3(0.0f, -9.81f, 0.0f) * timeDelta * gravity;
-		particle->pos += particle->velocity * timeDelta;
+			// simulate gravitational acceleration
+			particle->velocity += glm::vec3(0.0f, -9.81f, 0.0f) * timeDelta * gravity;
+			particle->pos += particle->velocity * timeDelta;
 
-		// particle depth for sorting to draw with alpha
-		glm::vec3 particleViewPos = glm::vec3(modelViewMat * glm::vec4(particle->pos.x, particle->pos.y, particle->pos.z, 1));
-		particle->viewDepth = -particleViewPos.z;
+			// particle depth for sorting to draw with alpha
+			glm::vec3 particleViewPos = glm::vec3(modelViewMat * glm::vec4(particle->pos.x, particle->pos.y, particle->pos.z, 1));
+			particle->viewDepth = -particleViewPos.z;
+		}
+	};
 
+	if (jobs) {
+		jobs->parallelFor(0, particles.size(), PARTICLES_PER_JOB, simulate);
+	}
+	else {
+		simulate(0, particles.size());
 	}
 
+	// remove dead particles
+	particles.erase(std::remove_if(particles.begin(), particles.end(), [](const std::shared_ptr<Particle> &particle) {
+		return particle->timeToLive < 0;
+	}), particles.end());
+
 	// sort in back to front drawing order.
 	// this is needed for alpha blending since zbuffer test rejects fragments that lie behind,
 	// but their color data is needed for blending.
 	std::sort(particles.begin(), particles.end(), SortSharedPtr<Particle>());
 
 	// fill array to pass to particle instance data buffer
-	std::vector<float> particleInstanceData;
+	particleInstanceData.clear();
 	for (unsigned int i = 0; i < particles.size(); ++i) {
 		std::shared_ptr<Particle> particle = particles[i];
 
@@ -179,22 +226,6 @@ void ParticleSystem::update(float timeDelta, const glm::mat4 &viewMat)
 		particleInstanceData.push_back(particle->timeToLive / timeToLive);
 	}
 
-	// UPDATE BUFFER
-
-	// note about buffer updates when streaming:
-	// when streaming (i.e. alternately writing and reading frequently) the GL implementation
-	// might delay buffer write operations until it has finished all draw calls from that buffer.
-	// to avoid such lockdowns, buffer respecification ('orphaning') can be used,
-	// whereby glBufferData is called with NULL data pointer and same other arguments as initially.
-	// most implementations will then allocate a new memory block and bind it to the buffer handle
-	// while still using the old memory block for drawing, until all drawing has been completed.
-
-	// update particle instance data
-	glBindBuffer(GL_ARRAY_BUFFER, particleInstanceDataVBO);
-	glBufferData(GL_ARRAY_BUFFER, maxParticleCount * 4 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, particleInstanceData.size() * sizeof(GLfloat), &particleInstanceData[0]);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
 }
 
 void ParticleSystem::respawn(glm::vec3 location)
@@ -205,7 +236,22 @@ void ParticleSystem::respawn(glm::vec3 location)
 	spawningPaused = false;
 }
 
+const std::vector<float> &ParticleSystem::getInstanceData() const
+{
+	return particleInstanceData;
+}
+
+void ParticleSystem::setJobSystem(JobSystem *jobs_)
+{
+	jobs = jobs_;
+}
+
+void ParticleSystem::seedRandom(unsigned int seed)
+{
+	randGen.seed(seed);
+}
+
 float ParticleSystem::randomFloat()
 {
-	return (float)rand()/RAND_MAX;
+	return randDistribution(randGen);
 }
@@ -8,10 +8,13 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <random>
 
 #include "../sceneobject.h"
 #include "../shader.h"
 #include "../texture.h"
+#include "../glstate.h"
+#include "../jobsystem.h"
 
 struct Particle
 {
@@ -36,7 +39,7 @@ class ParticleSystem : SceneObject
 	GLuint particleInstanceDataVBO;
 
 	Shader *particleShader = nullptr;
-	Texture *particleTexture = nullptr;
+	std::shared_ptr<Texture> particleTexture;
 
 	unsigned int maxParticleCount = 1000;  // maximum total particle count
 	bool spawningPaused = true;
@@ -47,6 +50,16 @@ class ParticleSystem : SceneObject
 
 	std::vector<std::shared_ptr<Particle>> particles;
 
+	// sorted particle positions and remaining lifetimes, uploaded to the instance data buffer on draw
+	std::vector<float> particleInstanceData;
+
+	// each particle system has its own random generator, so independent games can run in parallel
+	std::mt19937 randGen;
+	std::uniform_real_distribution<float> randDistribution = std::uniform_real_distribution<float>(0.0f, 1.0f);
+
+	// simulates the particles in parallel if set
+	JobSystem *jobs = nullptr;
+
 public:
 
 	ParticleSystem(const glm::mat4 &matrix_, const std::string &texturePath, int maxParticleCount_, float spawnRate_, float timeToLive_, float gravity_);
@@ -59,15 +72,44 @@ public:
 	void update(float timeDelta, const glm::mat4 &viewMat);
 
 	/**
-	 * @brief draw the particles in the particle system
+	 * @brief draw the particles in the particle system.
+	 * the view and projection matrices are read from the FrameData uniform block.
+	 */
+	void draw(const glm::vec3 &color);
+
+	/**
+	 * @brief draw particles captured before instead of the current ones,
+	 * e.g. when the particle system is updated on another thread.
+	 * @param modelMat the model matrix of the particle system, see getMatrix
+	 * @param instanceData the particle instance data, see getInstanceData
+	 */
+	void draw(const glm::vec3 &color, const glm::mat4 &modelMat, const std::vector<float> &instanceData);
+
+	/**
+	 * @brief get the sorted particle positions and remaining lifetimes, 4 floats per particle
+	 * @return the particle instance data of the last update
 	 */
-	void draw(const glm::mat4 &viewMat, const glm::mat4 &projMat, const glm::vec3 &color);
+	const std::vector<float> &getInstanceData() const;
+
+	using SceneObject::getMatrix;
 
 	/**
 	 * @brief clear all particles and reinitiate spawning
 	 */
 	void respawn(glm::vec3 location);
 
+	/**
+	 * @brief simulate the particles on the given job system instead of the calling thread
+	 * @param jobs_ the job system to use, or nullptr to simulate on the calling thread
+	 */
+	void setJobSystem(JobSystem *jobs_);
+
+	/**
+	 * @brief seed the random generator used to spawn particles
+	 * @param seed the seed
+	 */
+	void seedRandom(unsigned int seed);
+
 private:
 
 	/**
@@ -23,7 +23,7 @@ SSAOPostprocessor::SSAOPostprocessor(int windowWidth, int windowHeight, int samp
 
     glGenVertexArrays(1, &screenQuadVAO);
     glGenBuffers(1, &screenQuadVBO);
-    glBindVertexArray(screenQuadVAO);
+    GLState::bindVertexArray(screenQuadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, screenQuadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 	GLint positionAttribIndex   = 0;
@@ -32,7 +32,7 @@ SSAOPostprocessor::SSAOPostprocessor(int windowWidth, int windowHeight, int samp
 	glEnableVertexAttribArray(uvsAttribIndex);
     glVertexAttribPointer(positionAttribIndex, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
     glVertexAttribPointer(uvsAttribIndex, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 
 
 	////////////////////////////////////
@@ -85,7 +85,7 @@ SSAOPostprocessor::SSAOPostprocessor(int windowWidth, int windowHeight, int samp
 
 SSAOPostprocessor::~SSAOPostprocessor()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 
 	glDeleteFramebuffers(1, &fboScreenData);
 	glDeleteTextures(1, &screenColorTexture);
@@ -101,6 +101,8 @@ SSAOPostprocessor::~SSAOPostprocessor()
 	delete ssaoShader; ssaoShader = nullptr;
 	delete blurShader; blurShader = nullptr;
 
+	// deleted objects might still be cached as bound
+	GLState::invalidate();
 }
 
 void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
@@ -114,11 +116,13 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 	glDeleteFramebuffers(1, &fboSSAO);
 	glDeleteTextures(1, &ssaoTexture);
 
+	// deleted objects might still be cached as bound
+	GLState::invalidate();
 
 	// generate screen color texture
 	// note: GL_NEAREST interpolation is ok since there is no subpixel sampling anyway
 	glGenTextures(1, &screenColorTexture);
-	glBindTexture(GL_TEXTURE_2D, screenColorTexture);
+	GLState::bindTexture(0, screenColorTexture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -127,7 +131,7 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 
 	// generate vertex view space position texture
 	glGenTextures(1, &viewPosTexture);
-	glBindTexture(GL_TEXTURE_2D, viewPosTexture);
+	GLState::bindTexture(0, viewPosTexture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -142,7 +146,7 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 
 	// generate framebuffer to attach color texture + view space positions texture + depth renderbuffer
 	glGenFramebuffers(1, &fboScreenData); // generate framebuffer object layout in vram and associate handle
-	glBindFramebuffer(GL_FRAMEBUFFER, fboScreenData); // bind fbo to active framebuffer
+	GLState::bindFramebuffer(fboScreenData); // bind fbo to active framebuffer
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenColorTexture, 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, viewPosTexture, 0);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, screenDepthBuffer);
@@ -153,7 +157,7 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 
 	// generate ssao texture
 	glGenTextures(1, &ssaoTexture);
-	glBindTexture(GL_TEXTURE_2D, ssaoTexture);
+	GLState::bindTexture(0, ssaoTexture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -162,7 +166,7 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 
 	// generate framebuffer to attach ssao texture
 	glGenFramebuffers(1, &fboSSAO); // generate framebuffer object layout in vram and associate handle
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAO); // bind fbo to active framebuffer
+	GLState::bindFramebuffer(fboSSAO); // bind fbo to active framebuffer
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoTexture, 0);
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
 		std::cerr << "ERROR in SSAOPostprocessor: SSAO Framebuffer not complete" << std::endl;
@@ -171,8 +175,8 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 	// fbo for blurred ssao
 	glGenFramebuffers(1, &fboSSAOBlurPingpong);
 	glGenTextures(1, &ssaoBlurredTexturePingpong);
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAOBlurPingpong);
-	glBindTexture(GL_TEXTURE_2D, ssaoBlurredTexturePingpong);
+	GLState::bindFramebuffer(fboSSAOBlurPingpong);
+	GLState::bindTexture(0, ssaoBlurredTexturePingpong);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, windowWidth, windowHeight, 0, GL_RED, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -183,38 +187,32 @@ void SSAOPostprocessor::setupFramebuffers(int windowWidth, int windowHeight)
 
 
 	// bind back to default framebuffer (as created by glfw)
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 
 }
 
 void SSAOPostprocessor::bindScreenDataFramebuffer()
 {
-	glEnable(GL_DEPTH_TEST);
-	glBindFramebuffer(GL_FRAMEBUFFER, fboScreenData);
+	GLState::setDepthTest(true);
+	GLState::bindFramebuffer(fboScreenData);
 	GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 }; // shader output locations
 	glDrawBuffers(2, buffers);
 }
 
-void SSAOPostprocessor::calulateSSAOValues(const glm::mat4 &projMat)
+void SSAOPostprocessor::calulateSSAOValues()
 {
 	ssaoShader->useShader();
 
-	glUniformMatrix4fv(glGetUniformLocation(ssaoShader->programHandle, "projMat"), 1, GL_FALSE, glm::value_ptr(projMat));
+	ssaoShader->uniform("random_vector_array_size").set(samples);
 
-	GLint sampleCountLocation = glGetUniformLocation(ssaoShader->programHandle, "random_vector_array_size");
-	glUniform1i(sampleCountLocation, samples);
+	ssaoShader->uniform("viewPosTexture").set(4); // bind shader location to texture unit 4
+	GLState::bindTexture(4, viewPosTexture); // bind texture to texture unit 4
 
-	GLint viewPosTexLocation = glGetUniformLocation(ssaoShader->programHandle, "viewPosTexture");
-	glBindFramebuffer(GL_FRAMEBUFFER, fboScreenData);
-	glUniform1i(viewPosTexLocation, 4); // bind shader location to texture unit 4
-	glActiveTexture(GL_TEXTURE0 + 4); // activate texture unit 4
-	glBindTexture(GL_TEXTURE_2D, viewPosTexture); // bind texture to active texture unit
-
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAO);
+	GLState::bindFramebuffer(fboSSAO);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	drawQuad();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 void SSAOPostprocessor::blurSSAOResultTexture()
@@ -222,40 +220,34 @@ void SSAOPostprocessor::blurSSAOResultTexture()
 	blurShader->useShader();
 
 	// filter horizontally
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAOBlurPingpong);
-	glUniform1i(glGetUniformLocation(blurShader->programHandle, "ssaoTexture"), 4);
-	glActiveTexture(GL_TEXTURE0 + 4);
-	glBindTexture(GL_TEXTURE_2D, ssaoTexture);
-	glUniform1i(glGetUniformLocation(blurShader->programHandle, "filterHorizontally"), true);
+	GLState::bindFramebuffer(fboSSAOBlurPingpong);
+	blurShader->uniform("ssaoTexture").set(4);
+	GLState::bindTexture(4, ssaoTexture);
+	blurShader->uniform("filterHorizontally").set(true);
 
 	drawQuad();
 
 	// filter vertically
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAO);
-	glUniform1i(glGetUniformLocation(blurShader->programHandle, "ssaoTexture"), 4);
-	glActiveTexture(GL_TEXTURE0 + 4);
-	glBindTexture(GL_TEXTURE_2D, ssaoBlurredTexturePingpong);
-	glUniform1i(glGetUniformLocation(blurShader->programHandle, "filterHorizontally"), false);
+	GLState::bindFramebuffer(fboSSAO);
+	blurShader->uniform("ssaoTexture").set(4);
+	GLState::bindTexture(4, ssaoBlurredTexturePingpong);
+	blurShader->uniform("filterHorizontally").set(false);
 
 	drawQuad();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
-void SSAOPostprocessor::bindSSAOResultTexture(GLint ssaoTexShaderLocation, GLuint textureUnit)
+void SSAOPostprocessor::bindSSAOResultTexture(const Shader::Uniform &ssaoTexUniform, GLuint textureUnit)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, fboSSAO);
-	glUniform1i(ssaoTexShaderLocation, textureUnit);
-	glActiveTexture(GL_TEXTURE0 + textureUnit);
-	glBindTexture(GL_TEXTURE_2D, ssaoTexture);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	ssaoTexUniform.set(textureUnit);
+	GLState::bindTexture(textureUnit, ssaoTexture);
 }
 
 void SSAOPostprocessor::drawQuad()
 {
-	glDisable(GL_DEPTH_TEST); // no need for depth testing since we just draw a single quad
-	glBindVertexArray(screenQuadVAO);
+	GLState::setDepthTest(false); // no need for depth testing since we just draw a single quad
+	GLState::bindVertexArray(screenQuadVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
-	glBindVertexArray(0);
-	glEnable(GL_DEPTH_TEST); // reenable depth testing
+	GLState::setDepthTest(true); // reenable depth testing
 }
@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "../shader.h"
+#include "../glstate.h"
 
 /**
  * @brief The SSAOPostprocessor class facilitates Screen Space Ambient Occlusion
@@ -58,19 +59,19 @@ public:
 
 	/**
 	 * @brief calulate the resulting ssao factors for each fragment
-	 * and store it in a texture attached to the fboSSAO
-	 * @param projMat the projection matrix to use in the render pipeline
+	 * and store it in a texture attached to the fboSSAO.
+	 * the projection matrix is read from the FrameData uniform block.
 	 * this needs certain information rendered to textures after binding via the bindScreenDataFramebuffer.
 	 */
-	void calulateSSAOValues(const glm::mat4 &projMat);
+	void calulateSSAOValues();
 
 	/**
 	 * @brief bind the texture which stores the ssao results after calulateSSAOValues
-	 * to given shader locaton and texture unit
-	 * @param ssaoTexShaderLocation the shader location
+	 * to given shader uniform and texture unit
+	 * @param ssaoTexUniform the shader uniform
 	 * @param textureUnit the texture unit
 	 */
-	void bindSSAOResultTexture(GLint ssaoTexShaderLocation, GLuint textureUnit);
+	void bindSSAOResultTexture(const Shader::Uniform &ssaoTexUniform, GLuint textureUnit);
 
 	void blurSSAOResultTexture();
 
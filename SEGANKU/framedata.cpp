@@ -0,0 +1,43 @@
+#include "framedata.h"
+
+FrameData::FrameData()
+{
+	// reserve buffer memory for the block, data is assigned each frame.
+	// DYNAMIC usage hint is given since the data is modified once per frame and used many times.
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// bind the whole buffer to the binding point, shaders bind their block to it after linking
+	glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, ubo);
+}
+
+FrameData::~FrameData()
+{
+	glDeleteBuffers(1, &ubo);
+}
+
+void FrameData::setCamera(const glm::mat4 &viewMat, const glm::mat4 &projMat, const glm::vec3 &cameraPos)
+{
+	block.viewProjMat = projMat * viewMat;
+	block.viewMat = viewMat;
+	block.projMat = projMat;
+	block.cameraPos = glm::vec4(cameraPos, 1);
+}
+
+void FrameData::setLight(const glm::mat4 &lightVP, const glm::vec3 &position, const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular)
+{
+	block.lightVP = lightVP;
+	block.lightPosition = glm::vec4(position, 1);
+	block.lightAmbient = glm::vec4(ambient, 0);
+	block.lightDiffuse = glm::vec4(diffuse, 0);
+	block.lightSpecular = glm::vec4(specular, 0);
+}
+
+void FrameData::upload()
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,72 @@
+#ifndef FRAMEDATA_H
+#define FRAMEDATA_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/**
+ * @brief The FrameData class stores the camera, light and shadow data of a frame
+ * in a uniform buffer object that is bound to a fixed binding point.
+ * all shaders declaring the std140 uniform block "FrameData" read it from there,
+ * so the data is uploaded once per frame instead of once per shader and pass.
+ */
+class FrameData
+{
+	/**
+	 * @brief memory layout of the FrameData uniform block (std140).
+	 * vec3 members are padded to 16 bytes, so glm::vec4 is used with unused w.
+	 * must match the block declaration in the shaders.
+	 */
+	struct Block {
+		glm::mat4 viewProjMat;
+		glm::mat4 viewMat;
+		glm::mat4 projMat;
+		glm::mat4 lightVP;
+		glm::vec4 cameraPos;
+		glm::vec4 lightPosition;
+		glm::vec4 lightAmbient;
+		glm::vec4 lightDiffuse;
+		glm::vec4 lightSpecular;
+	};
+
+	Block block;
+	GLuint ubo;
+
+public:
+	// the uniform buffer binding point of the FrameData block (0 is used by the ssao random vectors)
+	static const GLuint BINDING_POINT = 1;
+
+	FrameData();
+	~FrameData();
+
+	/**
+	 * @brief set the camera matrices and position
+	 * @param viewMat the view matrix
+	 * @param projMat the projection matrix
+	 * @param cameraPos the camera position in world space
+	 */
+	void setCamera(const glm::mat4 &viewMat, const glm::mat4 &projMat, const glm::vec3 &cameraPos);
+
+	/**
+	 * @brief set the light and shadow data
+	 * @param lightVP the view projection matrix of the light used for shadow mapping
+	 * @param position the light position in world space
+	 * @param ambient the ambient light color
+	 * @param diffuse the diffuse light color
+	 * @param specular the specular light color
+	 */
+	void setLight(const glm::mat4 &lightVP, const glm::vec3 &position, const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular);
+
+	/**
+	 * @brief copy the data set for this frame to the uniform buffer.
+	 * call once per frame after setting the data and before drawing.
+	 */
+	void upload();
+
+};
+
+#endif // FRAMEDATA_H
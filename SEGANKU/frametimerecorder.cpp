@@ -0,0 +1,155 @@
+#include "frametimerecorder.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+FrameTimeRecorder::FrameTimeRecorder(int capacity_, double budget_)
+	: capacity((std::max)(capacity_, 1))
+	, budget(budget_)
+{
+	frames.reserve(capacity);
+}
+
+void FrameTimeRecorder::recordFrame(double frameTime, const Profiler &profiler, const std::string &settings)
+{
+	// the slots of the ring buffer are reused, so their phase vectors keep their memory
+	if (int(frames.size()) < capacity) {
+		frames.push_back(Frame());
+	}
+	Frame &frame = frames[nextFrame];
+	nextFrame = (nextFrame + 1) % capacity;
+
+	frame.index = frameIndex++;
+	frame.time = frameTime;
+
+	std::vector<std::string>::iterator settingsName = std::find(settingsNames.begin(), settingsNames.end(), settings);
+	frame.settings = int(settingsName - settingsNames.begin());
+	if (settingsName == settingsNames.end()) {
+		settingsNames.push_back(settings);
+	}
+
+	frame.phaseTimes.resize(profiler.getPhaseCount());
+	for (int i = 0; i < profiler.getPhaseCount(); ++i) {
+		frame.phaseTimes[i] = profiler.getFrameCpuTime(i);
+	}
+
+	// report stutters, frames that are not only over budget but also much slower than usual
+	if (frameTime > budget && frameTime > 2 * calculatePercentiles().p50) {
+		std::ostringstream breakdown;
+		breakdown << std::fixed << std::setprecision(2);
+		for (int i = 0; i < profiler.getPhaseCount(); ++i) {
+			if (frame.phaseTimes[i] > 0) {
+				breakdown << ", " << profiler.getPhaseName(i) << " " << frame.phaseTimes[i];
+			}
+		}
+		std::cout << "STUTTER: frame " << frame.index << " took " << std::fixed << std::setprecision(2) << frameTime
+		          << " ms (budget " << budget << " ms" << breakdown.str() << ")" << std::endl;
+	}
+}
+
+FrameTimeRecorder::Percentiles FrameTimeRecorder::calculatePercentiles() const
+{
+	Percentiles percentiles;
+	if (frames.empty()) {
+		return percentiles;
+	}
+
+	std::vector<double> times(frames.size());
+	for (size_t i = 0; i < frames.size(); ++i) {
+		times[i] = frames[i].time;
+	}
+
+	// nearest rank percentiles, each nth_element only reorders the part not yet partitioned
+	size_t last = times.size() - 1;
+	size_t ranks[3] = { last * 50 / 100, last * 95 / 100, last * 99 / 100 };
+	double *results[3] = { &percentiles.p50, &percentiles.p95, &percentiles.p99 };
+	std::vector<double>::iterator begin = times.begin();
+	for (int i = 0; i < 3; ++i) {
+		std::nth_element(begin, times.begin() + ranks[i], times.end());
+		*results[i] = times[ranks[i]];
+		begin = times.begin() + ranks[i];
+	}
+	percentiles.max = *std::max_element(begin, times.end());
+
+	return percentiles;
+}
+
+double FrameTimeRecorder::calculateAverage() const
+{
+	if (frames.empty()) {
+		return 0;
+	}
+
+	double sum = 0;
+	for (const Frame &frame : frames) {
+		sum += frame.time;
+	}
+	return sum / frames.size();
+}
+
+int FrameTimeRecorder::getOverBudgetCount() const
+{
+	int count = 0;
+	for (const Frame &frame : frames) {
+		if (frame.time > budget) {
+			++count;
+		}
+	}
+	return count;
+}
+
+int FrameTimeRecorder::getFrameCount() const
+{
+	return int(frames.size());
+}
+
+double FrameTimeRecorder::getBudget() const
+{
+	return budget;
+}
+
+bool FrameTimeRecorder::writeCsv(const std::string &filePath, const Profiler &profiler) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		std::cerr << "ERROR: Could not write frame times to " << filePath << std::endl;
+		return false;
+	}
+
+	file << "frame,time_ms,over_budget,settings";
+	for (int i = 0; i < profiler.getPhaseCount(); ++i) {
+		file << ',' << profiler.getPhaseName(i);
+	}
+	file << '\n';
+
+	for (const Frame *frame : getOrderedFrames()) {
+		file << frame->index << ',' << frame->time << ',' << (frame->time > budget) << ',' << settingsNames[frame->settings];
+		// phases that first appeared after the frame was recorded were not measured in it
+		for (int i = 0; i < profiler.getPhaseCount(); ++i) {
+			file << ',' << (i < int(frame->phaseTimes.size()) ? frame->phaseTimes[i] : 0.0);
+		}
+		file << '\n';
+	}
+
+	Percentiles percentiles = calculatePercentiles();
+	std::cout << "wrote " << frames.size() << " frame times to " << filePath << " (p50: " << percentiles.p50
+	          << " ms, p95: " << percentiles.p95 << " ms, p99: " << percentiles.p99 << " ms, max: " << percentiles.max
+	          << " ms, over budget: " << getOverBudgetCount() << ")" << std::endl;
+	return true;
+}
+
+std::vector<const FrameTimeRecorder::Frame*> FrameTimeRecorder::getOrderedFrames() const
+{
+	std::vector<const Frame*> orderedFrames;
+	orderedFrames.reserve(frames.size());
+
+	// once the ring buffer is full, the oldest frame is the one overwritten next
+	int oldest = (int(frames.size()) < capacity) ? 0 : nextFrame;
+	for (size_t i = 0; i < frames.size(); ++i) {
+		orderedFrames.push_back(&frames[(oldest + i) % frames.size()]);
+	}
+	return orderedFrames;
+}
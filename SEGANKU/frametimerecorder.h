@@ -0,0 +1,94 @@
+#ifndef FRAMETIMERECORDER_H
+#define FRAMETIMERECORDER_H
+
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+/**
+ * @brief The FrameTimeRecorder keeps the times of the last frames together with the cpu time of their
+ * profiled phases and the render settings they were drawn with.
+ * From these it calculates frame time percentiles, which show hitches the average or the fps of the
+ * last frame hide. Frames taking longer than the budget are flagged, and stutters (frames over budget
+ * and over twice the median) are reported with their phase breakdown as they happen.
+ * Everything recorded can be written to a csv file, to compare builds and settings.
+ */
+class FrameTimeRecorder
+{
+public:
+	struct Percentiles {
+		double p50 = 0;
+		double p95 = 0;
+		double p99 = 0;
+		double max = 0;
+	};
+
+	/**
+	 * @param capacity_ the number of frames kept, older frames are overwritten
+	 * @param budget_ the time in ms a frame may take, e.g. 16.7 for 60 fps
+	 */
+	FrameTimeRecorder(int capacity_, double budget_);
+
+	/**
+	 * @brief record a frame, call after the frame has been drawn and before the profiler begins the next one
+	 * @param frameTime the time of the frame in ms
+	 * @param profiler the profiler holding the phase times of the frame
+	 * @param settings a short description of the render settings the frame was drawn with
+	 */
+	void recordFrame(double frameTime, const Profiler &profiler, const std::string &settings);
+
+	/**
+	 * @brief calculate the frame time percentiles of the recorded frames
+	 */
+	Percentiles calculatePercentiles() const;
+
+	/**
+	 * @brief calculate the mean frame time of the recorded frames
+	 */
+	double calculateAverage() const;
+
+	/**
+	 * @return the number of recorded frames that took longer than the budget
+	 */
+	int getOverBudgetCount() const;
+
+	/**
+	 * @return the number of recorded frames, at most the capacity
+	 */
+	int getFrameCount() const;
+
+	double getBudget() const;
+
+	/**
+	 * @brief write all recorded frames to a csv file, one row per frame with the time of every phase
+	 * @param filePath the file to write to
+	 * @param profiler the profiler the frames were recorded with, for the phase names
+	 * @return false if the file could not be written
+	 */
+	bool writeCsv(const std::string &filePath, const Profiler &profiler) const;
+
+private:
+	struct Frame {
+		unsigned long long index;
+		double time;
+		int settings;                 // index into settingsNames
+		std::vector<double> phaseTimes; // cpu time of every profiler phase, by phase index
+	};
+
+	int capacity;
+	double budget;
+
+	std::vector<Frame> frames;  // ring buffer
+	int nextFrame = 0;
+	unsigned long long frameIndex = 0;
+
+	std::vector<std::string> settingsNames;
+
+	/**
+	 * @brief get the recorded frames from the oldest to the newest
+	 */
+	std::vector<const Frame*> getOrderedFrames() const;
+};
+
+#endif // FRAMETIMERECORDER_H
@@ -0,0 +1,412 @@
+#include "gameworld.h"
+
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <random>
+#include <functional>
+
+#include "poissondisksampler.h"
+
+const float GameWorld::TIME_TO_STARVATION = 60;
+
+const glm::vec3 LIGHT_START(glm::vec3(-100, 150, 0));
+const glm::vec3 LIGHT_END(glm::vec3(20, 150, 0));
+
+const glm::mat4 PLAYER_INIT_TRANSFORM(glm::scale(glm::mat4(1.0f), glm::vec3(0.5, 0.5, 0.5)));
+const glm::mat4 EAGLE_INIT_TRANSFORM(glm::translate(glm::mat4(1.0f), glm::vec3(0, 30, -45)));
+
+// model files of the world
+const std::string TERRAIN_MODEL("../data/models/world/terrain.dae");
+const std::string CAVE_MODEL("../data/models/cave/cave.dae");
+const std::string CARROT_MODEL("../data/models/world/carrot.dae");
+const std::string TREE_MODEL("../data/models/world/tree.dae");
+const std::string SHRUB_MODELS[2] = { "../data/models/world/shrub1.dae", "../data/models/world/shrub2.dae" };
+const std::string PLAYER_MODEL("../data/models/skunk/skunk.dae");
+const std::string EAGLE_MODEL("../data/models/eagle/eagle.dae");
+
+// the simulation runs at a fixed rate, with at most MAX_SIMULATION_STEPS steps per frame
+const double SIMULATION_STEP_SIZE = 1.0 / 60.0;
+const int MAX_SIMULATION_STEPS = 5;
+
+
+GameWorld::GameWorld(InputSource *input, float aspectRatio, unsigned int seed, int physicsThreads, int physicsStressBodies, float objectCountScale)
+{
+	// all randomness of the world is drawn from this generator, so games can be reproduced by their seed
+	std::mt19937 randGen(seed);
+	std::uniform_real_distribution<float> randDistribution(0.0f, 1.0f);
+	auto rand = std::bind(randDistribution, std::ref(randGen));
+
+	sun = new Light(glm::translate(glm::mat4(1.0f), LIGHT_START), LIGHT_END, glm::vec3(1.f, 0.89f, 0.6f), glm::vec3(0.87f, 0.53f, 0.f), TIME_TO_STARVATION);
+
+	particleSystem = new ParticleSystem(glm::mat4(1.0f), "../data/models/skunk/smoke.png", 30, 100.f, 15.f, -0.05f);
+	particleSystem->seedRandom(randGen());
+
+	terrain = new Geometry(glm::scale(glm::mat4(1.0f), glm::vec3(1, 1, 1)), TERRAIN_MODEL);
+	// bake terrain heights to a grid for constant time height queries
+	terrainHeightField = new TerrainHeightField(terrain->getSurface(), terrain->getMatrix(), 0.25f);
+
+	// keep objects away from the terrain borders
+	float minX = terrainHeightField->getBoundsMin().x + 7, maxX = terrainHeightField->getBoundsMax().x - 7;
+	float minZ = terrainHeightField->getBoundsMin().y + 7, maxZ = terrainHeightField->getBoundsMax().y - 7;
+
+	// cave
+	glm::vec2 cavePos2D(0, 0);
+	cave = new Geometry(glm::mat4(1.0f), CAVE_MODEL);
+	cave->setLocation(glm::vec3(cavePos2D.x, terrainHeightField->getHeight(cavePos2D) - 0.4f, cavePos2D.y));
+
+	// more objects need to be placed closer together. the distances are only changed for a scale other than 1,
+	// so the default world stays the same for every seed
+	float distanceScale = (objectCountScale == 1.0f) ? 1.0f : 1.0f / glm::sqrt(objectCountScale);
+
+	float y = 0.0f;
+	// procedurally placed carrots
+	std::vector<glm::vec2> positions = PoissonDiskSampler::generatePoissonSample(int(80 * objectCountScale), 0.4f * distanceScale, randGen); // positions in range [0, 1]
+	for (glm::vec2 p : positions) {
+		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
+		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 10) {
+			y = terrainHeightField->getHeight(p) - 0.2f;
+			carrots.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::mat4(1.0f), 0.0f, glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), CARROT_MODEL));
+		}
+	}
+
+	// procedurally placed trees
+	positions = PoissonDiskSampler::generatePoissonSample(int(60 * objectCountScale), 0.4f * distanceScale, randGen); // positions in range [0, 1]
+	for (glm::vec2 p : positions) {
+		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
+		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 7) {
+			y = terrainHeightField->getHeight(p) - 1.0f;
+			trees.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(0.75 + rand() / 2)), rand() * 2 * glm::pi<float>(), glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), TREE_MODEL));
+		}
+	}
+
+	// procedurally placed shrubs
+	positions = PoissonDiskSampler::generatePoissonSample(int(40 * objectCountScale), 0.6f * distanceScale, randGen); // positions in range [0, 1]
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		glm::vec2 p = positions[i];
+		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
+		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 10) {
+			y = terrainHeightField->getHeight(p) - 0.4f;
+			if (i % 2 == 0) {
+				shrubs.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(1 + rand() / 2)), 0.0f, glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), SHRUB_MODELS[0]));
+			}
+			else {
+				shrubs.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(1 + rand() / 2)), rand() * 2 * glm::pi<float>(), glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), SHRUB_MODELS[1]));
+			}
+		}
+	}
+
+	// INIT PLAYER + CAMERA
+	camera = new Camera(glm::mat4(1.0f), glm::radians(80.0f), aspectRatio, 0.2f, 200.0f); // mat, fov, aspect, znear, zfar
+	player = new Player(PLAYER_INIT_TRANSFORM, camera, input, PLAYER_MODEL);
+
+	// INIT EAGLE
+	eagle = new Eagle(EAGLE_INIT_TRANSFORM, EAGLE_MODEL);
+	eagle->seedRandom(randGen());
+
+	// INIT PHYSICS OBJECTS (add objects to dynamic World)
+	initPhysicsObjects(physicsThreads, physicsStressBodies);
+}
+
+
+void GameWorld::loadModels(JobSystem &jobs)
+{
+	Geometry::loadModels(getModelPaths(), jobs);
+}
+
+std::vector<std::string> GameWorld::getModelPaths()
+{
+	return { TERRAIN_MODEL, CAVE_MODEL, CARROT_MODEL, TREE_MODEL, SHRUB_MODELS[0], SHRUB_MODELS[1], PLAYER_MODEL, EAGLE_MODEL };
+}
+
+
+void GameWorld::setJobSystem(JobSystem *jobs)
+{
+	particleSystem->setJobSystem(jobs);
+}
+
+
+GameWorld::~GameWorld()
+{
+	physics->cleanUp();
+	delete physics; physics = nullptr;
+	delete simulationClock; simulationClock = nullptr;
+
+	delete particleSystem; particleSystem = nullptr;
+	delete player; player = nullptr;
+	delete eagle; eagle = nullptr;
+	delete sun; sun = nullptr;
+	delete terrain; terrain = nullptr;
+	delete cave; cave = nullptr;
+	delete terrainHeightField; terrainHeightField = nullptr;
+
+	carrots.clear();
+	trees.clear();
+	shrubs.clear();
+}
+
+
+void GameWorld::initPhysicsObjects(int physicsThreads, int physicsStressBodies)
+{
+	physics = new Physics(player, physicsThreads);
+	physics->init();
+	simulationClock = new SimulationClock(SIMULATION_STEP_SIZE, MAX_SIMULATION_STEPS);
+
+	physics->addPlayerToPhysics();
+
+	for (std::vector<std::shared_ptr<Geometry>>::iterator it = trees.begin(); it != trees.end(); ++it) {
+		physics->addTreeCylinderToPhysics(it->get(), btScalar(0.6));
+	}
+
+	for (std::vector<std::shared_ptr<Geometry>>::iterator it = carrots.begin(); it != carrots.end(); ++it) {
+		physics->addFoodSphereToPhysics(it->get(), btScalar(0.3));
+	}
+
+	for (std::vector<std::shared_ptr<Geometry>>::iterator it = shrubs.begin(); it != shrubs.end(); ++it) {
+		physics->addBushSphereToPhysics(it->get(), btScalar(2));
+	}
+
+	physics->addTerrainShapeToPhysics(terrain);
+	physics->setupCaveObjects(cave);
+
+	if (physicsStressBodies > 0) {
+		glm::vec2 boundsMin = terrainHeightField->getBoundsMin(), boundsMax = terrainHeightField->getBoundsMax();
+		physics->addStressBodies(physicsStressBodies, btVector3(boundsMin.x, 5, boundsMin.y), btVector3(boundsMax.x, 40, boundsMax.y));
+	}
+}
+
+
+int GameWorld::advance(double frameTime)
+{
+	if (isGameOver()) {
+		return 0;
+	}
+
+	int steps = simulationClock->advance(frameTime);
+	float stepSize = float(simulationClock->getStepSize());
+
+	int i = 0;
+	for (; i < steps && !isGameOver(); ++i) {
+		step(stepSize);
+	}
+	return i;
+}
+
+
+void GameWorld::step(float stepSize)
+{
+	player->storePreviousMatrix();
+	eagle->storePreviousMatrix();
+
+	physics->stepSimulation(stepSize);
+	handleTriggerEvents();
+
+	player->update(stepSize);
+	eagle->update(stepSize, player->getLocation() + glm::vec3(0, 2, 0), player->isInBush() || player->isInCave(), player->isDefenseActive());
+	particleSystem->update(stepSize, player->getViewMat());
+	sun->update(stepSize);
+
+	elapsedTime += stepSize;
+
+	checkGameOver();
+}
+
+
+void GameWorld::handleTriggerEvents()
+{
+	Physics::TriggerEvent event;
+	while (physics->pollTriggerEvent(event)) {
+		switch (event.type) {
+		case Physics::FOOD_TRIGGER:
+			// a carrot touched while still eating another one is eaten on a later stay event
+			if (event.phase != Physics::TriggerEvent::EXIT && !player->isEating()) {
+				player->eat(event.geometry);
+				physics->removeTrigger(event.trigger);
+			}
+			break;
+		case Physics::HIDING_TRIGGER:
+			// hiding spots may overlap, so count the ones the player is in
+			if (event.phase == Physics::TriggerEvent::ENTER) {
+				++hidingSpotsEntered;
+			}
+			else if (event.phase == Physics::TriggerEvent::EXIT) {
+				--hidingSpotsEntered;
+			}
+			player->setInBush(hidingSpotsEntered > 0);
+			break;
+		case Physics::CAVE_TRIGGER:
+			if (event.phase != Physics::TriggerEvent::STAY) {
+				player->setIsInCave(event.phase == Physics::TriggerEvent::ENTER);
+			}
+			break;
+		}
+	}
+}
+
+
+void GameWorld::checkGameOver()
+{
+	if (player->isFull() && player->isInCave()) {
+		outcome = WON;
+		return;
+	}
+
+	if (eagle->isTargetEaten()) {
+		outcome = EATEN;
+	}
+	else if (elapsedTime > TIME_TO_STARVATION - 1) {
+		outcome = STARVED;
+	}
+	else {
+		return;
+	}
+
+	// on starvation or if player eaten by eagle, the player falls over
+	player->rotateZ(3.14159/2, SceneObject::RIGHT);
+	player->translate(glm::vec3(0, 0.3, 0), SceneObject::LEFT);
+}
+
+
+void GameWorld::interpolateRenderState()
+{
+	// render the moving objects between the last two simulation steps
+	float alpha = isGameOver() ? 1.0f : simulationClock->getInterpolationAlpha();
+	physics->interpolateMotionStates(alpha);
+	player->interpolateRenderMatrix(alpha);
+	eagle->interpolateRenderMatrix(alpha);
+}
+
+
+void GameWorld::reset()
+{
+	delete sun;
+	sun = new Light(glm::translate(glm::mat4(1.0f), LIGHT_START), LIGHT_END, glm::vec3(1.f, 0.89f, 0.6f), glm::vec3(0.87f, 0.53f, 0.f), TIME_TO_STARVATION);
+
+	// RESET PLAYER + CAMERA
+	player->setTransform(PLAYER_INIT_TRANSFORM);
+	player->resetPlayer();
+	eagle->setTransform(EAGLE_INIT_TRANSFORM);
+	eagle->resetEagle();
+
+	elapsedTime = 0;
+	outcome = RUNNING;
+}
+
+
+bool GameWorld::activateDefense()
+{
+	if (!player->attemptDefenseActivation()) {
+		return false;
+	}
+	particleSystem->respawn(player->getLocation());
+	return true;
+}
+
+
+bool GameWorld::isGameOver() const
+{
+	return outcome != RUNNING;
+}
+
+
+bool GameWorld::hasWon() const
+{
+	return outcome == WON;
+}
+
+
+GameWorld::Outcome GameWorld::getOutcome() const
+{
+	return outcome;
+}
+
+
+double GameWorld::getElapsedTime() const
+{
+	return elapsedTime;
+}
+
+
+double GameWorld::getTimeUntilStarvation() const
+{
+	return TIME_TO_STARVATION - elapsedTime;
+}
+
+
+Geometry *GameWorld::getTerrain()
+{
+	return terrain;
+}
+
+
+Geometry *GameWorld::getCave()
+{
+	return cave;
+}
+
+
+TerrainHeightField *GameWorld::getTerrainHeightField()
+{
+	return terrainHeightField;
+}
+
+
+std::vector<std::shared_ptr<Geometry>> &GameWorld::getCarrots()
+{
+	return carrots;
+}
+
+
+std::vector<std::shared_ptr<Geometry>> &GameWorld::getTrees()
+{
+	return trees;
+}
+
+
+std::vector<std::shared_ptr<Geometry>> &GameWorld::getShrubs()
+{
+	return shrubs;
+}
+
+
+Camera *GameWorld::getCamera()
+{
+	return camera;
+}
+
+
+Player *GameWorld::getPlayer()
+{
+	return player;
+}
+
+
+Eagle *GameWorld::getEagle()
+{
+	return eagle;
+}
+
+
+Light *GameWorld::getSun()
+{
+	return sun;
+}
+
+
+ParticleSystem *GameWorld::getParticleSystem()
+{
+	return particleSystem;
+}
+
+
+Physics *GameWorld::getPhysics()
+{
+	return physics;
+}
+
+
+SimulationClock *GameWorld::getSimulationClock()
+{
+	return simulationClock;
+}
@@ -0,0 +1,172 @@
+#ifndef GAMEWORLD_H
+#define GAMEWORLD_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+
+#include "geometry.h"
+#include "terrainheightfield.h"
+#include "camera.h"
+#include "player.h"
+#include "eagle.h"
+#include "light.h"
+#include "inputsource.h"
+#include "effects/particlesystem.h"
+#include "physics.h"
+#include "simulationclock.h"
+#include "jobsystem.h"
+
+/**
+ * @brief The GameWorld holds the simulated state of one game: the terrain and the objects placed on it,
+ * the player, the eagle, the sun, the particle system and the physics world.
+ * It advances the game logic in fixed steps and does not render anything, so it can also be run
+ * without a window or OpenGL context (see GLState::contextAvailable).
+ */
+class GameWorld
+{
+public:
+	// time in seconds until the player starves, also the duration of the day cycle
+	static const float TIME_TO_STARVATION;
+
+	enum Outcome { RUNNING, WON, EATEN, STARVED };
+
+	/**
+	 * @param input the input source the player is controlled by
+	 * @param aspectRatio the aspect ratio of the player camera
+	 * @param seed seed of the random placement of the objects and of the eagle and particle behaviour.
+	 * worlds created with the same seed and input play out the same way.
+	 * @param physicsThreads number of worker threads for the physics simulation
+	 * @param physicsStressBodies number of additional dynamic bodies to stress the physics simulation
+	 * @param objectCountScale factor for the number of placed carrots, trees and shrubs, e.g. to benchmark denser scenes
+	 */
+	GameWorld(InputSource *input, float aspectRatio, unsigned int seed, int physicsThreads = 1, int physicsStressBodies = 0, float objectCountScale = 1.0f);
+	~GameWorld();
+
+	/**
+	 * @brief load all model files of the world in parallel before creating it,
+	 * so that the constructor only shares the loaded surfaces. see Geometry::loadModels
+	 * @param jobs the job system to read the files and decode the textures with
+	 */
+	static void loadModels(JobSystem &jobs);
+
+	/**
+	 * @brief get the paths of all model files of the world, e.g. to bake them
+	 */
+	static std::vector<std::string> getModelPaths();
+
+	/**
+	 * @brief distribute parts of the simulation step over the given job system
+	 * @param jobs the job system to use, or nullptr to simulate on the calling thread only
+	 */
+	void setJobSystem(JobSystem *jobs);
+
+	/**
+	 * @brief advance the simulation by the time passed since the last frame, in fixed steps.
+	 * nothing is simulated once the game is over.
+	 * @param frameTime the time passed since the last frame in seconds
+	 * @return the number of steps simulated
+	 */
+	int advance(double frameTime);
+
+	/**
+	 * @brief interpolate the rendered transforms of the moving objects between the last two steps
+	 */
+	void interpolateRenderState();
+
+	/**
+	 * @brief start a new game, the placement of the objects is kept.
+	 * carrots eaten in earlier games stay removed, create a new world for independent games
+	 */
+	void reset();
+
+	/**
+	 * @brief let the player activate the defense, if possible
+	 * @return true if the defense has been activated
+	 */
+	bool activateDefense();
+
+	/**
+	 * @return true if the player starved, got eaten or made it to the cave
+	 */
+	bool isGameOver() const;
+
+	/**
+	 * @return true if the player made it to the cave with enough food
+	 */
+	bool hasWon() const;
+
+	/**
+	 * @return how the game ended, or RUNNING
+	 */
+	Outcome getOutcome() const;
+
+	/**
+	 * @return simulated seconds since the start of the game
+	 */
+	double getElapsedTime() const;
+
+	/**
+	 * @return simulated seconds left until the player starves
+	 */
+	double getTimeUntilStarvation() const;
+
+	Geometry *getTerrain();
+	Geometry *getCave();
+	TerrainHeightField *getTerrainHeightField();
+	std::vector<std::shared_ptr<Geometry>> &getCarrots();
+	std::vector<std::shared_ptr<Geometry>> &getTrees();
+	std::vector<std::shared_ptr<Geometry>> &getShrubs();
+	Camera *getCamera();
+	Player *getPlayer();
+	Eagle *getEagle();
+	Light *getSun();
+	ParticleSystem *getParticleSystem();
+	Physics *getPhysics();
+	SimulationClock *getSimulationClock();
+
+private:
+	Geometry *terrain, *cave;
+	TerrainHeightField *terrainHeightField;
+
+	std::vector<std::shared_ptr<Geometry>> carrots;
+	std::vector<std::shared_ptr<Geometry>> trees;
+	std::vector<std::shared_ptr<Geometry>> shrubs;
+
+	Camera *camera;
+	Player *player;
+	Eagle *eagle;
+	Light *sun;
+	ParticleSystem *particleSystem;
+
+	Physics *physics;
+	SimulationClock *simulationClock;
+
+	int hidingSpotsEntered = 0;
+	double elapsedTime = 0;
+	Outcome outcome = RUNNING;
+
+	/**
+	 * @brief add the placed objects to the physics world
+	 */
+	void initPhysicsObjects(int physicsThreads, int physicsStressBodies);
+
+	/**
+	 * @brief simulate one fixed step
+	 */
+	void step(float stepSize);
+
+	/**
+	 * @brief react to the player entering or leaving trigger volumes
+	 */
+	void handleTriggerEvents();
+
+	/**
+	 * @brief end the game if the player starved, got eaten or made it to the cave
+	 */
+	void checkGameOver();
+};
+
+#endif // GAMEWORLD_H
@@ -1,12 +1,40 @@
 #include "geometry.h"
+#include "bakedmodel.h"
+#include "assetpack.h"
+
+#include <chrono>
+#include <deque>
+#include <unordered_set>
+#include <condition_variable>
 
 int Geometry::drawnSurfaceCount = 0;
 std::vector<std::shared_ptr<Texture>> Geometry::loadedTextures = {};
+std::unordered_map<std::string, std::vector<std::shared_ptr<const Surface>>> Geometry::loadedModels = {};
+std::mutex Geometry::loadedAssetsMutex;
+TextureStreamer *Geometry::textureStreamer = nullptr;
 
-Geometry::Geometry(const glm::mat4 &matrix_, const std::string &filePath)
+Geometry::Geometry(const glm::mat4 &matrix_, const std::string &filePath_)
     : SceneObject(matrix_)
+	, filePath(filePath_)
 {
-	loadSurfaces(filePath);
+	std::lock_guard<std::mutex> lock(loadedAssetsMutex);
+
+	// check if we already loaded the model of the given path for another geometry
+	auto existingModel = loadedModels.find(filePath);
+	if (existingModel != loadedModels.end()) {
+		surfaces = existingModel->second; // share the existing surfaces
+		return;
+	}
+
+	// otherwise load the surfaces from the file, running both stages here
+	Tracer::Scope scope("load model " + filePath);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	PreparedModel model;
+	prepareModel(filePath, model);
+	surfaces = uploadModel(model);
+	loadedModels[filePath] = surfaces;
+	std::cout << "loaded model: " << filePath << (model.bakedModel ? " (baked, " : " (parsed, ")
+	          << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms)" << std::endl;
 }
 
 Geometry::~Geometry()
@@ -24,85 +52,126 @@ void Geometry::update(float timeDelta)
 
 }
 
-void Geometry::draw(Shader *shader, Camera *camera, bool useFrustumCulling, Texture::FilterType filterType, const glm::mat4 &viewMat)
+void Geometry::draw(Shader *shader, bool useFrustumCulling, const glm::mat4 &viewProjMat)
+{
+	draw(shader, useFrustumCulling, viewProjMat, getRenderMatrix());
+}
+
+void Geometry::draw(Shader *shader, bool useFrustumCulling, const glm::mat4 &viewProjMat, const glm::mat4 &modelMat)
 {
 	// pass model matrix to shader
-	GLint modelMatLocation = glGetUniformLocation(shader->programHandle, "modelMat"); // get uniform location in shader
-	glUniformMatrix4fv(modelMatLocation, 1, GL_FALSE, glm::value_ptr(getMatrix())); // shader location, count, transpose?, value pointer
+	shader->modelMat.set(modelMat);
 
 	// pass normal matrix to shader
-	GLint normalMatLocation = glGetUniformLocation(shader->programHandle, "normalMat");
-	glUniformMatrix3fv(normalMatLocation, 1, GL_FALSE, glm::value_ptr(getNormalMatrix()));
+	shader->normalMat.set(glm::transpose(glm::inverse(glm::mat3(modelMat))));
 
 	// draw surfaces
 	for (GLuint i = 0; i < surfaces.size(); ++i) {
 
 		// view frustum culling using bounding spheres
 		if (useFrustumCulling) {
-			glm::vec3 boundingSphereCenter = (getMatrix() * glm::vec4(surfaces[i]->getBoundingSphereCenter(), 1)).xyz();
-			glm::vec3 boundingSphereFarthestPoint = (getMatrix() * glm::vec4(surfaces[i]->getBoundingSphereFarthestPoint(), 1)).xyz();
+			glm::vec3 boundingSphereCenter = (modelMat * glm::vec4(surfaces[i]->getBoundingSphereCenter(), 1)).xyz();
+			glm::vec3 boundingSphereFarthestPoint = (modelMat * glm::vec4(surfaces[i]->getBoundingSphereFarthestPoint(), 1)).xyz();
 
-			if (!camera->checkSphereInFrustum(boundingSphereCenter, boundingSphereFarthestPoint, viewMat))
+			if (!Camera::checkSphereInFrustum(boundingSphereCenter, boundingSphereFarthestPoint, viewProjMat))
 				continue;
 		}
 
 		drawnSurfaceCount += 1;
-		surfaces[i]->draw(shader, filterType);
+		surfaces[i]->draw(shader);
 	}
 
 }
 
-void Geometry::loadSurfaces(const std::string &filePath)
+bool Geometry::prepareModel(const std::string &filePath, PreparedModel &model)
 {
+	Tracer::Scope scope("prepare model " + filePath);
+	model.filePath = filePath;
+
+	// a baked model is mapped and uploaded directly, the model file is only parsed if it is missing or stale
+	std::shared_ptr<BakedModel> bakedModel = std::make_shared<BakedModel>();
+	if (bakedModel->load(filePath)) {
+		model.bakedModel = bakedModel;
+		return true;
+	}
 
-	// read surface data from file using Assimp.
-	//
-	// IMPORTANT ASSIMP POSTPROCESS FLAGS
-	// - aiProcess_PreTransformVertices: to load vertices in world space i.e. apply transformation matrices, which we dont load
-	// - aiProcess_Triangulate: needed for OpenGL
-	// if there are problems with the uvs, try aiProcess_FlipUVs
-	// note: experiment with flags like aiProcess_SplitLargeMeshes, aiProcess_OptimizeMeshes, when using bigger models.
-    Assimp::Importer importer;
-	const aiScene *scene = importer.ReadFile(filePath, aiProcess_PreTransformVertices | aiProcess_Triangulate);
+	if (!importMeshes(filePath, model.meshes)) {
+		return false;
+	}
+	for (MeshData &mesh : model.meshes) {
+		Surface::calculateBoundingSphere(mesh.vertices.data(), mesh.vertices.size(), mesh.boundingSphereCenter, mesh.boundingSphereFarthestPoint);
+	}
+	return true;
+}
 
-    // check for errors
-	if (!scene || !scene->mRootNode || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE) {
-        std::cerr << "ERROR ASSIMP: " << importer.GetErrorString() << std::endl;
-        return;
-    }
+std::vector<std::string> Geometry::getTexturePaths(const PreparedModel &model)
+{
+	std::vector<std::string> texturePaths;
+	if (model.bakedModel) {
+		for (const BakedModel::SurfaceView &surface : model.bakedModel->getSurfaces()) {
+			texturePaths.insert(texturePaths.end(), surface.texturePaths, surface.texturePaths + 3);
+		}
+	}
+	for (const MeshData &mesh : model.meshes) {
+		texturePaths.insert(texturePaths.end(), mesh.texturePaths, mesh.texturePaths + 3);
+	}
+
+	for (std::string &texturePath : texturePaths) {
+		texturePath = getTexturePath(model.filePath, texturePath);
+	}
+	texturePaths.erase(std::remove(texturePaths.begin(), texturePaths.end(), std::string()), texturePaths.end());
+	return texturePaths;
+}
 
-    // save path to the directory containing the file
-    directoryPath = filePath.substr(0, filePath.find_last_of('/'));
+std::vector<std::shared_ptr<const Surface>> Geometry::uploadModel(const PreparedModel &model)
+{
+	Tracer::Scope scope("upload model " + model.filePath);
+	std::vector<std::shared_ptr<const Surface>> surfaces;
+
+	if (model.bakedModel) {
+		for (const BakedModel::SurfaceView &surface : model.bakedModel->getSurfaces()) {
+			surfaces.push_back(std::make_shared<Surface>(surface.vertices, surface.vertexCount, surface.indices, surface.indexCount,
+			                                             surface.boundingSphereCenter, surface.boundingSphereFarthestPoint,
+			                                             loadTexture(getTexturePath(model.filePath, surface.texturePaths[0]), false),
+			                                             loadTexture(getTexturePath(model.filePath, surface.texturePaths[1]), false),
+			                                             loadTexture(getTexturePath(model.filePath, surface.texturePaths[2]), false)));
+		}
+	}
 
-    // recursively process Assimp root node
-	processNode(scene->mRootNode, scene);
+	for (const MeshData &mesh : model.meshes) {
+		surfaces.push_back(std::make_shared<Surface>(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(),
+		                                             mesh.boundingSphereCenter, mesh.boundingSphereFarthestPoint,
+		                                             loadTexture(getTexturePath(model.filePath, mesh.texturePaths[0]), false),
+		                                             loadTexture(getTexturePath(model.filePath, mesh.texturePaths[1]), false),
+		                                             loadTexture(getTexturePath(model.filePath, mesh.texturePaths[2]), false)));
+	}
 
-//	std::cout << "surfaces: " << surfaces.size() << std::endl;
-//	std::cout << "textures: " << loadedTextures.size() << std::endl;
+	return surfaces;
 }
 
-void Geometry::processNode(aiNode *node, const aiScene *scene)
+void Geometry::processNode(aiNode *node, const aiScene *scene, std::vector<MeshData> &meshes)
 {
 	// process all meshes contained in this node.
 	// note that the node->mMeshes just define the hierarchy
 	// and store indices to the actual data in scene->mMeshes
     for (GLuint i = 0; i < node->mNumMeshes; ++i) {
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh, scene);
+        processMesh(mesh, scene, meshes);
     }
 
     // then process all child nodes
     for (GLuint i = 0; i < node->mNumChildren; ++i) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, meshes);
     }
 
 }
 
-void Geometry::processMesh(aiMesh *mesh, const aiScene *scene)
+void Geometry::processMesh(aiMesh *mesh, const aiScene *scene, std::vector<MeshData> &meshes)
 {
-	std::vector<Vertex> vertices;
-	std::vector<GLuint> indices;
-	std::shared_ptr<Texture> surfaceTextureDiffuse, surfaceTextureSpecular, surfaceTextureNormal;
+	meshes.push_back(MeshData());
+	std::vector<Vertex> &vertices = meshes.back().vertices;
+	std::vector<GLuint> &indices = meshes.back().indices;
+	vertices.reserve(mesh->mNumVertices);
 
 	// process mesh vertices (positions, normals, uvs)
 	for (GLuint i = 0; i < mesh->mNumVertices; ++i) {
@@ -146,57 +215,276 @@ void Geometry::processMesh(aiMesh *mesh, const aiScene *scene)
 		}
 	}
 
-	// process material and store textures
-	// note: we only load the first diffuse, specular and normal texture reffered to by the assimp material
+	// process material and store texture paths
+	// note: we only take the first diffuse, specular and normal texture reffered to by the assimp material
 	// and store them in this order
 	if (mesh->mMaterialIndex >= 0) {
 
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-		surfaceTextureDiffuse = loadMaterialTexture(material, aiTextureType_DIFFUSE);
-		surfaceTextureSpecular = loadMaterialTexture(material, aiTextureType_SPECULAR);
-		surfaceTextureNormal = loadMaterialTexture(material, aiTextureType_NORMALS);
+		meshes.back().texturePaths[0] = getMaterialTexturePath(material, aiTextureType_DIFFUSE);
+		meshes.back().texturePaths[1] = getMaterialTexturePath(material, aiTextureType_SPECULAR);
+		meshes.back().texturePaths[2] = getMaterialTexturePath(material, aiTextureType_NORMALS);
 	}
 
-	// return a Surface object created from the extracted aiMesh data
-	surfaces.push_back(std::make_shared<Surface>(vertices, indices, surfaceTextureDiffuse, surfaceTextureSpecular, surfaceTextureNormal));
-
 }
 
-std::shared_ptr<Texture> Geometry::loadMaterialTexture(aiMaterial *mat, aiTextureType type)
+std::string Geometry::getMaterialTexturePath(aiMaterial *mat, aiTextureType type)
 {
 	aiString texturePath;
+	if (mat->GetTexture(type, 0, &texturePath) == AI_SUCCESS) {
+		return texturePath.C_Str();
+	}
+	return std::string();
+}
+
+std::string Geometry::getTexturePath(const std::string &modelPath, const std::string &texturePath)
+{
+	if (texturePath.empty()) {
+		return texturePath;
+	}
+	return modelPath.substr(0, modelPath.find_last_of('/')) + '/' + texturePath;
+}
+
+std::shared_ptr<Texture> Geometry::loadTexture(const std::string &texturePath, bool alpha)
+{
 	std::shared_ptr<Texture> texture = nullptr;
 
-	if (mat->GetTexture(type, 0, &texturePath) == AI_SUCCESS) {
+	// textures are only needed for drawing
+	if (!GLState::contextAvailable || texturePath.empty()) {
+		return texture;
+	}
 
-		// check if we already loaded the texture of the given path for another mesh
-		bool skip = false;
-		for (auto existingTexture : loadedTextures) {
-
-	        if (existingTexture->getFilePath() == (directoryPath + '/' + texturePath.C_Str())) {
-				skip = true;
-	            texture = existingTexture; // use pointer to existing texture
-				break;
-	        }
-	    }
-
-		// otherwise load the texture from the file
-		if (!skip) {
-			loadedTextures.push_back(std::make_shared<Texture>(directoryPath + '/' + texturePath.C_Str(), false));
-			std::cout << "loaded texture: " << directoryPath + '/' + texturePath.C_Str() << std::endl;
-			texture = loadedTextures.back();
+	// check if we already loaded the texture of the given path for another mesh
+	for (auto existingTexture : loadedTextures) {
+		if (existingTexture->getFilePath() == texturePath) {
+			return existingTexture; // use pointer to existing texture
 		}
+	}
 
+	// otherwise load the texture from the file, or let it be streamed in during the next frames
+	if (textureStreamer) {
+		loadedTextures.push_back(textureStreamer->request(texturePath, alpha));
+		std::cout << "streaming texture: " << texturePath << std::endl;
+	}
+	else {
+		loadedTextures.push_back(std::make_shared<Texture>(texturePath, alpha));
+		std::cout << "loaded texture: " << texturePath << std::endl;
 	}
+	texture = loadedTextures.back();
 
 	return texture;
 }
 
-Surface *Geometry::getSurface()
+const Surface *Geometry::getSurface() const
 {
 	if (surfaces.size() == 1) {
-		std::shared_ptr<Surface> surf = surfaces.at(0);
+		std::shared_ptr<const Surface> surf = surfaces.at(0);
 		return surf.get();
 	}
+	return nullptr;
+}
+
+const std::vector<std::shared_ptr<const Surface>> &Geometry::getSurfaces() const
+{
+	return surfaces;
+}
+
+std::string Geometry::getFilePath() const
+{
+	return filePath;
+}
+
+std::shared_ptr<Assimp::Importer> Geometry::importModel(const std::string &filePath)
+{
+	// read surface data from file using Assimp.
+	//
+	// IMPORTANT ASSIMP POSTPROCESS FLAGS
+	// - aiProcess_PreTransformVertices: to load vertices in world space i.e. apply transformation matrices, which we dont load
+	// - aiProcess_Triangulate: needed for OpenGL
+	// if there are problems with the uvs, try aiProcess_FlipUVs
+	// note: experiment with flags like aiProcess_SplitLargeMeshes, aiProcess_OptimizeMeshes, when using bigger models.
+	Tracer::Scope scope("import model " + filePath);
+
+	std::shared_ptr<Assimp::Importer> importer = std::make_shared<Assimp::Importer>();
+	const aiScene *scene = nullptr;
+
+	// a model in the asset pack is parsed from memory, the extension tells assimp the format
+	Asset modelFile;
+	if (AssetPack::contains(filePath) && AssetPack::read(filePath, modelFile)) {
+		std::string extension = filePath.substr(filePath.find_last_of('.') + 1);
+		scene = importer->ReadFileFromMemory(modelFile.getData(), modelFile.getSize(), aiProcess_PreTransformVertices | aiProcess_Triangulate, extension.c_str());
+	}
+	else {
+		scene = importer->ReadFile(filePath, aiProcess_PreTransformVertices | aiProcess_Triangulate);
+	}
+
+	// check for errors
+	if (!scene || !scene->mRootNode || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE) {
+		std::cerr << "ERROR ASSIMP: " << importer->GetErrorString() << std::endl;
+		return nullptr;
+	}
+
+	return importer;
+}
+
+void Geometry::loadModels(const std::vector<std::string> &filePaths, JobSystem &jobs)
+{
+	Tracer::Scope scope("load models");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// the cache is only changed by this thread while loading, the jobs do not touch it
+	std::lock_guard<std::mutex> lock(loadedAssetsMutex);
+
+	std::vector<std::string> pendingPaths;
+	for (const std::string &filePath : filePaths) {
+		if (loadedModels.count(filePath) == 0 && std::find(pendingPaths.begin(), pendingPaths.end(), filePath) == pendingPaths.end()) {
+			pendingPaths.push_back(filePath);
+		}
+	}
+
+	// textures already loaded and textures scheduled for decoding, so every texture is decoded once
+	std::unordered_set<std::string> uploadedTextures;
+	for (const std::shared_ptr<Texture> &texture : loadedTextures) {
+		uploadedTextures.insert(texture->getFilePath());
+	}
+	std::unordered_set<std::string> scheduledTextures = uploadedTextures;
+
+	// the upload queue, filled by the jobs and emptied by this thread
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::deque<std::shared_ptr<PreparedModel>> preparedModels;
+	std::deque<DecodedTexture> decodedTextures;
+	int pendingJobs = int(pendingPaths.size());
+
+	JobSystem::TaskGroup group;
+	std::function<void(const std::string&)> decodeTexture = [&](const std::string &texturePath) {
+		// a compressed file is only mapped, the image is decoded if there is none
+		DecodedTexture texture;
+		texture.filePath = texturePath;
+		texture.compressed = std::make_shared<CompressedTexture>();
+		if (!CompressedTexture::isSupported() || !texture.compressed->load(texturePath)) {
+			texture.compressed.reset();
+			texture.image = std::make_shared<fipImage>();
+			Texture::decode(texturePath, *texture.image);
+		}
+
+		std::lock_guard<std::mutex> queueLock(queueMutex);
+		decodedTextures.push_back(texture);
+		--pendingJobs;
+		queueChanged.notify_one();
+	};
+
+	for (const std::string &filePath : pendingPaths) {
+		jobs.run(group, [&, filePath]() {
+			std::shared_ptr<PreparedModel> model = std::make_shared<PreparedModel>();
+			prepareModel(filePath, *model);
+
+			// decode the textures of the model in further jobs while the model waits for its upload
+			std::vector<std::string> newTextures;
+			{
+				std::lock_guard<std::mutex> queueLock(queueMutex);
+				if (GLState::contextAvailable) {
+					for (const std::string &texturePath : getTexturePaths(*model)) {
+						if (scheduledTextures.insert(texturePath).second) {
+							newTextures.push_back(texturePath);
+							++pendingJobs;
+						}
+					}
+				}
+				preparedModels.push_back(model);
+				--pendingJobs;
+				queueChanged.notify_one();
+			}
+			for (const std::string &texturePath : newTextures) {
+				jobs.run(group, [&decodeTexture, texturePath]() { decodeTexture(texturePath); });
+			}
+		});
+	}
+
+	// upload everything that is ready until all jobs are done.
+	// a model is uploaded once all of its textures are, so that it does not decode them again
+	std::vector<std::shared_ptr<PreparedModel>> waitingModels;
+	int uploadedModelCount = 0, uploadedTextureCount = 0;
+	while (true) {
+		std::deque<std::shared_ptr<PreparedModel>> newModels;
+		std::deque<DecodedTexture> newTextures;
+		bool jobsDone;
+		{
+			std::unique_lock<std::mutex> queueLock(queueMutex);
+			queueChanged.wait(queueLock, [&]() { return !preparedModels.empty() || !decodedTextures.empty() || pendingJobs == 0; });
+			newModels.swap(preparedModels);
+			newTextures.swap(decodedTextures);
+			jobsDone = pendingJobs == 0;
+		}
+
+		for (const DecodedTexture &texture : newTextures) {
+			if (texture.compressed) {
+				loadedTextures.push_back(std::make_shared<Texture>(texture.filePath, *texture.compressed));
+			}
+			else {
+				loadedTextures.push_back(std::make_shared<Texture>(texture.filePath, *texture.image, false));
+			}
+			uploadedTextures.insert(texture.filePath);
+			++uploadedTextureCount;
+			std::cout << "loaded texture: " << texture.filePath << std::endl;
+		}
+		waitingModels.insert(waitingModels.end(), newModels.begin(), newModels.end());
+
+		for (auto model = waitingModels.begin(); model != waitingModels.end();) {
+			std::vector<std::string> texturePaths = GLState::contextAvailable ? getTexturePaths(**model) : std::vector<std::string>();
+			bool texturesUploaded = std::all_of(texturePaths.begin(), texturePaths.end(),
+				[&uploadedTextures](const std::string &texturePath) { return uploadedTextures.count(texturePath) > 0; });
+			if (!texturesUploaded && !jobsDone) {
+				++model;
+				continue;
+			}
+
+			loadedModels[(*model)->filePath] = uploadModel(**model);
+			++uploadedModelCount;
+			std::cout << "loaded model: " << (*model)->filePath << ((*model)->bakedModel ? " (baked)" : " (parsed)") << std::endl;
+			model = waitingModels.erase(model);
+		}
+
+		if (jobsDone) {
+			break;
+		}
+	}
+	jobs.wait(group);
+
+	std::cout << "loaded " << uploadedModelCount << " models and " << uploadedTextureCount << " textures in "
+	          << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+}
+
+bool Geometry::importMeshes(const std::string &filePath, std::vector<MeshData> &meshes)
+{
+	meshes.clear();
+
+	std::shared_ptr<Assimp::Importer> importer = importModel(filePath);
+	if (!importer) {
+		return false;
+	}
+
+	const aiScene *scene = importer->GetScene();
+	processNode(scene->mRootNode, scene, meshes);
+	return true;
+}
+
+void Geometry::setTextureStreamer(TextureStreamer *textureStreamer_)
+{
+	std::lock_guard<std::mutex> lock(loadedAssetsMutex);
+	textureStreamer = textureStreamer_;
+}
+
+std::shared_ptr<Texture> Geometry::requestTexture(const std::string &texturePath, bool alpha)
+{
+	std::lock_guard<std::mutex> lock(loadedAssetsMutex);
+	return loadTexture(texturePath, alpha);
+}
+
+void Geometry::releaseLoadedAssets()
+{
+	std::lock_guard<std::mutex> lock(loadedAssetsMutex);
+	loadedModels.clear();
+	loadedTextures.clear();
 }
@@ -7,66 +7,154 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <mutex>
 
 #include "sceneobject.h"
 #include "surface.h"
 #include "shader.h"
 #include "texture.h"
 #include "camera.h"
+#include "jobsystem.h"
+#include "tracer.h"
+#include "texturestreamer.h"
 
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 
+class BakedModel;
+
 /**
  * @brief A Geometry is a SceneObject that holds Surfaces which contain mesh data and textures.
+ * Models are loaded from a baked model file next to the model file if it is up to date (see BakedModel),
+ * otherwise the model file is parsed with assimp.
+ * Loading is split into a cpu stage (read, parse, build the vertex arrays, compute bounds, decode textures)
+ * that needs no opengl context, and an upload stage on the context thread. loadModels runs the cpu stage
+ * of many models on worker threads, a geometry created from a model not loaded before runs both stages itself.
  */
 class Geometry : public SceneObject
 {
+public:
+
+	/**
+	 * @brief the data of one surface as read from a model file, before it is uploaded
+	 */
+	struct MeshData {
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		// paths of the diffuse, specular and normal texture relative to the model directory, empty if there is none
+		std::string texturePaths[3];
 
-	// surfaces store mesh data and textures
-	std::vector<std::shared_ptr<Surface>> surfaces;
+		glm::vec3 boundingSphereCenter;
+		glm::vec3 boundingSphereFarthestPoint;
+	};
 
-	// the path of the directory containing the model file to load
-	std::string directoryPath;
+private:
+
+	/**
+	 * @brief a model read into memory by the cpu stage of loading, ready to be uploaded
+	 */
+	struct PreparedModel {
+		std::string filePath;
+		std::shared_ptr<BakedModel> bakedModel;   // the surfaces point into the baked file if the model was baked
+		std::vector<MeshData> meshes;             // otherwise the meshes parsed from the model file
+	};
+
+	/**
+	 * @brief a texture read into memory by the cpu stage of loading, ready to be uploaded
+	 */
+	struct DecodedTexture {
+		std::string filePath;
+		std::shared_ptr<CompressedTexture> compressed;   // the mapped compressed file if there is one up to date
+		std::shared_ptr<fipImage> image;                 // otherwise the decoded image
+	};
+
+	// surfaces store mesh data and textures.
+	// they are shared among all geometries loaded from the same model file, thus immutable.
+	std::vector<std::shared_ptr<const Surface>> surfaces;
+
+	// the path of the model file the surfaces were loaded from
+	std::string filePath;
 
 	// pointers to all textures loaded by the surfaces of this geometry, to avoid loading twice
 	static std::vector<std::shared_ptr<Texture>> loadedTextures;
 
+	// surfaces of all model files loaded so far, to avoid loading and uploading the same model twice
+	static std::unordered_map<std::string, std::vector<std::shared_ptr<const Surface>>> loadedModels;
+
+	// guards loadedModels and loadedTextures, geometries may be created by several game worlds in parallel
+	static std::mutex loadedAssetsMutex;
+
+	// streams the textures not loaded yet if set, otherwise they are loaded at once
+	static TextureStreamer *textureStreamer;
+
+	/**
+	 * @brief parse a model file with assimp
+	 * @param filePath the path of the file to parse
+	 * @return the importer owning the parsed scene, or nullptr on errors
+	 */
+	static std::shared_ptr<Assimp::Importer> importModel(const std::string &filePath);
+
+	/**
+	 * @brief the cpu stage of loading a model: map the baked model, or parse the model file
+	 * and build the vertex arrays and bounding spheres. needs no opengl context and no lock.
+	 * @param filePath the model file
+	 * @param model is set to the prepared model
+	 * @return false if the model could not be read, the model has no meshes then
+	 */
+	static bool prepareModel(const std::string &filePath, PreparedModel &model);
+
+	/**
+	 * @brief get the paths of all textures used by a prepared model, relative to the working directory
+	 */
+	static std::vector<std::string> getTexturePaths(const PreparedModel &model);
+
 	/**
-	 * @brief load surfaces from file
-	 * note: this loads only the first diffuse, specular and normal texture for each surface
+	 * @brief the upload stage of loading a model: create the surfaces and the textures not loaded yet.
+	 * must run on the context thread with loadedAssetsMutex locked.
+	 * note: this uses only the first diffuse, specular and normal texture for each surface
 	 * and stores them in this order in the surface
-	 * @param filePath the path of the file to load surfaces from
+	 * @param model the prepared model
+	 * @return the surfaces of the model
 	 */
-	void loadSurfaces(const std::string &filePath);
+	static std::vector<std::shared_ptr<const Surface>> uploadModel(const PreparedModel &model);
 
 	/**
 	 * @brief process all meshes contained in given node
 	 * and recursively process all child nodes
 	 * @param node the current node to process
 	 * @param scene the aiScene containing the node
+	 * @param meshes the mesh data of every processed mesh is appended to this
 	 */
-	void processNode(aiNode *node, const aiScene *scene);
+	static void processNode(aiNode *node, const aiScene *scene, std::vector<MeshData> &meshes);
 
 	/**
-	 * @brief load data from assimp aiMesh to new Surface object
-	 * note: this loads only the first diffuse, specular and normal texture for each surface
-	 * and stores them in this order in the surface
+	 * @brief extract the data of an assimp aiMesh
+	 * note: this takes only the first diffuse, specular and normal texture for each surface
 	 * @param mesh the aiMesh to process
 	 * @param scene the aiScene containing the mesh
-	 * @return
+	 * @param meshes the mesh data is appended to this
 	 */
-	void processMesh(aiMesh *mesh, const aiScene *scene);
+	static void processMesh(aiMesh *mesh, const aiScene *scene, std::vector<MeshData> &meshes);
 
 	/**
-	 * @brief load assimp aiMesh texture of given type.
-	 * textures of same filePath are reused among the geometry object.
+	 * @brief get the path of the first texture of given type of an assimp material
 	 * @param mat the assimp mesh material
 	 * @param type the aiTextureType
-	 * @return a pointer to the texture
+	 * @return the texture path relative to the model directory, empty if the material has no such texture
 	 */
-	std::shared_ptr<Texture> loadMaterialTexture(aiMaterial *mat, aiTextureType type);
+	static std::string getMaterialTexturePath(aiMaterial *mat, aiTextureType type);
+
+	/**
+	 * @brief get a loaded texture, or load it if it is not loaded yet.
+	 * textures of same filePath are reused among all geometries. loadedAssetsMutex must be locked.
+	 * @param texturePath the texture path relative to the working directory, may be empty
+	 * @param alpha true if the image has an alpha channel
+	 * @return a pointer to the texture, nullptr if the path is empty or there is no opengl context
+	 */
+	static std::shared_ptr<Texture> loadTexture(const std::string &texturePath, bool alpha);
 
 public:
 
@@ -82,7 +170,13 @@ public:
 	/**
 	 * @brief draw the SceneObject using given shader
 	 */
-	virtual void draw(Shader *shader, Camera *camera, bool useFrustumCulling, Texture::FilterType filterType, const glm::mat4 &viewMat);
+	virtual void draw(Shader *shader, bool useFrustumCulling, const glm::mat4 &viewProjMat);
+
+	/**
+	 * @brief draw the surfaces with the given model matrix instead of the own render matrix,
+	 * e.g. with a matrix captured while the geometry is updated on another thread
+	 */
+	void draw(Shader *shader, bool useFrustumCulling, const glm::mat4 &viewProjMat, const glm::mat4 &modelMat);
 
 	/**
 	 * @brief return a the transposed inverse of the modelMatrix.
@@ -98,7 +192,69 @@ public:
 	// the number of surfaces being drawn
 	static int drawnSurfaceCount;
 
-	Surface *getSurface();
+	const Surface *getSurface() const;
+
+	/**
+	 * @brief get all surfaces of this geometry
+	 * @return the surfaces
+	 */
+	const std::vector<std::shared_ptr<const Surface>> &getSurfaces() const;
+
+	/**
+	 * @brief get the path of the model file this geometry was loaded from
+	 * @return the model file path
+	 */
+	std::string getFilePath() const;
+
+	/**
+	 * @brief load the given model files and their textures, so that creating geometries of them
+	 * later only shares the loaded surfaces.
+	 * the cpu stage of every model and the decoding of every texture run as jobs on the worker threads,
+	 * the calling thread uploads them from a queue as soon as they are ready, so it must be the context thread.
+	 * a model is uploaded once all of its textures are.
+	 * @param filePaths the model files to load, files already loaded are skipped
+	 * @param jobs the job system to run the cpu stage on
+	 */
+	static void loadModels(const std::vector<std::string> &filePaths, JobSystem &jobs);
+
+	/**
+	 * @brief parse a model file with assimp and extract the data of all its meshes, e.g. to bake it
+	 * @param filePath the model file
+	 * @param meshes is set to the data of the meshes
+	 * @return false if the file could not be parsed
+	 */
+	static bool importMeshes(const std::string &filePath, std::vector<MeshData> &meshes);
+
+	/**
+	 * @brief get the path of a texture of a model
+	 * @param modelPath the model file
+	 * @param texturePath the texture path relative to the model directory
+	 * @return the texture path relative to the working directory, empty if texturePath is empty
+	 */
+	static std::string getTexturePath(const std::string &modelPath, const std::string &texturePath);
+
+	/**
+	 * @brief stream the textures of geometries created from now on instead of loading them at once,
+	 * so creating a geometry mid-game does not stall the frame. the geometry shows placeholders until then.
+	 * @param textureStreamer_ the streamer, or nullptr to load textures at once
+	 */
+	static void setTextureStreamer(TextureStreamer *textureStreamer_);
+
+	/**
+	 * @brief get a texture from the cache shared with the geometries, or load it, streaming it if a streamer is set.
+	 * for textures not belonging to a model, e.g. of particle systems
+	 * @param texturePath the texture path relative to the working directory
+	 * @param alpha true if the image has an alpha channel
+	 * @return a pointer to the texture, nullptr if there is no opengl context
+	 */
+	static std::shared_ptr<Texture> requestTexture(const std::string &texturePath, bool alpha);
+
+	/**
+	 * @brief release the cached models and textures.
+	 * geometries still using them keep them alive until they are deleted.
+	 * must be called before the opengl context is destroyed.
+	 */
+	static void releaseLoadedAssets();
 
 };
 
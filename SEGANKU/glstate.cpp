@@ -0,0 +1,129 @@
+#include "glstate.h"
+
+GLuint GLState::program = GLState::UNKNOWN;
+GLuint GLState::vertexArray = GLState::UNKNOWN;
+GLuint GLState::framebuffer = GLState::UNKNOWN;
+GLuint GLState::activeTextureUnit = GLState::UNKNOWN;
+GLuint GLState::textures[GLState::TEXTURE_UNIT_COUNT] = {
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN
+};
+GLuint GLState::samplers[GLState::TEXTURE_UNIT_COUNT] = {
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN
+};
+GLint GLState::depthTest = -1;
+
+int GLState::issuedCallCount = 0;
+int GLState::skippedCallCount = 0;
+
+bool GLState::contextAvailable = true;
+
+void GLState::useProgram(GLuint program_)
+{
+	if (program == program_) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glUseProgram(program_);
+	program = program_;
+	issuedCallCount += 1;
+}
+
+void GLState::bindVertexArray(GLuint vertexArray_)
+{
+	if (vertexArray == vertexArray_) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glBindVertexArray(vertexArray_);
+	vertexArray = vertexArray_;
+	issuedCallCount += 1;
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer_)
+{
+	if (framebuffer == framebuffer_) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+	framebuffer = framebuffer_;
+	issuedCallCount += 1;
+}
+
+void GLState::activeTexture(GLuint unit)
+{
+	if (activeTextureUnit == unit) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	activeTextureUnit = unit;
+	issuedCallCount += 1;
+}
+
+void GLState::bindTexture(GLuint unit, GLuint texture)
+{
+	activeTexture(unit);
+
+	// units beyond the tracked ones are always bound
+	if (unit < TEXTURE_UNIT_COUNT && textures[unit] == texture) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if (unit < TEXTURE_UNIT_COUNT) {
+		textures[unit] = texture;
+	}
+	issuedCallCount += 1;
+}
+
+void GLState::bindSampler(GLuint unit, GLuint sampler)
+{
+	// units beyond the tracked ones are always bound
+	if (unit < TEXTURE_UNIT_COUNT && samplers[unit] == sampler) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	glBindSampler(unit, sampler);
+	if (unit < TEXTURE_UNIT_COUNT) {
+		samplers[unit] = sampler;
+	}
+	issuedCallCount += 1;
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+	if (depthTest == GLint(enabled)) {
+		skippedCallCount += 1;
+		return;
+	}
+
+	if (enabled) {
+		glEnable(GL_DEPTH_TEST);
+	} else {
+		glDisable(GL_DEPTH_TEST);
+	}
+	depthTest = enabled;
+	issuedCallCount += 1;
+}
+
+void GLState::invalidate()
+{
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	framebuffer = UNKNOWN;
+	activeTextureUnit = UNKNOWN;
+	for (int i = 0; i < TEXTURE_UNIT_COUNT; ++i) {
+		textures[i] = UNKNOWN;
+		samplers[i] = UNKNOWN;
+	}
+	depthTest = -1;
+}
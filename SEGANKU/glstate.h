@@ -0,0 +1,93 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+/**
+ * @brief GLState tracks the currently bound program, vertex array, textures and framebuffer
+ * of the opengl context, and skips bind or state calls if the value is already set.
+ * All binds of these objects should go through GLState, otherwise the cached state gets out of sync.
+ * If objects that might be bound are deleted, or bindings are changed directly, call invalidate().
+ */
+class GLState
+{
+	// value used for cached state that is not known, such that the next call is never skipped
+	static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+	static const int TEXTURE_UNIT_COUNT = 16;
+
+	static GLuint program;
+	static GLuint vertexArray;
+	static GLuint framebuffer;
+	static GLuint activeTextureUnit;
+	static GLuint textures[TEXTURE_UNIT_COUNT];
+	static GLuint samplers[TEXTURE_UNIT_COUNT];
+	static GLint depthTest;
+
+	GLState();
+
+public:
+
+	/**
+	 * @brief set the shader program as active program (glUseProgram)
+	 * @param program_ the program handle
+	 */
+	static void useProgram(GLuint program_);
+
+	/**
+	 * @brief bind the vertex array object (glBindVertexArray)
+	 * @param vertexArray_ the vao handle
+	 */
+	static void bindVertexArray(GLuint vertexArray_);
+
+	/**
+	 * @brief bind the framebuffer object to GL_FRAMEBUFFER (glBindFramebuffer)
+	 * @param framebuffer_ the fbo handle, 0 for the default framebuffer
+	 */
+	static void bindFramebuffer(GLuint framebuffer_);
+
+	/**
+	 * @brief select the active texture unit (glActiveTexture)
+	 * @param unit the texture unit, starting at 0 (not GL_TEXTURE0)
+	 */
+	static void activeTexture(GLuint unit);
+
+	/**
+	 * @brief activate the texture unit and bind the 2d texture to it.
+	 * the unit is always left active, so that texture parameter calls can follow.
+	 * @param unit the texture unit, starting at 0 (not GL_TEXTURE0)
+	 * @param texture the texture handle
+	 */
+	static void bindTexture(GLuint unit, GLuint texture);
+
+	/**
+	 * @brief bind the sampler object to the texture unit (glBindSampler).
+	 * a bound sampler overrides the sampling parameters of any texture bound to that unit.
+	 * @param unit the texture unit, starting at 0 (not GL_TEXTURE0)
+	 * @param sampler the sampler handle, 0 to use the texture parameters again
+	 */
+	static void bindSampler(GLuint unit, GLuint sampler);
+
+	/**
+	 * @brief enable or disable GL_DEPTH_TEST
+	 * @param enabled whether depth testing should be enabled
+	 */
+	static void setDepthTest(bool enabled);
+
+	/**
+	 * @brief forget all cached state, so that the next calls are issued in any case
+	 */
+	static void invalidate();
+
+	// the number of gl calls issued and skipped since the last reset
+	static int issuedCallCount;
+	static int skippedCallCount;
+
+	// false when running headless without an opengl context.
+	// objects owning gl resources then only keep their cpu side data.
+	static bool contextAvailable;
+
+};
+
+#endif // GLSTATE_H
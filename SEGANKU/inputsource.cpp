@@ -0,0 +1,177 @@
+#include "inputsource.h"
+
+#include <algorithm>
+#include <random>
+
+InputSource::~InputSource()
+{
+
+}
+
+
+QueuedInputSource::QueuedInputSource()
+	: cursorDelta(0)
+{
+	std::fill(keysDown, keysDown + GLFW_KEY_LAST + 1, false);
+}
+
+QueuedInputSource::~QueuedInputSource()
+{
+
+}
+
+void QueuedInputSource::pushKey(int key, bool pressed)
+{
+	if (key < 0 || key > GLFW_KEY_LAST) {
+		return; // unknown keys
+	}
+
+	Event event;
+	event.type = pressed ? Event::KEY_PRESS : Event::KEY_RELEASE;
+	event.key = key;
+	events.push(event);
+}
+
+void QueuedInputSource::pushCursorMove(const glm::vec2 &delta)
+{
+	Event event;
+	event.type = Event::CURSOR_MOVE;
+	event.delta = delta;
+	events.push(event);
+}
+
+void QueuedInputSource::pushScroll(double delta)
+{
+	Event event;
+	event.type = Event::SCROLL;
+	event.delta = glm::vec2(0, delta);
+	events.push(event);
+}
+
+void QueuedInputSource::processEvents(std::vector<int> &pressedKeys)
+{
+	// events that do not fit into the queue are dropped by push,
+	// at worst a key stays down until it is pressed and released again
+	Event event;
+	while (events.pop(event)) {
+		switch (event.type) {
+		case Event::KEY_PRESS:
+			keysDown[event.key] = true;
+			pressedKeys.push_back(event.key);
+			break;
+		case Event::KEY_RELEASE:
+			keysDown[event.key] = false;
+			break;
+		case Event::CURSOR_MOVE:
+			cursorDelta += event.delta;
+			break;
+		case Event::SCROLL:
+			scrollDelta += event.delta.y;
+			break;
+		}
+	}
+}
+
+bool QueuedInputSource::isKeyDown(int key)
+{
+	return key >= 0 && key <= GLFW_KEY_LAST && keysDown[key];
+}
+
+glm::vec2 QueuedInputSource::takeCursorDelta()
+{
+	glm::vec2 delta = cursorDelta;
+	cursorDelta = glm::vec2(0);
+	return delta;
+}
+
+double QueuedInputSource::takeScrollDelta()
+{
+	double delta = scrollDelta;
+	scrollDelta = 0.0;
+	return delta;
+}
+
+
+ScriptedInputSource::ScriptedInputSource(const std::vector<Segment> &segments_)
+	: segments(segments_)
+{
+
+}
+
+ScriptedInputSource::~ScriptedInputSource()
+{
+
+}
+
+std::vector<ScriptedInputSource::Segment> ScriptedInputSource::wanderScript()
+{
+	return {
+		{ 3.0f, { 'W' }, glm::vec2(0) },
+		{ 0.8f, { 'W', 'A' }, glm::vec2(-40, 0) },
+		{ 2.0f, { 'W', GLFW_KEY_LEFT_SHIFT }, glm::vec2(0) },
+		{ 1.0f, { }, glm::vec2(60, 10) },
+		{ 2.5f, { 'W' }, glm::vec2(0) },
+		{ 1.2f, { 'W', 'D' }, glm::vec2(30, -10) },
+		{ 1.5f, { 'S' }, glm::vec2(0) },
+		{ 0.5f, { 'D' }, glm::vec2(0) },
+	};
+}
+
+std::vector<ScriptedInputSource::Segment> ScriptedInputSource::randomScript(unsigned int seed, int segmentCount)
+{
+	const std::vector<std::vector<int>> keyChoices = {
+		{ 'W' }, { 'W' }, { 'W', 'A' }, { 'W', 'D' }, { 'W', GLFW_KEY_LEFT_SHIFT }, { 'S' }, { 'A' }, { 'D' }, { }
+	};
+
+	std::mt19937 randGen(seed);
+	std::uniform_real_distribution<float> durationDistribution(0.3f, 3.0f);
+	std::uniform_real_distribution<float> cursorDistribution(-60.0f, 60.0f);
+	std::uniform_int_distribution<int> keyDistribution(0, keyChoices.size() - 1);
+
+	std::vector<Segment> segments;
+	for (int i = 0; i < segmentCount; ++i) {
+		float duration = durationDistribution(randGen);
+		const std::vector<int> &keys = keyChoices[keyDistribution(randGen)];
+		// turn in every other segment
+		glm::vec2 cursorSpeed = (i % 2 == 0) ? glm::vec2(cursorDistribution(randGen), cursorDistribution(randGen) * 0.2f) : glm::vec2(0);
+		segments.push_back({ duration, keys, cursorSpeed });
+	}
+	return segments;
+}
+
+void ScriptedInputSource::advance(float timeDelta)
+{
+	if (segments.empty()) {
+		return;
+	}
+
+	segmentTime += timeDelta;
+	while (segmentTime >= segments[currentSegment].duration) {
+		segmentTime -= segments[currentSegment].duration;
+		currentSegment = (currentSegment + 1) % segments.size();
+	}
+
+	cursorDelta += segments[currentSegment].cursorSpeed * timeDelta;
+}
+
+bool ScriptedInputSource::isKeyDown(int key)
+{
+	if (segments.empty()) {
+		return false;
+	}
+
+	const std::vector<int> &keys = segments[currentSegment].keys;
+	return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+
+glm::vec2 ScriptedInputSource::takeCursorDelta()
+{
+	glm::vec2 delta = cursorDelta;
+	cursorDelta = glm::vec2(0);
+	return delta;
+}
+
+double ScriptedInputSource::takeScrollDelta()
+{
+	return 0.0;
+}
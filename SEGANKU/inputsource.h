@@ -0,0 +1,151 @@
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "spscqueue.h"
+
+/**
+ * @brief An InputSource provides the keyboard and mouse state the game logic reacts to.
+ * Keys are identified by their glfw key codes.
+ */
+class InputSource
+{
+public:
+	virtual ~InputSource();
+
+	/**
+	 * @param key the glfw key code
+	 * @return true if the key is currently held down
+	 */
+	virtual bool isKeyDown(int key) = 0;
+
+	/**
+	 * @brief get the mouse movement since the last call
+	 * @return the cursor displacement in pixels
+	 */
+	virtual glm::vec2 takeCursorDelta() = 0;
+
+	/**
+	 * @brief get the amount scrolled since the last call
+	 * @return the scroll delta on the vertical axis
+	 */
+	virtual double takeScrollDelta() = 0;
+};
+
+
+/**
+ * @brief A QueuedInputSource passes the input of the window, which glfw only lets the main thread read,
+ * to the game logic running on the simulation thread.
+ * The main thread pushes input events into a lock-free queue, the simulation thread applies them
+ * to the key state and the accumulated mouse movement with processEvents before simulating.
+ */
+class QueuedInputSource : public InputSource
+{
+public:
+	struct Event {
+		enum Type { KEY_PRESS, KEY_RELEASE, CURSOR_MOVE, SCROLL };
+
+		Type type;
+		int key;                // glfw key code of key events
+		glm::vec2 delta;        // cursor displacement in pixels, or the scroll delta in y
+	};
+
+	QueuedInputSource();
+	virtual ~QueuedInputSource();
+
+	/**
+	 * @brief queue a key event, for the main thread only
+	 * @param key the glfw key code
+	 * @param pressed true if the key has been pressed, false if released
+	 */
+	void pushKey(int key, bool pressed);
+
+	/**
+	 * @brief queue a mouse movement, for the main thread only
+	 * @param delta the cursor displacement in pixels
+	 */
+	void pushCursorMove(const glm::vec2 &delta);
+
+	/**
+	 * @brief queue a scroll event, for the main thread only
+	 * @param delta the scroll delta on the vertical axis
+	 */
+	void pushScroll(double delta);
+
+	/**
+	 * @brief apply the queued events to the input state, for the simulation thread only
+	 * @param pressedKeys the keys pressed since the last call are appended, to trigger actions
+	 */
+	void processEvents(std::vector<int> &pressedKeys);
+
+	virtual bool isKeyDown(int key);
+	virtual glm::vec2 takeCursorDelta();
+	virtual double takeScrollDelta();
+
+private:
+	SpscQueue<Event, 256> events;
+
+	// input state as seen by the simulation
+	bool keysDown[GLFW_KEY_LAST + 1];
+	glm::vec2 cursorDelta;          // mouse movement accumulated since the last read
+	double scrollDelta = 0.0;       // amount scrolled since the last read
+};
+
+
+/**
+ * @brief A ScriptedInputSource replays a looping sequence of input segments,
+ * each holding a set of keys and moving the mouse for a given simulated duration.
+ * It is used to drive the game without a window, e.g. for benchmarks and soak tests.
+ */
+class ScriptedInputSource : public InputSource
+{
+public:
+	struct Segment {
+		float duration;                 // simulated seconds the segment lasts
+		std::vector<int> keys;          // glfw key codes held down
+		glm::vec2 cursorSpeed;          // mouse movement in pixels per second
+	};
+
+	/**
+	 * @param segments_ the input segments, played in order and repeated
+	 */
+	ScriptedInputSource(const std::vector<Segment> &segments_);
+	virtual ~ScriptedInputSource();
+
+	/**
+	 * @brief a script wandering around the world, with turns, sprints and pauses
+	 * @return the script segments
+	 */
+	static std::vector<Segment> wanderScript();
+
+	/**
+	 * @brief a script of random movement, turns and pauses, as played by a random agent
+	 * @param seed the seed of the random generator, the same seed gives the same script
+	 * @param segmentCount the number of segments before the script repeats
+	 * @return the script segments
+	 */
+	static std::vector<Segment> randomScript(unsigned int seed, int segmentCount = 64);
+
+	/**
+	 * @brief advance the script
+	 * @param timeDelta simulated seconds passed since the last call
+	 */
+	void advance(float timeDelta);
+
+	virtual bool isKeyDown(int key);
+	virtual glm::vec2 takeCursorDelta();
+	virtual double takeScrollDelta();
+
+private:
+	std::vector<Segment> segments;
+	unsigned int currentSegment = 0;
+	float segmentTime = 0;          // time passed in the current segment
+	glm::vec2 cursorDelta;          // mouse movement accumulated since the last read
+};
+
+#endif // INPUTSOURCE_H
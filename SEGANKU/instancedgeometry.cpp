@@ -0,0 +1,207 @@
+#include "instancedgeometry.h"
+
+// the minimal number of instances culled by one job, a few matrix products and a 3x3 inverse each
+static const size_t INSTANCES_PER_JOB = 32;
+
+InstancedGeometry::InstancedGeometry(const std::vector<std::shared_ptr<Geometry>> &geometries_)
+	: geometries(geometries_)
+	, jobs(nullptr)
+{
+	if (!geometries.empty()) {
+		surfaces = geometries[0]->getSurfaces();
+	}
+
+	calculateBoundingSphere();
+
+	// setup instance buffer
+	// sends GL_STREAM_DRAW hint to GL implementation, since the data is rewritten each frame. data is assigned later.
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, geometries.size() * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+
+	// generate one vao per surface, using the vertex and index buffers of the surface
+	// and the per instance attributes from the shared instance buffer
+	vaos.resize(surfaces.size());
+	glGenVertexArrays(vaos.size(), vaos.data());
+
+	for (GLuint i = 0; i < surfaces.size(); ++i) {
+
+		GLState::bindVertexArray(vaos[i]);
+		surfaces[i]->setupVertexAttributes();
+
+		// a mat4 attribute occupies 4 consecutive locations (one per column), a mat3 attribute 3 locations.
+		// the divisor of 1 advances these attributes once per instance instead of once per vertex.
+		GLint modelMatAttribIndex  = 3;
+		GLint normalMatAttribIndex = 7;
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		for (GLint column = 0; column < 4; ++column) {
+			glEnableVertexAttribArray(modelMatAttribIndex + column);
+			glVertexAttribPointer(modelMatAttribIndex + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(offsetof(InstanceData, modelMat) + column * sizeof(glm::vec4)));
+			glVertexAttribDivisor(modelMatAttribIndex + column, 1);
+		}
+		for (GLint column = 0; column < 3; ++column) {
+			glEnableVertexAttribArray(normalMatAttribIndex + column);
+			glVertexAttribPointer(normalMatAttribIndex + column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(offsetof(InstanceData, normalMat) + column * sizeof(glm::vec3)));
+			glVertexAttribDivisor(normalMatAttribIndex + column, 1);
+		}
+	}
+
+	GLState::bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	visibleInstances.reserve(geometries.size());
+}
+
+InstancedGeometry::~InstancedGeometry()
+{
+	glDeleteBuffers(1, &instanceBuffer);
+	glDeleteVertexArrays(vaos.size(), vaos.data());
+	GLState::invalidate();
+}
+
+std::vector<std::shared_ptr<InstancedGeometry>> InstancedGeometry::groupByModel(const std::vector<std::shared_ptr<Geometry>> &geometries)
+{
+	std::vector<std::string> filePaths;
+	std::vector<std::vector<std::shared_ptr<Geometry>>> groups;
+
+	for (std::shared_ptr<Geometry> geometry : geometries) {
+
+		GLuint i = 0;
+		while (i < filePaths.size() && filePaths[i] != geometry->getFilePath()) {
+			++i;
+		}
+
+		if (i == filePaths.size()) {
+			filePaths.push_back(geometry->getFilePath());
+			groups.push_back(std::vector<std::shared_ptr<Geometry>>());
+		}
+
+		groups[i].push_back(geometry);
+	}
+
+	std::vector<std::shared_ptr<InstancedGeometry>> instancedGeometries;
+	for (const std::vector<std::shared_ptr<Geometry>> &group : groups) {
+		instancedGeometries.push_back(std::make_shared<InstancedGeometry>(group));
+	}
+
+	return instancedGeometries;
+}
+
+void InstancedGeometry::calculateBoundingSphere()
+{
+	boundingSphereCenter = glm::vec3(0);
+	boundingSphereRadius = 0;
+
+	if (surfaces.empty()) {
+		return;
+	}
+
+	// approximate center using the arithmetic mean of the surface bounding sphere centers
+	for (std::shared_ptr<const Surface> surface : surfaces) {
+		boundingSphereCenter += surface->getBoundingSphereCenter();
+	}
+	boundingSphereCenter /= surfaces.size();
+
+	// the radius must enclose all surface bounding spheres
+	for (std::shared_ptr<const Surface> surface : surfaces) {
+		float surfaceRadius = glm::distance(surface->getBoundingSphereCenter(), surface->getBoundingSphereFarthestPoint());
+		float distance = glm::distance(boundingSphereCenter, surface->getBoundingSphereCenter()) + surfaceRadius;
+		boundingSphereRadius = glm::max(boundingSphereRadius, distance);
+	}
+}
+
+void InstancedGeometry::updateInstances(bool useFrustumCulling, const glm::mat4 &viewProjMat)
+{
+	modelMatrices.clear();
+	captureModelMatrices(modelMatrices);
+	updateInstances(useFrustumCulling, viewProjMat, modelMatrices);
+}
+
+void InstancedGeometry::updateInstances(bool useFrustumCulling, const glm::mat4 &viewProjMat, const std::vector<glm::mat4> &modelMatrices_)
+{
+	// every instance is culled into its own slot, so the jobs write disjoint ranges
+	culledInstances.resize(modelMatrices_.size());
+	instanceVisible.resize(modelMatrices_.size());
+
+	auto cull = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const glm::mat4 &modelMat = modelMatrices_[i];
+
+			// view frustum culling using the bounding sphere of all surfaces
+			if (useFrustumCulling) {
+				glm::vec3 center = (modelMat * glm::vec4(boundingSphereCenter, 1)).xyz();
+				glm::vec3 farthestPoint = (modelMat * glm::vec4(boundingSphereCenter + glm::vec3(boundingSphereRadius, 0, 0), 1)).xyz();
+
+				if (!Camera::checkSphereInFrustum(center, farthestPoint, viewProjMat)) {
+					instanceVisible[i] = false;
+					continue;
+				}
+			}
+
+			culledInstances[i].modelMat = modelMat;
+			culledInstances[i].normalMat = glm::transpose(glm::inverse(glm::mat3(modelMat)));
+			instanceVisible[i] = true;
+		}
+	};
+
+	if (jobs) {
+		jobs->parallelFor(0, modelMatrices_.size(), INSTANCES_PER_JOB, cull);
+	}
+	else {
+		cull(0, modelMatrices_.size());
+	}
+
+	visibleInstances.clear();
+	for (size_t i = 0; i < culledInstances.size(); ++i) {
+		if (instanceVisible[i]) {
+			visibleInstances.push_back(culledInstances[i]);
+		}
+	}
+
+	if (visibleInstances.empty()) {
+		return;
+	}
+
+	// orphan the old buffer storage so the driver does not have to wait until previous draws are done,
+	// then copy the compacted visible instances to the start of the buffer
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, geometries.size() * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, visibleInstances.size() * sizeof(InstanceData), visibleInstances.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedGeometry::setJobSystem(JobSystem *jobs_)
+{
+	jobs = jobs_;
+}
+
+void InstancedGeometry::captureModelMatrices(std::vector<glm::mat4> &modelMatrices_) const
+{
+	for (const std::shared_ptr<Geometry> &geometry : geometries) {
+		modelMatrices_.push_back(geometry->getRenderMatrix());
+	}
+}
+
+size_t InstancedGeometry::getInstanceCount() const
+{
+	return geometries.size();
+}
+
+void InstancedGeometry::draw(Shader *shader)
+{
+	if (visibleInstances.empty()) {
+		return;
+	}
+
+	for (GLuint i = 0; i < surfaces.size(); ++i) {
+		Geometry::drawnSurfaceCount += visibleInstances.size();
+		surfaces[i]->drawInstanced(shader, vaos[i], visibleInstances.size());
+	}
+}
+
+GLsizei InstancedGeometry::getVisibleInstanceCount() const
+{
+	return visibleInstances.size();
+}
@@ -0,0 +1,132 @@
+#ifndef INSTANCEDGEOMETRY_H
+#define INSTANCEDGEOMETRY_H
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <memory>
+
+#include "geometry.h"
+#include "surface.h"
+#include "shader.h"
+#include "camera.h"
+#include "glstate.h"
+#include "jobsystem.h"
+
+/**
+ * @brief An InstancedGeometry draws many Geometry objects loaded from the same model file
+ * with one instanced draw call per surface, instead of one draw call per object and surface.
+ * The model and normal matrices of the visible instances are gathered into an instance buffer
+ * once per frame, then every pass draws from that buffer.
+ * note: the surfaces of the first geometry are used for all instances.
+ */
+class InstancedGeometry
+{
+	/**
+	 * @brief per instance data as stored in the instance buffer
+	 */
+	struct InstanceData {
+		glm::mat4 modelMat;
+		glm::mat3 normalMat;
+	};
+
+	// the geometries drawn as instances, all loaded from the same model file
+	std::vector<std::shared_ptr<Geometry>> geometries;
+
+	// the surfaces shared by all instances
+	std::vector<std::shared_ptr<const Surface>> surfaces;
+
+	// one vao per surface, combining the surface buffers with the instance buffer
+	std::vector<GLuint> vaos;
+
+	// per instance data of the visible instances, compacted after culling
+	std::vector<InstanceData> visibleInstances;
+
+	// per instance data and visibility of all instances, filled by the culling jobs before compacting
+	std::vector<InstanceData> culledInstances;
+	std::vector<char> instanceVisible;
+
+	// culls the instances in parallel if set
+	JobSystem *jobs;
+
+	// model matrices of the geometries, gathered by updateInstances if not passed in
+	std::vector<glm::mat4> modelMatrices;
+
+	// handle of the vram instance buffer
+	GLuint instanceBuffer;
+
+	// bounding sphere of all surfaces in model space, used to cull whole instances
+	glm::vec3 boundingSphereCenter;
+	float boundingSphereRadius;
+
+	/**
+	 * @brief calculate a bounding sphere enclosing the bounding spheres of all surfaces
+	 */
+	void calculateBoundingSphere();
+
+public:
+
+	/**
+	 * @brief create an instance buffer and the vaos for the given geometries
+	 * @param geometries_ the geometries to draw, must all be loaded from the same model file
+	 */
+	InstancedGeometry(const std::vector<std::shared_ptr<Geometry>> &geometries_);
+	~InstancedGeometry();
+
+	/**
+	 * @brief group geometries by their model file, so that each group can be drawn instanced
+	 * @param geometries the geometries to group
+	 * @return one InstancedGeometry per model file
+	 */
+	static std::vector<std::shared_ptr<InstancedGeometry>> groupByModel(const std::vector<std::shared_ptr<Geometry>> &geometries);
+
+	/**
+	 * @brief gather the matrices of the visible instances and copy them to the instance buffer.
+	 * call once per frame before drawing, after the geometries have been updated.
+	 * @param useFrustumCulling whether to skip instances outside the view frustum
+	 * @param viewProjMat the projection matrix times the view matrix used for view frustum culling
+	 */
+	void updateInstances(bool useFrustumCulling, const glm::mat4 &viewProjMat);
+
+	/**
+	 * @brief like updateInstances, but using model matrices captured before instead of reading the geometries,
+	 * e.g. when the geometries are updated on another thread.
+	 * @param modelMatrices_ the model matrices of the geometries, as returned by captureModelMatrices
+	 */
+	void updateInstances(bool useFrustumCulling, const glm::mat4 &viewProjMat, const std::vector<glm::mat4> &modelMatrices_);
+
+	/**
+	 * @brief append the current render matrices of all geometries, in the order used by updateInstances
+	 * @param modelMatrices_ the vector to append to
+	 */
+	void captureModelMatrices(std::vector<glm::mat4> &modelMatrices_) const;
+
+	/**
+	 * @return the number of geometries drawn as instances, visible or not
+	 */
+	size_t getInstanceCount() const;
+
+	/**
+	 * @brief draw all visible instances using given shader, with one draw call per surface.
+	 * note: the shader must support instancing (uniform bool instanced, instance attributes at location 3 and 7).
+	 * @param shader the compiled shader program to use for drawing
+	 */
+	void draw(Shader *shader);
+
+	/**
+	 * @brief set the job system to cull the instances and calculate their normal matrices with
+	 * @param jobs_ the job system to use, or nullptr to cull on the calling thread only
+	 */
+	void setJobSystem(JobSystem *jobs_);
+
+	/**
+	 * @brief get the number of instances drawn by draw()
+	 * @return the number of visible instances
+	 */
+	GLsizei getVisibleInstanceCount() const;
+
+};
+
+#endif // INSTANCEDGEOMETRY_H
@@ -0,0 +1,416 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+#include "tracer.h"
+
+/**
+ * @brief The JobSystem runs small jobs on a pool of worker threads.
+ * Every worker owns a queue: it pushes and pops jobs at the back of its own queue,
+ * and when that is empty it steals the oldest job from the front of another queue.
+ * Threads outside the pool (e.g. the main or the simulation thread) submit to a queue of their own.
+ *
+ * Jobs and the names of the workers are recorded by the Tracer.
+ *
+ * Jobs are forked into a TaskGroup and joined with wait, a waiting thread runs queued jobs
+ * itself instead of blocking, so groups may be nested and a pool without workers still works.
+ *
+ * Usage:
+ *     JobSystem::TaskGroup group;
+ *     jobs.run(group, [&]() { ... });
+ *     jobs.run(group, [&]() { ... });
+ *     jobs.wait(group);
+ *
+ *     jobs.parallelFor(0, items.size(), 64, [&](size_t begin, size_t end) { ... });
+ */
+class JobSystem
+{
+public:
+
+	/**
+	 * @brief a set of jobs that can be waited for together
+	 */
+	class TaskGroup
+	{
+		friend class JobSystem;
+		std::atomic<int> pendingJobs;
+
+	public:
+		TaskGroup() : pendingJobs(0) {}
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup &operator=(const TaskGroup&) = delete;
+	};
+
+	/**
+	 * @brief A ScratchAllocator hands out temporary memory by advancing an offset in large blocks.
+	 * Every thread has its own, see getScratch, so jobs can allocate without locking.
+	 * Memory is released all at once by resetting to a marker, most conveniently with a Scope.
+	 * note: no constructors or destructors are run, use it for plain data only.
+	 */
+	class ScratchAllocator
+	{
+		static const size_t BLOCK_SIZE = 256 * 1024;
+
+		struct Block {
+			std::unique_ptr<char[]> memory;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t currentBlock = 0;
+		size_t offset = 0;
+
+	public:
+		struct Marker {
+			size_t block;
+			size_t offset;
+		};
+
+		/**
+		 * @brief resets the allocator to the state at its construction when leaving the scope
+		 */
+		class Scope
+		{
+			ScratchAllocator &allocator;
+			Marker marker;
+
+		public:
+			explicit Scope(ScratchAllocator &allocator_) : allocator(allocator_), marker(allocator_.getMarker()) {}
+			~Scope() { allocator.reset(marker); }
+		};
+
+		/**
+		 * @brief allocate memory valid until the allocator is reset to an earlier marker
+		 * @param size the size in bytes
+		 * @param alignment the alignment in bytes, must be a power of two
+		 */
+		void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			while (currentBlock < blocks.size()) {
+				Block &block = blocks[currentBlock];
+				size_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+				if (alignedOffset + size <= block.size) {
+					offset = alignedOffset + size;
+					return block.memory.get() + alignedOffset;
+				}
+				// blocks behind the current one are kept after a reset, try to reuse them
+				++currentBlock;
+				offset = 0;
+			}
+
+			Block block;
+			block.size = (std::max)(BLOCK_SIZE, size + alignment);
+			block.memory.reset(new char[block.size]);
+			blocks.push_back(std::move(block));
+			currentBlock = blocks.size() - 1;
+			offset = 0;
+			return allocate(size, alignment);
+		}
+
+		/**
+		 * @brief allocate an uninitialized array of count elements
+		 */
+		template<typename Type>
+		Type *allocate(size_t count)
+		{
+			return static_cast<Type*>(allocate(count * sizeof(Type), alignof(Type)));
+		}
+
+		Marker getMarker() const
+		{
+			Marker marker = { currentBlock, offset };
+			return marker;
+		}
+
+		/**
+		 * @brief release everything allocated after the marker was taken
+		 */
+		void reset(const Marker &marker)
+		{
+			currentBlock = marker.block;
+			offset = marker.offset;
+		}
+	};
+
+	/**
+	 * @brief start the worker threads
+	 * @param workerCount the number of worker threads, with 0 all jobs run on the threads waiting for them
+	 */
+	explicit JobSystem(int workerCount = getDefaultWorkerCount())
+		: running(true)
+		, queuedJobs(0)
+		, sleepingWorkers(0)
+		, workerJobCount(0)
+	{
+		// the last queue is shared by all threads outside the pool
+		for (int i = 0; i < workerCount + 1; ++i) {
+			queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+		}
+		for (int i = 0; i < workerCount; ++i) {
+			workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+		}
+	}
+
+	/**
+	 * @brief stop the worker threads, all task groups must have been waited for
+	 */
+	~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			running = false;
+		}
+		wakeUp.notify_all();
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem &operator=(const JobSystem&) = delete;
+
+	/**
+	 * @brief one worker per hardware thread, leaving one for the thread submitting the jobs
+	 */
+	static int getDefaultWorkerCount()
+	{
+		return (std::max)(int(std::thread::hardware_concurrency()) - 1, 1);
+	}
+
+	int getWorkerCount() const
+	{
+		return int(workers.size());
+	}
+
+	/**
+	 * @brief queue a job, it may run on any thread of the pool or on a thread waiting for a group
+	 * @param group the group to add the job to
+	 * @param job the function to run
+	 */
+	void run(TaskGroup &group, std::function<void()> job)
+	{
+		++group.pendingJobs;
+
+		WorkQueue &queue = *queues[getQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(Job(std::move(job), &group));
+		}
+
+		// the sleep mutex is only taken if a worker sleeps. a worker counts itself as sleeping before it checks
+		// queuedJobs, so either it sees this job or this thread sees it sleeping and wakes it up
+		++queuedJobs;
+		if (sleepingWorkers > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wakeUp.notify_one();
+		}
+	}
+
+	/**
+	 * @brief wait until all jobs of the group have finished, running queued jobs in the meantime
+	 */
+	void wait(TaskGroup &group)
+	{
+		int queueIndex = getQueueIndex();
+		while (group.pendingJobs > 0) {
+			if (!runQueuedJob(queueIndex)) {
+				// the remaining jobs of the group are running on other threads
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/**
+	 * @brief call body for consecutive subranges of [begin, end) in parallel and wait for all of them
+	 * @param grainSize the minimal number of elements per job, ranges not larger than this run directly
+	 * @param body function taking the begin and end index of a subrange
+	 */
+	template<typename Function>
+	void parallelFor(size_t begin, size_t end, size_t grainSize, const Function &body)
+	{
+		if (end <= begin) {
+			return;
+		}
+
+		size_t count = end - begin;
+		grainSize = (std::max)(grainSize, size_t(1));
+		if (count <= grainSize || workers.empty()) {
+			body(begin, end);
+			return;
+		}
+
+		// a few jobs per thread, so threads finishing early can steal the rest
+		size_t maxJobCount = 4 * (workers.size() + 1);
+		size_t jobSize = (std::max)(grainSize, (count + maxJobCount - 1) / maxJobCount);
+
+		TaskGroup group;
+		for (size_t jobBegin = begin + jobSize; jobBegin < end; jobBegin += jobSize) {
+			size_t jobEnd = (std::min)(jobBegin + jobSize, end);
+			run(group, [&body, jobBegin, jobEnd]() { body(jobBegin, jobEnd); });
+		}
+
+		// the first subrange runs on the calling thread
+		body(begin, (std::min)(begin + jobSize, end));
+		wait(group);
+	}
+
+	/**
+	 * @brief get the number of jobs run by the worker threads so far, as opposed to threads waiting for a group.
+	 * reset it to count per frame, e.g. to see whether a parallelFor actually runs on the workers
+	 */
+	int getWorkerJobCount() const
+	{
+		return workerJobCount;
+	}
+
+	void resetWorkerJobCount()
+	{
+		workerJobCount = 0;
+	}
+
+	/**
+	 * @brief get the scratch allocator of the calling thread
+	 */
+	static ScratchAllocator &getScratch()
+	{
+		static thread_local ScratchAllocator scratch;
+		return scratch;
+	}
+
+private:
+
+	struct Job {
+		std::function<void()> function;
+		TaskGroup *group;
+
+		Job() : group(nullptr) {}
+		Job(std::function<void()> function_, TaskGroup *group_) : function(std::move(function_)), group(group_) {}
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	// workers sleep while no jobs are queued, running is guarded by sleepMutex
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool running;
+	std::atomic<int> queuedJobs;
+	std::atomic<int> sleepingWorkers;
+
+	std::atomic<int> workerJobCount;
+
+	/**
+	 * @brief the job system and queue index of the calling thread, if it is a worker
+	 */
+	struct WorkerInfo {
+		const JobSystem *jobSystem;
+		int queueIndex;
+	};
+
+	static WorkerInfo &getWorkerInfo()
+	{
+		static thread_local WorkerInfo info = { nullptr, -1 };
+		return info;
+	}
+
+	/**
+	 * @brief the queue of the calling thread, threads outside the pool share the last one
+	 */
+	int getQueueIndex() const
+	{
+		const WorkerInfo &info = getWorkerInfo();
+		return info.jobSystem == this ? info.queueIndex : int(queues.size()) - 1;
+	}
+
+	/**
+	 * @brief take the newest job of the own queue or steal the oldest job of another one
+	 */
+	bool takeJob(int queueIndex, Job &job)
+	{
+		{
+			WorkQueue &queue = *queues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty()) {
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				return true;
+			}
+		}
+
+		for (size_t i = 1; i < queues.size(); ++i) {
+			WorkQueue &queue = *queues[(queueIndex + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty()) {
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief run one queued job
+	 * @return false if no job was queued
+	 */
+	bool runQueuedJob(int queueIndex)
+	{
+		Job job;
+		if (!takeJob(queueIndex, job)) {
+			return false;
+		}
+
+		--queuedJobs;
+		if (queueIndex < int(workers.size())) {
+			++workerJobCount;
+		}
+
+		{
+			Tracer::Scope scope("job");
+			job.function();
+		}
+		--job.group->pendingJobs;
+		return true;
+	}
+
+	void workerLoop(int queueIndex)
+	{
+		WorkerInfo &info = getWorkerInfo();
+		info.jobSystem = this;
+		info.queueIndex = queueIndex;
+		Tracer::setThreadName("worker " + std::to_string(queueIndex + 1));
+
+		while (true) {
+			if (runQueuedJob(queueIndex)) {
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			++sleepingWorkers;
+			wakeUp.wait(lock, [this]() { return queuedJobs > 0 || !running; });
+			--sleepingWorkers;
+			if (!running) {
+				return;
+			}
+		}
+	}
+};
+
+#endif // JOBSYSTEM_H
@@ -13,49 +13,62 @@
 
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <iomanip>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <random>
+#include <chrono>
 #include <ctime>
+#include <thread>
 
 #include "shader.h"
-#include "sceneobject.h"
-#include "camera.h"
-#include "player.h"
-#include "eagle.h"
-#include "light.h"
+#include "glstate.h"
+#include "framedata.h"
+#include "instancedgeometry.h"
 #include "textrenderer.h"
 #include "effects/ssaopostprocessor.h"
-#include "effects/particlesystem.h"
-#include "poissondisksampler.h"
-#include "simpledebugdrawer.h"
-#include "physics.h"
+#include "inputsource.h"
+#include "gameworld.h"
+#include "batchrunner.h"
+#include "simulationthread.h"
+#include "jobsystem.h"
+#include "profiler.h"
+#include "frametimerecorder.h"
+#include "tracer.h"
+#include "camerapath.h"
+#include "assetpack.h"
+#include "texturestreamer.h"
 
 void init(GLFWwindow *window);
-void initWorldBounds(float &miX, float &maX, float &miY, float &maY);
-float terrainGetYCoord(glm::vec2 pos2D, float maxDistanceXY, float offsetY);
+void drawFrame(double deltaT);
+void resetFrameCounters();
 void initSM();
 void initVSM();
 void initPCFSM();
 void initVSMBlur();
-void shadowFirstPass(glm::mat4 &lightViewPro);
+glm::mat4 calculateLightViewProjection();
+void shadowFirstPass();
 void vsmBlurPass();
 void debugShadowPass();
 void ssaoFirstPass();
 void finalDrawPass();
-void initPhysicsObjects();
-void update(float timeDelta);
 void setActiveShader(Shader *shader);
 void drawScene();
 void drawText(double deltaT, int windowWidth, int windowHeight);
+void drawProfilerOverlay(int windowWidth, int windowHeight);
+std::string describeRenderSettings();
 void cleanup();
-void newGame();
+int runHeadless(double simulatedSeconds);
+int runBatch(int gameCount, int threadCount, BatchRunner::Agent agent, const std::string &outputPath, bool scaling);
+int runBenchmark();
+void recordCameraPath(double time);
 
 GLFWwindow *window;
 int windowWidth, windowHeight;
 bool running			       = true;
-bool paused				       = false;
 bool debugInfoEnabled          = true;
 bool wireframeEnabled          = false;
 bool ssaoEnabled		       = true;
@@ -66,28 +79,62 @@ bool renderShadowMap	       = false;
 bool frustumCullingEnabled     = false;
 bool useAlpha				   = false;
 
+int uniformLookupsAvoidedLastFrame = 0;
+int glCallsIssuedLastFrame = 0;
+int glCallsSkippedLastFrame = 0;
+int workerJobsLastFrame = 0;
+int physicsThreads = 1;
+int physicsStressBodies = 0;
+unsigned int seed = (unsigned int)time(nullptr);
+
 Texture::FilterType filterType = Texture::LINEAR_MIPMAP_LINEAR;
 
 Shader *textureShader, *depthMapShader, *vsmDepthMapShader, *debugDepthShader, *blurVSMDepthShader;
 Shader *activeShader;
 TextRenderer *textRenderer;
-ParticleSystem *particleSystem;
 SSAOPostprocessor *ssaoPostprocessor;
-
-Player *player; glm::mat4 playerInitTransform(glm::scale(glm::mat4(1.0f), glm::vec3(0.5, 0.5, 0.5)));
-Eagle *eagle; glm::mat4 eagleInitTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0, 30, -45)));
-
-Geometry *terrain, *cave;
-
+FrameData *frameData;
+JobSystem *jobSystem;
+TextureStreamer *textureStreamer;
+Profiler *profiler;
+FrameTimeRecorder *frameTimeRecorder;
+double frameBudget = 1000.0 / 60.0; // ms
+std::string frameTimesOutput = "frame_times.csv";
+
+// the benchmark renders a world that stands still along a camera path, once for every combination of render settings.
+// the seganku_bench target always runs it, the game only with --bench
+#ifdef SEGANKU_BENCHMARK
+bool benchmarkMode = true;
+#else
+bool benchmarkMode = false;
+#endif
+std::string benchPathFile;          // the camera path to fly, a path circling the terrain if empty
+std::string benchOutput = "bench_results.csv";
+float sceneScale = 1.0f;            // factor for the number of carrots, trees and shrubs
+SceneSnapshot benchScene;           // the state rendered by the benchmark, its camera follows the path
+
+// load the models of the world on the worker threads before creating it, otherwise the world loads them one after another.
+// the startup time is printed either way, so both can be compared
+bool parallelLoading = true;
+
+// the camera path recorded while playing, if a file to record to is given
+std::string recordPathFile;
+CameraPath *recordedPath;
+
+// the simulated game state, the objects below are owned by the world.
+// while the simulation thread runs, rendering only reads the latest snapshot,
+// the surfaces of player and eagle and the projection of the camera.
+GameWorld *world;
+QueuedInputSource *input;
+SimulationThread *simulationThread;
+const SceneSnapshot *scene;
+Player *player;
+Eagle *eagle;
 Camera *camera;
-Light *sun;
-const glm::vec3 LIGHT_START(glm::vec3(-100, 150, 0));
-const glm::vec3 LIGHT_END(glm::vec3(20, 150, 0));
 
-std::vector<std::shared_ptr<Geometry>> carrots;
-std::vector<std::shared_ptr<Geometry>> trees;
-std::vector<std::shared_ptr<Geometry>> shrubs;
-const float timeToStarvation = 60;
+std::vector<std::shared_ptr<InstancedGeometry>> instancedCarrots;
+std::vector<std::shared_ptr<InstancedGeometry>> instancedTrees;
+std::vector<std::shared_ptr<InstancedGeometry>> instancedShrubs;
 
 // Shadow Map FBO and depth texture
 GLuint depthMapFBO, vsmDepthMapFBO;
@@ -98,12 +145,27 @@ GLuint pingpongColorMap;
 const int SM_WIDTH = 1024, SM_HEIGHT = 1024;
 const GLfloat NEAR_PLANE = 75.f, FAR_PLANE = 250.f;
 
-void frameBufferResize(GLFWwindow *window, int width, int height);
-void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
+// the number of frames the frame time statistics are calculated over and written to csv
+const int FRAME_HISTORY_LENGTH = 3600;
+
+// benchmark frames are rendered at a fixed step along the camera path, after some frames to warm up
+const int BENCH_FRAMES_PER_SECOND = 60;
+const int BENCH_WARMUP_FRAMES = 60;
+const float BENCH_DEFAULT_PATH_DURATION = 30.0f; // s
+const unsigned int BENCH_DEFAULT_SEED = 1;
+
+// the interval in which the camera is sampled while recording a path
+const double RECORD_PATH_INTERVAL = 0.25; // s
 
-// PHYSICS
+// the bytes of texture data uploaded per frame at most while streaming textures
+const size_t TEXTURE_STREAM_BUDGET = 2 * 1024 * 1024;
 
-Physics *physics;
+// the asset pack used if it exists, assets not in the pack are read from the loose files
+const std::string ASSET_PACK_FILE = "seganku.pack";
+
+void frameBufferResize(GLFWwindow *window, int width, int height);
+void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
+void scrollCallback(GLFWwindow *window, double deltaX, double deltaY);
 
 // ONLY FOR SEBAS DEBUGGING
 GLuint quadVAO = 0;
@@ -122,7 +184,7 @@ void RenderQuad()
 		// Setup plane VAO
 		glGenVertexArrays(1, &quadVAO);
 		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
+		GLState::bindVertexArray(quadVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
@@ -130,9 +192,8 @@ void RenderQuad()
 		glEnableVertexAttribArray(1);
 		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
 	}
-	glBindVertexArray(quadVAO);
+	GLState::bindVertexArray(quadVAO);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
 }
 // SEBAS DEBUGGING END
 
@@ -147,17 +208,123 @@ int main(int argc, char **argv)
     windowHeight = 600;
 	int refresh_rate = 60;
     bool fullscreen = 0;
+	bool headless = false;
+	double headlessSeconds = 600;
+	int batchGames = 0;
+	int batchThreads = (std::max)(int(std::thread::hardware_concurrency()), 1);
+	BatchRunner::Agent batchAgent = BatchRunner::SCRIPTED_AGENT;
+	std::string batchOutput = "batch_results.csv";
+	bool batchScaling = false;
+	unsigned int traceFirstFrame = 0, traceLastFrame = 0;
+	std::string traceOutput = "trace.json";
+	bool traceEnabled = false;
+	bool seedGiven = false;
+	std::string assetPackFile = ASSET_PACK_FILE;
+	bool assetPackGiven = false;
+
+	// options start with -- and take one value, the remaining parameters are positional
+	std::vector<std::string> positionalArgs;
+	bool validArgs = true;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--physics-threads" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> physicsThreads).fail() && physicsThreads > 0;
+		} else if (arg == "--physics-stress" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> physicsStressBodies).fail() && physicsStressBodies >= 0;
+		} else if (arg == "--headless") {
+			headless = true;
+		} else if (arg == "--headless-seconds" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> headlessSeconds).fail() && headlessSeconds > 0;
+		} else if (arg == "--seed" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> seed).fail();
+			seedGiven = true;
+		} else if (arg == "--batch" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> batchGames).fail() && batchGames > 0;
+		} else if (arg == "--batch-threads" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> batchThreads).fail() && batchThreads > 0;
+		} else if (arg == "--batch-agent" && i+1 < argc) {
+			std::string agentName = argv[++i];
+			validArgs &= agentName == "scripted" || agentName == "random";
+			batchAgent = (agentName == "random") ? BatchRunner::RANDOM_AGENT : BatchRunner::SCRIPTED_AGENT;
+		} else if (arg == "--batch-output" && i+1 < argc) {
+			batchOutput = argv[++i];
+		} else if (arg == "--batch-scaling") {
+			batchScaling = true;
+		} else if (arg == "--frame-budget" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> frameBudget).fail() && frameBudget > 0;
+		} else if (arg == "--frame-times" && i+1 < argc) {
+			frameTimesOutput = argv[++i];
+		} else if (arg == "--trace-frames" && i+1 < argc) {
+			// a range of frames in the form first-last
+			char separator = 0;
+			std::stringstream range(argv[++i]);
+			validArgs &= !(range >> traceFirstFrame >> separator >> traceLastFrame).fail() && separator == '-' && traceFirstFrame <= traceLastFrame;
+			traceEnabled = true;
+		} else if (arg == "--trace-output" && i+1 < argc) {
+			traceOutput = argv[++i];
+		} else if (arg == "--bench") {
+			benchmarkMode = true;
+		} else if (arg == "--bench-path" && i+1 < argc) {
+			benchPathFile = argv[++i];
+		} else if (arg == "--bench-output" && i+1 < argc) {
+			benchOutput = argv[++i];
+		} else if (arg == "--scene-scale" && i+1 < argc) {
+			validArgs &= !(std::stringstream(argv[++i]) >> sceneScale).fail() && sceneScale > 0;
+		} else if (arg == "--record-path" && i+1 < argc) {
+			recordPathFile = argv[++i];
+		} else if (arg == "--serial-loading") {
+			parallelLoading = false;
+		} else if (arg == "--asset-pack" && i+1 < argc) {
+			assetPackFile = argv[++i];
+			assetPackGiven = true;
+		} else if (arg.compare(0, 2, "--") == 0) {
+			validArgs = false;
+		} else {
+			positionalArgs.push_back(arg);
+		}
+	}
 
-	if (argc == 1) {
+	if (positionalArgs.empty()) {
 		// no parameters specified, continue with default values
 
-	} else if (argc != 4 || (std::stringstream(argv[1]) >> windowWidth).fail() || (std::stringstream(argv[2]) >> windowHeight).fail() || (std::stringstream(argv[3]) >> fullscreen).fail()) {
+	} else if (positionalArgs.size() != 3 || (std::stringstream(positionalArgs[0]) >> windowWidth).fail() || (std::stringstream(positionalArgs[1]) >> windowHeight).fail() || (std::stringstream(positionalArgs[2]) >> fullscreen).fail()) {
 		// if parameters are specified, must conform to given format
+		validArgs = false;
+	}
+
+	if (!validArgs) {
+		std::cout << "USAGE: [<resolution width> <resolution height> <fullscreen? 0/1>] [--physics-threads <count>] [--physics-stress <body count>] [--headless] [--headless-seconds <simulated seconds>] [--seed <seed>]\n"
+		          << "       [--batch <game count>] [--batch-threads <count>] [--batch-agent <scripted/random>] [--batch-output <csv file>] [--batch-scaling]\n"
+		          << "       [--frame-budget <ms>] [--frame-times <csv file>] [--trace-frames <first>-<last>, 0 includes loading] [--trace-output <json file>]\n"
+		          << "       [--bench] [--bench-path <camera path file>] [--bench-output <csv file>] [--scene-scale <object count factor>] [--record-path <camera path file>]\n"
+		          << "       [--asset-pack <pack file>] [--serial-loading]\n";
+		exit(EXIT_FAILURE);
+	}
+
+	// benchmark runs are only comparable with the same world
+	if (benchmarkMode && !seedGiven) {
+		seed = BENCH_DEFAULT_SEED;
+	}
 
-		std::cout << "USAGE: <resolution width> <resolution height> <fullscreen? 0/1>\n";
+	// OPEN ASSET PACK
+
+	if (AssetPack::open(assetPackFile)) {
+		std::cout << "using asset pack: " << assetPackFile << std::endl;
+	} else if (assetPackGiven) {
+		std::cerr << "ERROR: could not open asset pack " << assetPackFile << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
+	// RUN WITHOUT WINDOW
+
+	if (batchGames > 0) {
+		exit(runBatch(batchGames, batchThreads, batchAgent, batchOutput, batchScaling));
+	}
+
+	if (headless) {
+		exit(runHeadless(headlessSeconds));
+	}
+
 	// INIT WINDOW AND OPENGL CONTEXT
 
 	if (!glfwInit()) {
@@ -208,93 +375,82 @@ int main(int argc, char **argv)
 	// set callbacks
 	glfwSetFramebufferSizeCallback(window, frameBufferResize);
 	glfwSetKeyCallback(window, keyCallback);
+	glfwSetScrollCallback(window, scrollCallback);
+
+	// a trace starting at frame 0 includes loading the world
+	Tracer::setThreadName("main");
+	if (traceEnabled) {
+		Tracer::setCapture(traceFirstFrame, traceLastFrame, traceOutput);
+	}
 
 	// all initializations happen here
-	init(window);
+	{
+		Tracer::Scope scope("init");
+		std::chrono::steady_clock::time_point initStart = std::chrono::steady_clock::now();
+		init(window);
+		std::cout << "startup: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count() << " ms"
+		          << (parallelLoading ? " (parallel loading)" : " (serial loading)") << std::endl;
+	}
+
+	if (benchmarkMode) {
+		int exitCode = runBenchmark();
+		cleanup();
+		glfwTerminate();
+		exit(exitCode);
+	}
 
 	//////////////////////////
 	/// MAIN LOOP
 	//////////////////////////
 
-	double time = 0.0;
-	double lastTime = 0.0;
+	double time = glfwGetTime(); // seconds
+	double lastTime = time;
 	double deltaT = 0.0;
 
 	while (running && !glfwWindowShouldClose(window)) {
 
-		if (glfwGetTime() < lastTime) {
-			lastTime = 0;
-		}
-		time = glfwGetTime(); // seconds
-		deltaT = time - lastTime;
-		lastTime = time;
-
-		// glUseProgram calls are rather expensive state changes, so try to keep to a minimum
-		// if more shaders are used for different objects, restructuring of these calls will be necessary
-		// since a lot of other calls depend on the currently bound shader
-		setActiveShader(textureShader);
+		profiler->beginFrame();
+		Tracer::beginFrame();
+		Tracer::Scope frameScope("frame");
 
 		//////////////////////////
 		/// UPDATE
 		//////////////////////////
-		if (!paused) {
-
-			physics->stepSimulation(deltaT);
-			update(deltaT);
+		// the simulation runs on its own thread, draw the latest state it has published
+		bool newSnapshot = simulationThread->acquireSnapshot();
+		scene = &simulationThread->getSnapshot();
+		if (newSnapshot) {
+			// the physics step runs on the simulation thread, so its time is taken from the snapshot
+			profiler->addCpuTime("physics step", scene->physicsStepTime);
+		}
 
-			// pause on starvation or if player eaten by eagle
-			if (eagle->isTargetEaten() || glfwGetTime() > timeToStarvation-1) {
-				player->rotateZ(3.14159/2, SceneObject::RIGHT);
-				player->translate(glm::vec3(0, 0.3, 0), SceneObject::LEFT);
-				paused = true;
-			}
+		if (recordedPath) {
+			recordCameraPath(time);
 		}
 
+		{
+			Profiler::Scope scope(profiler, "texture streaming");
+			textureStreamer->update();
+		}
 
 		//////////////////////////
 		/// DRAW
 		//////////////////////////
-
-		//// SHADOW MAP PASS
-		// calculate lights projection and view Matrix
-		glm::mat4 lightVP;
-
-		if (shadowsEnabled) {
-			shadowFirstPass(lightVP);
-		}
-
-		// Prepare lighting shader and set matrices
-		setActiveShader(textureShader);
-		glUniformMatrix4fv(glGetUniformLocation(activeShader->programHandle, "viewMat"), 1, GL_FALSE, glm::value_ptr(player->getViewMat()));
-		glUniformMatrix4fv(glGetUniformLocation(activeShader->programHandle, "lightVP"), 1, GL_FALSE, glm::value_ptr(lightVP));
-
-		//if (vsmShadowsEnabled) {
-			glUniform1i(glGetUniformLocation(activeShader->programHandle, "shadowMap"), 1);
-			glActiveTexture(GL_TEXTURE0 + 1);
-			glBindTexture(GL_TEXTURE_2D, vsmDepthMap);
-		/*}
-		else {
-			glUniform1i(glGetUniformLocation(activeShader->programHandle, "shadowMap"), 1);
-			glActiveTexture(GL_TEXTURE0 + 1);
-			glBindTexture(GL_TEXTURE_2D, depthMap);
-		}*/
-
-		//// SSAO PrePass (if enabled)
-		ssaoFirstPass();
-
-		//// FINAL PASS
-		//// draw with shadow mapping and ssao
-		finalDrawPass();
-
-		// draw shadow map for debugging (if enabled)
-		debugShadowPass();
-
-		particleSystem->draw(player->getViewMat(), player->getProjMat(), glm::vec3(1, 0.55, 0.5));
-
-		drawText(deltaT, windowWidth, windowHeight);
+		drawFrame(deltaT);
 
 		// end the current frame (swaps the front and back buffers)
 		glfwSwapBuffers(window);
+		resetFrameCounters();
+
+		// a frame lasts from one buffer swap to the next, it is recorded with the phases and settings it was drawn with.
+		// its duration is also the time step of the next frame
+		if (glfwGetTime() < lastTime) {
+			lastTime = 0;
+		}
+		time = glfwGetTime();
+		deltaT = time - lastTime;
+		lastTime = time;
+		frameTimeRecorder->recordFrame(deltaT * 1000, *profiler, describeRenderSettings());
 
 
 		//////////////////////////
@@ -308,6 +464,14 @@ int main(int argc, char **argv)
 
 		glfwPollEvents();
 
+		// the mouse pointer is reset to (0, 0) after every read, so the position is the displacement
+		double mouseX, mouseY;
+		glfwGetCursorPos(window, &mouseX, &mouseY);
+		glfwSetCursorPos(window, 0, 0); // reset the mouse, so it doesn't leave the window
+		if (mouseX != 0 || mouseY != 0) {
+			input->pushCursorMove(glm::vec2(mouseX, mouseY));
+		}
+
 		if (running) {
 			running = !glfwGetKey(window, GLFW_KEY_ESCAPE);
 		}
@@ -322,10 +486,404 @@ int main(int argc, char **argv)
 }
 
 
+/**
+ * @brief draw the current scene with all enabled passes, the particles and the text
+ * @param deltaT the time since the last frame in seconds, shown in the debug info
+ */
+void drawFrame(double deltaT)
+{
+	// glUseProgram calls are rather expensive state changes, so try to keep to a minimum
+	// if more shaders are used for different objects, restructuring of these calls will be necessary
+	// since a lot of other calls depend on the currently bound shader.
+	// note that redundant calls are skipped by GLState anyway.
+	setActiveShader(textureShader);
+
+	// SET MATERIAL IN SHADERS
+	// light position and color are passed with the FrameData block
+	activeShader->uniform("material.specular").set(glm::vec3(0.2f, 0.2f, 0.2f));
+
+	//// FRAME DATA
+	// upload camera, light and shadow data shared by all shaders once per frame
+	frameData->setCamera(scene->viewMat, scene->projMat, scene->cameraLocation);
+	frameData->setLight(calculateLightViewProjection(), scene->lightLocation, scene->lightColor * 0.3f, scene->lightColor, scene->lightColor * 0.8f);
+	frameData->upload();
+
+	//// INSTANCE DATA
+	// gather visible instances once per frame, all passes draw from the same instance buffers
+	// carrots move when eaten, so their matrices are taken from the snapshot. trees and shrubs never move.
+	// culling only uses the matrices of the snapshot, the camera itself belongs to the simulation thread
+	glm::mat4 viewProjMat = scene->projMat * scene->viewMat;
+	std::vector<glm::mat4>::const_iterator carrotMatrix = scene->carrotMatrices.begin();
+	for (std::shared_ptr<InstancedGeometry> group : instancedCarrots) {
+		std::vector<glm::mat4> groupMatrices(carrotMatrix, carrotMatrix + group->getInstanceCount());
+		group->updateInstances(frustumCullingEnabled, viewProjMat, groupMatrices);
+		carrotMatrix += group->getInstanceCount();
+	}
+	for (std::shared_ptr<InstancedGeometry> group : instancedTrees) group->updateInstances(frustumCullingEnabled, viewProjMat);
+	for (std::shared_ptr<InstancedGeometry> group : instancedShrubs) group->updateInstances(frustumCullingEnabled, viewProjMat);
+
+	//// SHADOW MAP PASS
+	if (shadowsEnabled) {
+		{
+			Profiler::Scope scope(profiler, "shadow pass");
+			shadowFirstPass();
+		}
+		if (vsmShadowsEnabled) {
+			Profiler::Scope scope(profiler, "vsm blur pass");
+			vsmBlurPass();
+		}
+	}
+
+	// Prepare lighting shader
+	setActiveShader(textureShader);
+
+	//if (vsmShadowsEnabled) {
+		activeShader->uniform("shadowMap").set(1);
+		GLState::bindTexture(1, vsmDepthMap);
+	/*}
+	else {
+		activeShader->uniform("shadowMap").set(1);
+		GLState::bindTexture(1, depthMap);
+	}*/
+
+	//// SSAO PrePass (if enabled)
+	if (ssaoEnabled) {
+		Profiler::Scope scope(profiler, "ssao pass");
+		ssaoFirstPass();
+	}
+
+	//// FINAL PASS
+	//// draw with shadow mapping and ssao
+	{
+		Profiler::Scope scope(profiler, "final pass");
+		finalDrawPass();
+	}
+
+	// draw shadow map for debugging (if enabled)
+	debugShadowPass();
+
+	{
+		Profiler::Scope scope(profiler, "particles");
+		world->getParticleSystem()->draw(glm::vec3(1, 0.55, 0.5), scene->particleMatrix, scene->particleInstanceData);
+	}
+
+	{
+		Profiler::Scope scope(profiler, "text");
+		drawText(deltaT, windowWidth, windowHeight);
+	}
+}
+
+
+/**
+ * @brief take the statistics of the frame just finished and reset the counters for the next one
+ */
+void resetFrameCounters()
+{
+	uniformLookupsAvoidedLastFrame = Shader::avoidedLookupCount;
+	Shader::avoidedLookupCount = 0;
+	glCallsIssuedLastFrame = GLState::issuedCallCount;
+	glCallsSkippedLastFrame = GLState::skippedCallCount;
+	GLState::issuedCallCount = 0;
+	GLState::skippedCallCount = 0;
+	workerJobsLastFrame = jobSystem->getWorkerJobCount();
+	jobSystem->resetWorkerJobCount();
+}
+
+
+/**
+ * @brief add the camera of the current snapshot to the recorded path, at most once per RECORD_PATH_INTERVAL
+ * @param time the time since the start of the game in seconds
+ */
+void recordCameraPath(double time)
+{
+	static double lastRecordTime = -RECORD_PATH_INTERVAL;
+	if (time - lastRecordTime < RECORD_PATH_INTERVAL) {
+		return;
+	}
+	lastRecordTime = time;
+
+	// the camera looks along its negative z axis
+	glm::vec3 forward = -glm::vec3(glm::inverse(scene->viewMat)[2]);
+	recordedPath->addKeyframe(float(time), scene->cameraLocation, scene->cameraLocation + forward);
+}
+
+
+/**
+ * @brief run the game logic without window and opengl context, driven by a scripted input source.
+ * a new game is started in a new world whenever one is over. reports how fast the simulation runs compared to real time.
+ * @param simulatedSeconds the simulated time to run for
+ * @return the exit code
+ */
+int runHeadless(double simulatedSeconds)
+{
+	// objects must not touch opengl, only the data needed for the simulation is loaded
+	GLState::contextAvailable = false;
+
+	std::cout << "HEADLESS SIMULATION OF " << simulatedSeconds << " s" << std::endl;
+
+	double simulatedTime = 0;
+	long long stepCount = 0;
+	int gameCount = 0;
+	double totalPhysicsStepTime = 0; // ms
+	int physicsThreadCount = 0;
+
+	// only the simulation is timed, creating the worlds is timed separately
+	double wallTime = 0;
+	double worldCreationTime = 0;
+
+	while (simulatedTime < simulatedSeconds) {
+		// every game is played in a new world, like in the batch runner. reset() keeps eaten carrots removed,
+		// so after a won game the next ones could not be won anymore
+		std::chrono::steady_clock::time_point creationStart = std::chrono::steady_clock::now();
+		ScriptedInputSource *script = new ScriptedInputSource(ScriptedInputSource::wanderScript());
+		world = new GameWorld(script, 1.0f, seed + gameCount, physicsThreads, physicsStressBodies);
+		worldCreationTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - creationStart).count();
+		++gameCount;
+
+		double stepSize = world->getSimulationClock()->getStepSize();
+		long long worldStepCount = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while (simulatedTime < simulatedSeconds && !world->isGameOver()) {
+			// feed exactly one step per frame, so the run does not depend on the speed of the machine
+			script->advance(float(stepSize));
+			int steps = world->advance(stepSize);
+			simulatedTime += steps * stepSize;
+			worldStepCount += steps;
+		}
+		wallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		stepCount += worldStepCount;
+		totalPhysicsStepTime += world->getPhysics()->getAverageStepTime() * worldStepCount;
+		physicsThreadCount = world->getPhysics()->getThreadCount();
+
+		delete world; world = nullptr;
+		delete script;
+	}
+
+	std::cout << "simulated " << simulatedTime << " s in " << wallTime << " s wall time ("
+	          << simulatedTime / wallTime << " simulated s per wall s), "
+	          << stepCount << " steps, " << gameCount << " games" << std::endl;
+	std::cout << "average physics step: " << (stepCount > 0 ? totalPhysicsStepTime / stepCount : 0) << " ms with " << physicsThreadCount << " threads" << std::endl;
+	std::cout << "world creation: " << worldCreationTime << " s for " << gameCount << " worlds" << std::endl;
+
+	Geometry::releaseLoadedAssets();
+
+	return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief play many headless games in parallel and write their outcomes, see BatchRunner
+ * @param gameCount number of games to play
+ * @param threadCount number of worker threads
+ * @param agent the agent controlling the player
+ * @param outputPath the csv file to write the result of each game to
+ * @param scaling play the games once with every thread count from 1 to threadCount and print the games per second of each
+ * @return the exit code
+ */
+int runBatch(int gameCount, int threadCount, BatchRunner::Agent agent, const std::string &outputPath, bool scaling)
+{
+	// objects must not touch opengl, only the data needed for the simulation is loaded
+	GLState::contextAvailable = false;
+
+	if (!scaling) {
+		BatchRunner batchRunner(gameCount, threadCount, seed, agent);
+		batchRunner.run();
+		batchRunner.printSummary();
+		bool written = batchRunner.writeCsv(outputPath);
+
+		Geometry::releaseLoadedAssets();
+
+		return written ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// the first game loads the models and the terrain bvh cache, which would only slow down the first run
+	BatchRunner warmUp(1, 1, seed, agent);
+	warmUp.run();
+
+	std::vector<std::pair<int, double>> gamesPerSecond;
+	std::vector<BatchRunner::GameResult> firstResults;
+	bool written = true;
+	for (int threads = 1; threads <= threadCount; ++threads) {
+		BatchRunner batchRunner(gameCount, threads, seed, agent);
+		if (batchRunner.getThreadCount() < threads) {
+			// bullet's profiler limits the runner to one thread, more threads would measure the same
+			break;
+		}
+		batchRunner.run();
+		batchRunner.printSummary();
+		gamesPerSecond.push_back(std::make_pair(threads, batchRunner.getGamesPerSecond()));
+
+		// every game is seeded, so the outcomes must not depend on the number of threads
+		const std::vector<BatchRunner::GameResult> &results = batchRunner.getResults();
+		if (threads == 1) {
+			firstResults = results;
+			written = batchRunner.writeCsv(outputPath);
+		}
+		for (size_t i = 0; i < results.size(); ++i) {
+			if (results[i].outcome != firstResults[i].outcome || results[i].duration != firstResults[i].duration) {
+				std::cerr << "WARNING: game with seed " << results[i].seed << " ended differently on " << threads << " threads than on 1 thread" << std::endl;
+			}
+		}
+	}
+
+	std::cout << "threads,games_per_s,speedup" << std::endl;
+	for (const std::pair<int, double> &entry : gamesPerSecond) {
+		std::cout << entry.first << ',' << entry.second << ',' << entry.second / gamesPerSecond[0].second << std::endl;
+	}
+
+	Geometry::releaseLoadedAssets();
+
+	return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/**
+ * @brief fly the camera along a path through the world once for every combination of ssao, shadow
+ * and culling settings, and write the frame time statistics of each combination to a csv file.
+ * the world stands still, so every combination renders exactly the same frames.
+ * @return the exit code
+ */
+int runBenchmark()
+{
+	CameraPath path;
+	if (benchPathFile.empty()) {
+		path = CameraPath::circleTerrain(world->getTerrainHeightField(), BENCH_DEFAULT_PATH_DURATION);
+	}
+	else if (!path.load(benchPathFile)) {
+		return EXIT_FAILURE;
+	}
+
+	int frameCount = (std::max)(int(path.getDuration() * BENCH_FRAMES_PER_SECOND), 1);
+
+	// frames are rendered as fast as possible, without the text of the debug info
+	glfwSwapInterval(0);
+	debugInfoEnabled = false;
+
+	std::cout << "BENCHMARK: seed " << seed << ", scene scale " << sceneScale << ", " << frameCount << " frames per configuration ("
+	          << world->getCarrots().size() << " carrots, " << world->getTrees().size() << " trees, " << world->getShrubs().size() << " shrubs)" << std::endl;
+
+	std::ofstream file(benchOutput);
+	if (!file) {
+		std::cerr << "ERROR: Could not write benchmark results to " << benchOutput << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// the results are written once all configurations have run and all phases are known
+	std::vector<std::string> rows;
+	std::vector<std::vector<double>> phaseTimes;  // average cpu and gpu time of every phase, by configuration
+
+	// ssao: off, on, on with blur. shadows: off, pcf, vsm. culling: off, on
+	for (int ssaoSetting = 0; ssaoSetting < 3 && running; ++ssaoSetting) {
+		for (int shadowSetting = 0; shadowSetting < 3 && running; ++shadowSetting) {
+			for (int cullingSetting = 0; cullingSetting < 2 && running; ++cullingSetting) {
+				ssaoEnabled = ssaoSetting > 0;
+				ssaoBlurEnabled = ssaoSetting > 1;
+				shadowsEnabled = shadowSetting > 0;
+				vsmShadowsEnabled = shadowSetting > 1;
+				frustumCullingEnabled = cullingSetting > 0;
+
+				std::string settings = describeRenderSettings();
+				FrameTimeRecorder recorder(frameCount, frameBudget);
+				double lastTime = glfwGetTime();
+				double deltaT = 0;
+
+				for (int frame = -BENCH_WARMUP_FRAMES; frame < frameCount && running; ++frame) {
+					profiler->beginFrame();
+					if (frame == 0) {
+						// only the frames along the path are measured, times of the warm up still pending are dropped
+						profiler->reset();
+					}
+					Tracer::beginFrame();
+					Tracer::Scope frameScope("frame");
+
+					float pathTime = float((std::max)(frame, 0)) / BENCH_FRAMES_PER_SECOND;
+					benchScene.viewMat = path.getViewMatrix(pathTime);
+					benchScene.cameraLocation = path.getPosition(pathTime);
+
+					drawFrame(deltaT);
+					glfwSwapBuffers(window);
+					resetFrameCounters();
+
+					// a frame lasts from one buffer swap to the next
+					double time = glfwGetTime();
+					deltaT = time - lastTime;
+					lastTime = time;
+
+					if (frame >= 0) {
+						recorder.recordFrame(deltaT * 1000, *profiler, settings);
+					}
+
+					glfwPollEvents();
+					running = !glfwGetKey(window, GLFW_KEY_ESCAPE) && !glfwWindowShouldClose(window);
+				}
+
+				if (!running) {
+					std::cout << "BENCHMARK ABORTED" << std::endl;
+					break;
+				}
+
+				// a new frame adds the cpu times of the last one and reads back the gpu times available so far
+				profiler->beginFrame();
+
+				FrameTimeRecorder::Percentiles percentiles = recorder.calculatePercentiles();
+				double average = recorder.calculateAverage();
+
+				std::ostringstream row;
+				row << settings << ',' << recorder.getFrameCount() << ',' << average << ',' << percentiles.p50 << ',' << percentiles.p95
+				    << ',' << percentiles.p99 << ',' << percentiles.max << ',' << recorder.getOverBudgetCount();
+				rows.push_back(row.str());
+
+				// phases not run with this configuration have an average of 0
+				phaseTimes.push_back(std::vector<double>());
+				for (int i = 0; i < profiler->getPhaseCount(); ++i) {
+					phaseTimes.back().push_back(profiler->getCpuTotalAverage(i));
+					phaseTimes.back().push_back(profiler->getGpuTotalAverage(i));
+				}
+
+				std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(48) << settings << std::right
+				          << " mean " << std::setw(6) << average << "  p50 " << std::setw(6) << percentiles.p50
+				          << "  p95 " << std::setw(6) << percentiles.p95 << "  p99 " << std::setw(6) << percentiles.p99
+				          << "  max " << std::setw(6) << percentiles.max << " ms  over budget " << recorder.getOverBudgetCount() << std::endl;
+				std::cout.unsetf(std::ios::floatfield);
+			}
+		}
+	}
+
+	file << "configuration,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,over_budget";
+	for (int i = 0; i < profiler->getPhaseCount(); ++i) {
+		file << ',' << profiler->getPhaseName(i) << " cpu_ms," << profiler->getPhaseName(i) << " gpu_ms";
+	}
+	file << '\n';
+
+	for (size_t i = 0; i < rows.size(); ++i) {
+		file << rows[i];
+		// phases first run by a later configuration were not known yet
+		for (size_t j = 0; j < 2 * size_t(profiler->getPhaseCount()); ++j) {
+			file << ',' << (j < phaseTimes[i].size() ? phaseTimes[i][j] : 0.0);
+		}
+		file << '\n';
+	}
+
+	std::cout << "wrote benchmark results to " << benchOutput << std::endl;
+	return running ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
 void init(GLFWwindow *window)
 {
 	// enable z buffer test
-	glEnable(GL_DEPTH_TEST);
+	GLState::setDepthTest(true);
+
+	// INIT TEXTURE SAMPLERS
+	// unit 0 is used for diffuse textures only, filtered by the sampler of the selected filter type.
+	// other textures sampled by fullscreen passes, text and particles use unit 3 without a sampler.
+	Texture::initSamplers();
+	Texture::bindSampler(0, filterType);
+
+	// textures baked to compressed files are only used if the context can sample them, else the images are decoded
+	CompressedTexture::detectSupport();
 
 	// INIT SHADOW MAPPING (FBO, Texture, Shader)
 	initSM();
@@ -333,13 +891,15 @@ void init(GLFWwindow *window)
 	int width, height;
 	glfwGetWindowSize(window, &width, &height);
 
-	paused = false;
-
 	// INIT TEXT RENDERER
 	textRenderer = new TextRenderer("../data/fonts/cliff.ttf", width, height);
 
-	// INIT PARTICLE SYSTEM
-	particleSystem = new ParticleSystem(glm::mat4(1.0f), "../data/models/skunk/smoke.png", 30, 100.f, 15.f, -0.05f);
+	// INIT PER FRAME UNIFORM BUFFER
+	frameData = new FrameData();
+
+	// INIT PROFILER
+	profiler = new Profiler();
+	frameTimeRecorder = new FrameTimeRecorder(FRAME_HISTORY_LENGTH, frameBudget);
 
 	// INIT SSAO POST PROCESSOR
     ssaoPostprocessor = new SSAOPostprocessor(width, height, 32);
@@ -352,71 +912,55 @@ void init(GLFWwindow *window)
 
 
 	// INIT WORLD + OBJECTS
-
-	sun = new Light(glm::translate(glm::mat4(1.0f), LIGHT_START), LIGHT_END, glm::vec3(1.f, 0.89f, 0.6f), glm::vec3(0.87f, 0.53f, 0.f), timeToStarvation);
-
-	terrain = new Geometry(glm::scale(glm::mat4(1.0f), glm::vec3(1, 1, 1)), "../data/models/world/terrain.dae");
-	float minX, maxX, minZ, maxZ;
-	initWorldBounds(minX, maxX, minZ, maxZ);
-
-	// cave
-	glm::vec2 cavePos2D(0, 0);
-	cave = new Geometry(glm::mat4(1.0f), "../data/models/cave/cave.dae");
-	cave->setLocation(glm::vec3(cavePos2D.x, terrainGetYCoord(cavePos2D, 5.0f, -0.4f), cavePos2D.y));
-
-	std::default_random_engine randGen(time(nullptr));
-	std::uniform_real_distribution<float> randDistribution(0.0f, 1.0f);
-	auto rand = std::bind(randDistribution, std::ref(randGen));
-
-	float y = 0.0f;
-	// procedurally placed carrots
-	std::vector<glm::vec2> positions = PoissonDiskSampler::generatePoissonSample(80, 0.4f); // positions in range [0, 1]
-	for (glm::vec2 p : positions) {
-		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
-		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 10) {
-			y = terrainGetYCoord(p, 0.5f, -0.2f);
-			carrots.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::mat4(1.0f), 0.0f, glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), "../data/models/world/carrot.dae"));
-		}
+	// the models are read and their textures decoded on the worker threads while this thread uploads them,
+	// creating the world then only shares the loaded surfaces
+	jobSystem = new JobSystem();
+	textureStreamer = new TextureStreamer(jobSystem, TEXTURE_STREAM_BUDGET);
+	if (parallelLoading) {
+		GameWorld::loadModels(*jobSystem);
+
+		// textures requested from now on are streamed in over the first frames, e.g. the smoke of the particle system.
+		// serial loading keeps loading all textures at once, so its startup time stays comparable
+		Geometry::setTextureStreamer(textureStreamer);
 	}
 
-	// procedurally placed trees
-	positions = PoissonDiskSampler::generatePoissonSample(60, 0.4f); // positions in range [0, 1]
-	for (glm::vec2 p : positions) {
-		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
-		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 7) {
-			y = terrainGetYCoord(p, 1.5f, -1.0f);
-			trees.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(0.75 + rand() / 2)), rand() * 2 * glm::pi<float>(), glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), "../data/models/world/tree.dae")); //rand() * 2 * glm::pi<float>()
-		}
+	input = new QueuedInputSource();
+	world = new GameWorld(input, width/(float)height, seed, physicsThreads, physicsStressBodies, sceneScale);
+	world->setJobSystem(jobSystem);
+	player = world->getPlayer();
+	eagle = world->getEagle();
+	camera = world->getCamera();
+	world->getPhysics()->debugDrawWorld(true);
+
+	// group objects of the same model for instanced drawing
+	instancedCarrots = InstancedGeometry::groupByModel(world->getCarrots());
+	instancedTrees = InstancedGeometry::groupByModel(world->getTrees());
+	instancedShrubs = InstancedGeometry::groupByModel(world->getShrubs());
+	for (std::shared_ptr<InstancedGeometry> group : instancedCarrots) group->setJobSystem(jobSystem);
+	for (std::shared_ptr<InstancedGeometry> group : instancedTrees) group->setJobSystem(jobSystem);
+	for (std::shared_ptr<InstancedGeometry> group : instancedShrubs) group->setJobSystem(jobSystem);
+
+	// START SIMULATION THREAD
+	simulationThread = new SimulationThread(world, input, instancedCarrots);
+	if (benchmarkMode) {
+		// the benchmark renders the world as created, only moving the camera
+		simulationThread->publishSnapshot();
+		simulationThread->acquireSnapshot();
+		benchScene = simulationThread->getSnapshot();
+		scene = &benchScene;
 	}
-
-	// procedurally placed shrubs
-	positions = PoissonDiskSampler::generatePoissonSample(40, 0.6f); // positions in range [0, 1]
-	for (unsigned int i = 0; i < positions.size(); ++i) {
-		glm::vec2 p = positions[i];
-		p = (p - glm::vec2(0.5, 0.5)) * glm::max(maxX, maxZ)*1.8f;
-		if (p.x > minX && p.x < maxX && p.y > minZ && p.y < maxZ && glm::distance(p, cavePos2D) > 10) {
-			y = terrainGetYCoord(p, 1.0f, -0.4f);
-			if (i % 2 == 0) {
-				shrubs.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(1 + rand() / 2)), 0.0f, glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), "../data/models/world/shrub1.dae"));
-			}
-			else {
-				shrubs.push_back(std::make_shared<Geometry>(glm::translate(glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(1 + rand() / 2)), rand() * 2 * glm::pi<float>(), glm::vec3(0, 1, 0)), glm::vec3(p.x, y, p.y)), "../data/models/world/shrub2.dae"));
-			}
-		}
+	else {
+		simulationThread->start();
+		simulationThread->acquireSnapshot();
+		scene = &simulationThread->getSnapshot();
 	}
 
+	if (!recordPathFile.empty()) {
+		recordedPath = new CameraPath();
+	}
 
-	// INIT PLAYER + CAMERA
-	camera = new Camera(glm::mat4(1.0f), glm::radians(80.0f), width/(float)height, 0.2f, 200.0f); // mat, fov, aspect, znear, zfar
-	player = new Player(playerInitTransform, camera, window, "../data/models/skunk/skunk.dae");
-
-
-	// INIT EAGLE
-	eagle = new Eagle(eagleInitTransform, "../data/models/eagle/eagle.dae");
-
-
-	// INIT PHYSICS OBJECTS (add objects to dynamic World)
-	initPhysicsObjects();
+	// textures of models loaded from now on are streamed in over several frames
+	Geometry::setTextureStreamer(textureStreamer);
 
 	glfwSetTime(0);
 }
@@ -443,7 +987,7 @@ void initPCFSM()
 	glGenTextures(1, &depthMap);
 
 	// ShadowMap
-	glBindTexture(GL_TEXTURE_2D, depthMap);
+	GLState::bindTexture(1, depthMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, SM_WIDTH, SM_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -454,11 +998,11 @@ void initPCFSM()
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
 	// SM Framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+	GLState::bindFramebuffer(depthMapFBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 
@@ -469,7 +1013,7 @@ void initVSM()
 
 	// ShadowMomentsMap
 	glGenTextures(1, &vsmDepthMap);
-	glBindTexture(GL_TEXTURE_2D, vsmDepthMap);
+	GLState::bindTexture(1, vsmDepthMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SM_WIDTH, SM_HEIGHT, 0, GL_RGBA, GL_FLOAT, 0);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -480,12 +1024,11 @@ void initVSM()
 	glGenerateMipmap(GL_TEXTURE_2D);
 
 	// SM Framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, vsmDepthMapFBO);
+	GLState::bindFramebuffer(vsmDepthMapFBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, vsmDepthMap, 0);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 
@@ -494,8 +1037,8 @@ void initVSMBlur()
 	glGenFramebuffers(1, &pingpongFBO);
 	glGenTextures(1, &pingpongColorMap);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO);
-	glBindTexture(GL_TEXTURE_2D, pingpongColorMap);
+	GLState::bindFramebuffer(pingpongFBO);
+	GLState::bindTexture(0, pingpongColorMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SM_WIDTH, SM_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -504,61 +1047,7 @@ void initVSMBlur()
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorMap, 0);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
-
-
-void initPhysicsObjects()
-{
-	physics = new Physics(player);
-	physics->init();
-
-	physics->getDynamicsWorld()->addRigidBody(player->getRigidBody());
-
-	for (std::vector<std::shared_ptr<Geometry>>::iterator it = trees.begin(); it != trees.end(); ++it) {
-		physics->addTreeCylinderToPhysics(it->get(), btScalar(0.6));
-	}
-
-	for (std::vector<std::shared_ptr<Geometry>>::iterator it = carrots.begin(); it != carrots.end(); ++it) {
-		physics->addFoodSphereToPhysics(it->get(), btScalar(0.3));
-	}
-
-	for (std::vector<std::shared_ptr<Geometry>>::iterator it = shrubs.begin(); it != shrubs.end(); ++it) {
-		physics->addBushSphereToPhysics(it->get(), btScalar(2));
-	}
-
-	physics->addTerrainShapeToPhysics(terrain);
-	physics->setupCaveObjects(cave);
-
-}
-
-
-void update(float timeDelta)
-{
-	player->update(timeDelta);
-	player->setIsInCave(glm::distance(player->getLocation(), cave->getLocation()) < 2.0f);
-
-	eagle->update(timeDelta, player->getLocation() + glm::vec3(0, 2, 0), player->isInBush() || player->isInCave(), player->isDefenseActive());
-
-	particleSystem->update(timeDelta, player->getViewMat());
-
-	sun->update(timeDelta);
-
-	// SET POSITION AND COLOR IN SHADERS
-
-	GLint lightPosLocation = glGetUniformLocation(activeShader->programHandle, "light.position");
-	GLint lightAmbientLocation = glGetUniformLocation(activeShader->programHandle, "light.ambient");
-	GLint lightDiffuseLocation = glGetUniformLocation(activeShader->programHandle, "light.diffuse");
-	GLint lightSpecularLocation = glGetUniformLocation(activeShader->programHandle, "light.specular");
-
-	GLint materialSpecularLocation = glGetUniformLocation(activeShader->programHandle, "material.specular");
-	glUniform3f(materialSpecularLocation, 0.2f, 0.2f, 0.2f);
-
-	glUniform3f(lightPosLocation, sun->getLocation().x, sun->getLocation().y, sun->getLocation().z);
-	glUniform3f(lightAmbientLocation, sun->getColor().x * 0.3f, sun->getColor().y * 0.3f, sun->getColor().z * 0.3f);
-	glUniform3f(lightDiffuseLocation, sun->getColor().x, sun->getColor().y, sun->getColor().z);
-	glUniform3f(lightSpecularLocation, sun->getColor().x * 0.8f, sun->getColor().y * 0.8f, sun->getColor().z * 0.8f);
-
+	GLState::bindFramebuffer(0);
 }
 
 
@@ -566,50 +1055,45 @@ void drawScene()
 {
 	if (wireframeEnabled) glPolygonMode( GL_FRONT_AND_BACK, GL_LINE ); // enable wireframe
 
-	if (useAlpha) {
-		glUniform1f(glGetUniformLocation(activeShader->programHandle, "useAlpha"), true);
-	}
-	else {
-		glUniform1f(glGetUniformLocation(activeShader->programHandle, "useAlpha"), false);
-	}
-
-	// pass viewProjection matrix to shader
-	GLint viewProjMatLocation = glGetUniformLocation(activeShader->programHandle, "viewProjMat"); // get uniform location in shader
-	glUniformMatrix4fv(viewProjMatLocation, 1, GL_FALSE, glm::value_ptr(player->getProjMat() * player->getViewMat())); // shader location, count, transpose?, value pointer
-
-	// pass camera position to shader
-	GLint cameraPosLocation = glGetUniformLocation(activeShader->programHandle, "cameraPos");
-	glUniform3f(cameraPosLocation, camera->getLocation().x, camera->getLocation().y, camera->getLocation().z);
+	activeShader->uniform("useAlpha").set(useAlpha);
 
-	physics->debugDrawWorld(true);
+	// note: viewProjection matrix and camera position are passed with the FrameData block
+	// the culling uses the same matrices from the snapshot
+	glm::mat4 viewProjMat = scene->projMat * scene->viewMat;
 
 	// DRAW GEOMETRY
 
 	Geometry::drawnSurfaceCount = 0;
 
-	glUniform1f(glGetUniformLocation(activeShader->programHandle, "material.shininess"), 64.f);
-	terrain->draw(activeShader, camera, false, filterType, player->getViewMat());
+	activeShader->uniform("material.shininess").set(64.f);
+	world->getTerrain()->draw(activeShader, false, viewProjMat);
 
-	glUniform1f(glGetUniformLocation(activeShader->programHandle, "material.shininess"), 2.f);
-	for (std::shared_ptr<Geometry> carr : carrots) {
-		carr->draw(activeShader, camera, frustumCullingEnabled, filterType, player->getViewMat());
-	}
+	activeShader->uniform("material.shininess").set(16.f);
+	static_cast<Geometry*>(player)->draw(activeShader, frustumCullingEnabled, viewProjMat, scene->playerMatrix);
+
+	world->getCave()->draw(activeShader, false, viewProjMat);
 
-	glUniform1f(glGetUniformLocation(activeShader->programHandle, "material.shininess"), 16.f);
-	player->draw(activeShader, frustumCullingEnabled, filterType, player->getViewMat());
+	// carrots, shrubs and trees are drawn instanced, with one draw call per model surface
+	activeShader->uniform("instanced").set(true);
 
-	for (std::shared_ptr<Geometry> shrub : shrubs) {
-		shrub->draw(activeShader, camera, frustumCullingEnabled, filterType, player->getViewMat());
+	activeShader->uniform("material.shininess").set(2.f);
+	for (std::shared_ptr<InstancedGeometry> group : instancedCarrots) {
+		group->draw(activeShader);
 	}
 
-	cave->draw(activeShader, camera, false, filterType, player->getViewMat());
+	activeShader->uniform("material.shininess").set(16.f);
+	for (std::shared_ptr<InstancedGeometry> group : instancedShrubs) {
+		group->draw(activeShader);
+	}
 
-	for (std::shared_ptr<Geometry> tree : trees) {
-		tree->draw(activeShader, camera, frustumCullingEnabled, filterType, player->getViewMat());
+	for (std::shared_ptr<InstancedGeometry> group : instancedTrees) {
+		group->draw(activeShader);
 	}
 
-	glUniform1f(glGetUniformLocation(activeShader->programHandle, "material.shininess"), 32.f);
-	eagle->draw(activeShader, camera, frustumCullingEnabled, filterType, player->getViewMat());
+	activeShader->uniform("instanced").set(false);
+
+	activeShader->uniform("material.shininess").set(32.f);
+	eagle->draw(activeShader, frustumCullingEnabled, viewProjMat, scene->eagleMatrix);
 
 	if (wireframeEnabled) glPolygonMode( GL_FRONT_AND_BACK, GL_FILL ); // disable wireframe
 
@@ -618,81 +1102,130 @@ void drawScene()
 
 void drawText(double deltaT, int windowWidth, int windowHeight)
 {
-	glDisable(GL_DEPTH_TEST);
+	GLState::setDepthTest(false);
 
 	if (debugInfoEnabled) {
 
 		int startY = 400;
 		int deltaY = 20;
 		float fontSize = 0.35f;
+		textRenderer->renderText("gl calls issued: " + std::to_string(glCallsIssuedLastFrame) + ", skipped: " + std::to_string(glCallsSkippedLastFrame), 25, startY, fontSize, glm::vec3(1));
+		textRenderer->renderText("uniform lookups avoided: " + std::to_string(uniformLookupsAvoidedLastFrame), 25, startY+deltaY, fontSize, glm::vec3(1));
 		textRenderer->renderText("drawn surface count: " + std::to_string(Geometry::drawnSurfaceCount), 25, startY+2*deltaY, fontSize, glm::vec3(1));
 		textRenderer->renderText("delta time: " + std::to_string(int(deltaT*1000 + 0.5)) + " ms", 25, startY+3*deltaY, fontSize, glm::vec3(1));
-		textRenderer->renderText("fps: " + std::to_string(int(1/deltaT + 0.5)), 25, startY+4*deltaY, fontSize, glm::vec3(1));
-
-		if (!paused) {
-			textRenderer->renderText("time until starvation: " + std::to_string(int(timeToStarvation - glfwGetTime())), 25.0f, startY+6*deltaY, fontSize, glm::vec3(1));
-			textRenderer->renderText("player hidden: " + std::to_string(player->isInBush()) /* + ", defense active: " + std::to_string(player->isDefenseActive()) */, 25.0f, startY+7*deltaY, fontSize, glm::vec3(1));
+		FrameTimeRecorder::Percentiles percentiles = frameTimeRecorder->calculatePercentiles();
+		std::ostringstream frameTimes;
+		frameTimes << std::fixed << std::setprecision(1) << "frame p50/p95/p99/max: " << percentiles.p50 << " / " << percentiles.p95 << " / " << percentiles.p99 << " / " << percentiles.max
+		           << " ms, over budget: " << frameTimeRecorder->getOverBudgetCount() << " / " << frameTimeRecorder->getFrameCount();
+		textRenderer->renderText(frameTimes.str(), 25, startY+4*deltaY, fontSize, glm::vec3(1));
+		textRenderer->renderText("physics step: " + std::to_string(scene->physicsStepTime) + " ms (" + std::to_string(scene->physicsThreadCount) + " threads)", 25, startY+5*deltaY, fontSize, glm::vec3(1));
+		textRenderer->renderText("simulation frame: " + std::to_string(scene->simulationFrameTime) + " ms", 25, startY+6*deltaY, fontSize, glm::vec3(1));
+		textRenderer->renderText("jobs on workers: " + std::to_string(workerJobsLastFrame), 25, startY+7*deltaY, fontSize, glm::vec3(1));
+
+		if (scene->outcome == GameWorld::RUNNING) {
+			textRenderer->renderText("time until starvation: " + std::to_string(int(scene->timeUntilStarvation)), 25.0f, startY+8*deltaY, fontSize, glm::vec3(1));
+			textRenderer->renderText("player hidden: " + std::to_string(scene->playerHidden), 25.0f, startY+9*deltaY, fontSize, glm::vec3(1));
 			std::string eagleStateStrings[3] = {"CIRCLING", "ATTACKING", "RETREATING"};
-			textRenderer->renderText("eagle state: " + eagleStateStrings[eagle->getState()] /* + ", in reach: " + std::to_string(eagle->isInTargetDefenseReach()) */, 25.0f, startY+8*deltaY, fontSize, glm::vec3(1));
+			textRenderer->renderText("eagle state: " + eagleStateStrings[scene->eagleState], 25.0f, startY+10*deltaY, fontSize, glm::vec3(1));
 		}
-	}
 
-	if (paused) {
-		if (eagle->isTargetEaten()) {
-			textRenderer->renderText("YOU GOT EATEN =(", 25.0f, 150.0f, 0.7f, glm::vec3(1, 0.35f, 0.7f));
-		}
-		else if (glfwGetTime() > timeToStarvation - 1) {
-			textRenderer->renderText("YOU STARVED =(", 25.0f, 150.0f, 0.7f, glm::vec3(1, 0.35f, 0.5f));
-		}
+		drawProfilerOverlay(windowWidth, windowHeight);
 	}
 
-	if (player->isFull() && player->isInCave()) {
+	if (scene->outcome == GameWorld::WON) {
 		textRenderer->renderText("YOU MADE IT!!!", 25.0f, 150.0f, 0.7f, glm::vec3(1, 0.45f, 0.7f));
-		paused = true;
+	}
+	else if (scene->outcome == GameWorld::EATEN) {
+		textRenderer->renderText("YOU GOT EATEN =(", 25.0f, 150.0f, 0.7f, glm::vec3(1, 0.35f, 0.7f));
+	}
+	else if (scene->outcome == GameWorld::STARVED) {
+		textRenderer->renderText("YOU STARVED =(", 25.0f, 150.0f, 0.7f, glm::vec3(1, 0.35f, 0.5f));
 	}
 
-	std::string carrotText = "carrots: " + std::to_string(player->getFoodCount()) + " / " + std::to_string(player->getNeededFood());
+	std::string carrotText = "carrots: " + std::to_string(scene->foodCount) + " / " + std::to_string(scene->neededFood);
 	textRenderer->renderText(carrotText, 25.0f, 30.0f, 0.7f, glm::vec3(1, 0.7f, 0.0f));
 
-	if (player->isEating()) {
-		textRenderer->renderText(player->getFoodReaction(), 300.0f, 300.0f, 0.4f, glm::vec3(0.5f, 0.7f, 0.5f));
+	if (scene->eating) {
+		textRenderer->renderText(scene->foodReaction, 300.0f, 300.0f, 0.4f, glm::vec3(0.5f, 0.7f, 0.5f));
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	GLState::setDepthTest(true);
 }
 
 
-void shadowFirstPass(glm::mat4 &lightViewPro)
+/**
+ * @brief draw the current, average and max cpu and gpu time of every profiled phase
+ */
+void drawProfilerOverlay(int windowWidth, int windowHeight)
+{
+	float x = windowWidth * 0.5f;
+	int startY = windowHeight - 30;
+	int deltaY = 18;
+	float fontSize = 0.3f;
+
+	textRenderer->renderText("ms (current / average / max)", x, startY, fontSize, glm::vec3(1));
+
+	for (int i = 0; i < profiler->getPhaseCount(); ++i) {
+		Profiler::Statistics cpu = profiler->getCpuStatistics(i);
+		Profiler::Statistics gpu = profiler->getGpuStatistics(i);
+
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(2) << profiler->getPhaseName(i) << ": cpu " << cpu.current << " / " << cpu.average << " / " << cpu.max;
+		if (gpu.sampleCount > 0) {
+			line << ", gpu " << gpu.current << " / " << gpu.average << " / " << gpu.max;
+		}
+		textRenderer->renderText(line.str(), x, startY - (i+1)*deltaY, fontSize, glm::vec3(1));
+	}
+}
+
+
+/**
+ * @brief describe the render settings affecting performance, recorded with every frame time
+ */
+std::string describeRenderSettings()
+{
+	std::string shadows = !shadowsEnabled ? "off" : (vsmShadowsEnabled ? "vsm" : "pcf");
+	return std::string("ssao ") + (ssaoEnabled ? (ssaoBlurEnabled ? "blur" : "on") : "off")
+	       + " shadows " + shadows
+	       + " culling " + (frustumCullingEnabled ? "on" : "off")
+	       + " alpha " + (useAlpha ? "on" : "off");
+}
+
+
+glm::mat4 calculateLightViewProjection()
 {
 	// Calculate Light View-Projection Matrix
 	glm::mat4 lightProjection = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, NEAR_PLANE, FAR_PLANE);
 	//glm::mat4 lightProjection = glm::perspective(100.f, (GLfloat) SM_WIDTH / (GLfloat) SM_HEIGHT, nearPlane, farPlane);
-	glm::mat4 lightView = glm::lookAt(sun->getLocation(), glm::vec3(0.f), glm::vec3(0, 1, 0));
-	lightViewPro = lightProjection * lightView;
+	glm::mat4 lightView = glm::lookAt(scene->lightLocation, glm::vec3(0.f), glm::vec3(0, 1, 0));
+	return lightProjection * lightView;
+}
+
+
+void shadowFirstPass()
+{
+	// the light view projection matrix is passed with the FrameData block
 
 	// set viewport and bind framebuffer
 	glViewport(0, 0, SM_WIDTH, SM_HEIGHT);
 
 	//if (vsmShadowsEnabled) {
-		glBindFramebuffer(GL_FRAMEBUFFER, vsmDepthMapFBO);
+		GLState::bindFramebuffer(vsmDepthMapFBO);
 		setActiveShader(vsmDepthMapShader);
-		glUniformMatrix4fv(glGetUniformLocation(activeShader->programHandle, "lightVP"), 1, GL_FALSE, glm::value_ptr(lightViewPro));
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 		drawScene();
+		GLState::bindTexture(1, vsmDepthMap);
 		glGenerateMipmap(GL_TEXTURE_2D);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::bindFramebuffer(0);
 
-		if (vsmShadowsEnabled) {
-			vsmBlurPass();
-		}
+		// the vsm blur pass follows separately if enabled, so both passes can be timed on their own
 	/*}
 	else {
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+		GLState::bindFramebuffer(depthMapFBO);
 		setActiveShader(depthMapShader);
 		glClear(GL_DEPTH_BUFFER_BIT);
-		glUniformMatrix4fv(glGetUniformLocation(activeShader->programHandle, "lightVP"), 1, GL_FALSE, glm::value_ptr(lightViewPro));
 		drawScene();
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::bindFramebuffer(0);
 	}
 	*/
 	// bind default FB and reset viewport
@@ -707,20 +1240,20 @@ void vsmBlurPass()
 	glViewport(0, 0, SM_WIDTH, SM_HEIGHT);
 	setActiveShader(blurVSMDepthShader);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO);
-	glUniform1i(glGetUniformLocation(activeShader->programHandle, "horizontal"), horizontal);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, vsmDepthMap);
+	GLState::bindFramebuffer(pingpongFBO);
+	activeShader->uniform("horizontal").set(horizontal);
+	activeShader->uniform("image").set(3);
+	GLState::bindTexture(3, vsmDepthMap);
 	RenderQuad();
 	horizontal = !horizontal;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, vsmDepthMapFBO);
-	glUniform1i(glGetUniformLocation(activeShader->programHandle, "horizontal"), horizontal);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, pingpongColorMap);
+	GLState::bindFramebuffer(vsmDepthMapFBO);
+	activeShader->uniform("horizontal").set(horizontal);
+	GLState::bindTexture(3, pingpongColorMap);
 	RenderQuad();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
+	glViewport(0, 0, windowWidth, windowHeight);
 }
 
 
@@ -730,16 +1263,16 @@ void ssaoFirstPass()
 		//// SSAO PREPASS
 		//// draw ssao input data (screen colors and view space positions) to framebuffer textures
 		ssaoPostprocessor->bindScreenDataFramebuffer();
-		glUniform1i(glGetUniformLocation(activeShader->programHandle, "useShadows"), 0);
-		glUniform1i(glGetUniformLocation(activeShader->programHandle, "useSSAO"), 0);
-		glUniform1i(glGetUniformLocation(activeShader->programHandle, "useVSM"), 0);
-		glClearColor(sun->getColor().x, sun->getColor().y, sun->getColor().z, 1.f);
+		activeShader->uniform("useShadows").set(0);
+		activeShader->uniform("useSSAO").set(0);
+		activeShader->uniform("useVSM").set(0);
+		glClearColor(scene->lightColor.x, scene->lightColor.y, scene->lightColor.z, 1.f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		drawScene();
 
 		//// SSAO PASS
 		//// draw ssao output data to framebuffer texture
-		ssaoPostprocessor->calulateSSAOValues(player->getProjMat());
+		ssaoPostprocessor->calulateSSAOValues();
 		setActiveShader(textureShader);
 
 		//// SSAO BLUR PASS
@@ -754,14 +1287,14 @@ void ssaoFirstPass()
 
 void finalDrawPass()
 {
-	glClearColor(sun->getColor().x, sun->getColor().y, sun->getColor().z, 1.f);
+	glClearColor(scene->lightColor.x, scene->lightColor.y, scene->lightColor.z, 1.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glUniform1i(glGetUniformLocation(activeShader->programHandle, "useShadows"), shadowsEnabled);
-	glUniform1i(glGetUniformLocation(activeShader->programHandle, "useSSAO"), ssaoEnabled);
-	glUniform1i(glGetUniformLocation(activeShader->programHandle, "useVSM"), vsmShadowsEnabled);
+	activeShader->uniform("useShadows").set(shadowsEnabled);
+	activeShader->uniform("useSSAO").set(ssaoEnabled);
+	activeShader->uniform("useVSM").set(vsmShadowsEnabled);
 
-	ssaoPostprocessor->bindSSAOResultTexture(glGetUniformLocation(activeShader->programHandle, "ssaoTexture"), 2);
+	ssaoPostprocessor->bindSSAOResultTexture(activeShader->uniform("ssaoTexture"), 2);
 
 	drawScene();
 }
@@ -773,40 +1306,25 @@ void debugShadowPass()
 
 		setActiveShader(debugDepthShader);
 
-		glUniform1f(glGetUniformLocation(debugDepthShader->programHandle, "near_plane"), NEAR_PLANE);
-		glUniform1f(glGetUniformLocation(debugDepthShader->programHandle, "far_plane"), FAR_PLANE);
-		glActiveTexture(GL_TEXTURE0);
-
-		glBindTexture(GL_TEXTURE_2D, vsmDepthMap);
+		debugDepthShader->uniform("near_plane").set(NEAR_PLANE);
+		debugDepthShader->uniform("far_plane").set(FAR_PLANE);
+		debugDepthShader->uniform("depthMap").set(3);
+		GLState::bindTexture(3, vsmDepthMap);
 
 		RenderQuad();
 	}
 }
 
 
-void newGame()
+void cleanup()
 {
-	delete sun;
-
-	glfwSetTime(0);
-
-	int width, height;
-	glfwGetWindowSize(window, &width, &height);
-
-	sun = new Light(glm::translate(glm::mat4(1.0f), LIGHT_START), LIGHT_END, glm::vec3(1.f, 0.89f, 0.6f), glm::vec3(0.87f, 0.53f, 0.f), timeToStarvation);
+	// write the trace if the program ends before the last frame to capture
+	Tracer::finishCapture();
 
-	// RESET PLAYER + CAMERA
-	player->setTransform(playerInitTransform);
-	player->resetPlayer();
-	eagle->setTransform(eagleInitTransform);
-	eagle->resetEagle();
+	// the world may only be touched again once the simulation thread has stopped
+	delete simulationThread; simulationThread = nullptr;
+	scene = nullptr;
 
-	paused = false;
-}
-
-
-void cleanup()
-{
 	delete textureShader; textureShader = nullptr;
 	delete depthMapShader; depthMapShader = nullptr;
 	delete debugDepthShader; debugDepthShader = nullptr;
@@ -815,16 +1333,38 @@ void cleanup()
 	activeShader = nullptr;
 
 	delete textRenderer; textRenderer = nullptr;
-	delete particleSystem; particleSystem = nullptr;
 	delete ssaoPostprocessor; ssaoPostprocessor = nullptr;
+	delete frameData; frameData = nullptr;
+	// the benchmark writes its own results
+	if (!benchmarkMode) {
+		frameTimeRecorder->writeCsv(frameTimesOutput, *profiler);
+	}
+	delete frameTimeRecorder; frameTimeRecorder = nullptr;
+	delete profiler; profiler = nullptr;
+
+	if (recordedPath) {
+		if (recordedPath->save(recordPathFile)) {
+			std::cout << "wrote camera path with " << recordedPath->getKeyframeCount() << " keyframes to " << recordPathFile << std::endl;
+		}
+		delete recordedPath; recordedPath = nullptr;
+	}
 
-	delete player; player = nullptr;
-	delete eagle; eagle = nullptr;
-	delete terrain; terrain = nullptr;
-	delete cave; cave = nullptr;
+	instancedCarrots.clear();
+	instancedTrees.clear();
+	instancedShrubs.clear();
 
-	physics->cleanUp();
-	delete physics;
+	Texture::deleteSamplers();
+
+	std::cout << "average physics step: " << world->getPhysics()->getAverageStepTime() << " ms with " << world->getPhysics()->getThreadCount() << " threads" << std::endl;
+
+	// release shared models and textures while the opengl context still exists
+	delete world; world = nullptr;
+	player = nullptr; eagle = nullptr; camera = nullptr;
+	delete input; input = nullptr;
+	Geometry::setTextureStreamer(nullptr);
+	delete textureStreamer; textureStreamer = nullptr;
+	delete jobSystem; jobSystem = nullptr;
+	Geometry::releaseLoadedAssets();
 }
 
 
@@ -854,20 +1394,9 @@ void frameBufferResize(GLFWwindow *window, int width, int height)
  */
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
-	if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) {
-	    player->toggleNavMode();
-	}
-
-	if (glfwGetKey(window, GLFW_KEY_BACKSPACE) == GLFW_PRESS){
-		newGame();
-		std::cout << "GAME RESTARTED" << std::endl;
-	}
-
-	if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
-		if (player->attemptDefenseActivation()) {
-			particleSystem->respawn(player->getLocation());
-			std::cout << "PARTICLE SYSTEM RESPAWNED" << std::endl;
-		}
+	// keys controlling the game are handled on the simulation thread, see SimulationThread::handleKeyPress
+	if (action != GLFW_REPEAT) {
+		input->pushKey(key, action == GLFW_PRESS);
 	}
 
 	if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
@@ -884,6 +1413,7 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
 
 	if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS) {
 	    filterType = static_cast<Texture::FilterType>((static_cast<int>(filterType)+3) % 6);
+		Texture::bindSampler(0, filterType);
 
 		switch (filterType) {
 			case Texture::NEAREST_MIPMAP_OFF:     std::cout << "TEXTURE FILTER NEAREST" << std::endl; break;
@@ -898,6 +1428,7 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
 	if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
 		int filterTypeInt = static_cast<int>(filterType);
 	    filterType = static_cast<Texture::FilterType>((static_cast<int>(filterType)+1) % 3 + (filterTypeInt/3)*3);
+		Texture::bindSampler(0, filterType);
 
 		switch (filterType) {
 			case Texture::NEAREST_MIPMAP_OFF:     std::cout << "MIPMAP OFF" << std::endl; break;
@@ -954,6 +1485,10 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
 		if (renderShadowMap) std::cout << "DEBUG DRAW SHADOW MAP ENABLED" << std::endl;
 		else std::cout << "DEBUG DRAW SHADOW MAP DISABLED" << std::endl;
 	}
+
+	if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS) {
+		frameTimeRecorder->writeCsv(frameTimesOutput, *profiler);
+	}
 }
 
 
@@ -963,66 +1498,3 @@ void setActiveShader(Shader *shader)
 	activeShader->useShader();
 }
 
-
-float terrainGetYCoord(glm::vec2 pos2D, float maxDistanceXY, float offsetY)
-{
-	float newY = 0.0f;
-
-	float x = pos2D.x;
-	float z = pos2D.y;
-	float lowerX, upperX, lowerZ, upperZ;
-
-	std::vector<Vertex> verts = terrain->getSurface()->getVertices();
-
-	unsigned int i = 0;
-	while (i < verts.size()) {
-		glm::vec3 vPos = verts.at(i).position; // *glm::mat3(terrain->getMatrix());
-
-		lowerX = vPos.x - maxDistanceXY; upperX = vPos.x + maxDistanceXY;
-		lowerZ = vPos.z - maxDistanceXY; upperZ = vPos.z + maxDistanceXY;
-
-		if (x > lowerX && x < upperX) {
-			if (z > lowerZ && z < upperZ) {
-				newY = vPos.y + offsetY;
-				i = verts.size() + 1;
-			}
-		}
-
-		++i;
-	}
-
-	return newY;
-}
-
-
-void initWorldBounds(float &miX, float &maX, float &miZ, float &maZ)
-{
-	std::vector<Vertex> verts = terrain->getSurface()->getVertices();
-
-	miX = 99999, miZ = 99999;
-	maX = -99999, maZ = -99999;
-
-	unsigned int i = 0;
-	while (i < verts.size()) {
-		glm::vec3 pos = verts.at(i).position;
-
-		if (pos.x > maX) {
-			maX = pos.x;
-		}
-		else if (pos.x < miX) {
-			miX = pos.x;
-		}
-
-		if (pos.z > maZ) {
-			maZ = pos.z;
-		}
-		else if (pos.z < miZ) {
-			miZ = pos.z;
-		}
-
-		++i;
-	}
-	miX += 7; maX -= 7;
-	miZ += 7; maZ -= 7;
-}
-
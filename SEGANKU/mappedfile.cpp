@@ -0,0 +1,135 @@
+#include "mappedfile.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &filePath)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data) {
+		close();
+		return false;
+	}
+	size = size_t(fileSize.QuadPart);
+#else
+	fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+		close();
+		return false;
+	}
+
+	void *mapping = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED) {
+		close();
+		return false;
+	}
+	data = static_cast<const char*>(mapping);
+	size = size_t(fileStat.st_size);
+
+	// the file is read front to back by the loaders
+	madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle) {
+		CloseHandle(fileHandle);
+	}
+#else
+	if (data) {
+		munmap(const_cast<char*>(data), size);
+	}
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+#endif
+
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	fileDescriptor = -1;
+}
+
+bool MappedFile::isOpen() const
+{
+	return data != nullptr;
+}
+
+const char *MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
+
+bool MappedFile::getFileInfo(const std::string &filePath, std::uint64_t &fileSize, std::int64_t &modificationTime)
+{
+	struct stat fileStat;
+	if (stat(filePath.c_str(), &fileStat) != 0) {
+		return false;
+	}
+
+	fileSize = std::uint64_t(fileStat.st_size);
+	modificationTime = std::int64_t(fileStat.st_mtime);
+	return true;
+}
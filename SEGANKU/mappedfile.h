@@ -0,0 +1,62 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A MappedFile maps a whole file read only into memory, so its contents can be used in place
+ * without reading them into a buffer first. Pages are loaded by the operating system when first touched
+ * and stay in the page cache between runs.
+ * The mapping is released when the MappedFile is closed or destroyed, pointers into it become invalid then.
+ */
+class MappedFile
+{
+	const char *data = nullptr;
+	size_t size = 0;
+
+	// platform handles of the open file and mapping
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+	int fileDescriptor = -1;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief map the file, closing the file mapped before
+	 * @param filePath the file to map
+	 * @return false if the file does not exist, is empty or cannot be mapped
+	 */
+	bool open(const std::string &filePath);
+
+	/**
+	 * @brief release the mapping
+	 */
+	void close();
+
+	bool isOpen() const;
+
+	/**
+	 * @return the first byte of the file, nullptr if no file is mapped
+	 */
+	const char *getData() const;
+
+	/**
+	 * @return the size of the mapped file in bytes
+	 */
+	size_t getSize() const;
+
+	/**
+	 * @brief get the size and the time of the last modification of a file without opening it
+	 * @return false if the file does not exist
+	 */
+	static bool getFileInfo(const std::string &filePath, std::uint64_t &fileSize, std::int64_t &modificationTime);
+};
+
+#endif // MAPPEDFILE_H
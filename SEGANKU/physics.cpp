@@ -1,173 +1,279 @@
 #include "physics.h"
-
-bool inBush, inCave;
-btRigidBody *toDelete = nullptr;
-btDiscreteDynamicsWorld *physicWorld;
-
-struct CarrotContact : public btCollisionWorld::ContactResultCallback
+#include "tracer.h"
+
+#ifdef SEGANKU_MULTITHREADED_PHYSICS
+#include <BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
+#include <BulletMultiThreaded/PlatformDefinitions.h>
+#ifdef _WIN32
+#include <BulletMultiThreaded/Win32ThreadSupport.h>
+#else
+#include <BulletMultiThreaded/PosixThreadSupport.h>
+#endif
+#include <BulletMultiThreaded/SpuGatheringCollisionDispatcher.h>
+#include <BulletMultiThreaded/SpuNarrowPhaseCollisionTask/SpuGatheringCollisionTask.h>
+#include <BulletMultiThreaded/btParallelConstraintSolver.h>
+
+/**
+* @brief start worker threads running the given task function
+*/
+static btThreadSupportInterface *createThreadSupport(const char *name, void (*taskFunc)(void*, void*), void *(*lsMemoryFunc)(), int threadCount)
 {
-	CarrotContact() {}
-
-	btScalar addSingleResult(btManifoldPoint& cp,
-		const btCollisionObjectWrapper* carrotBody,
-		int partId0,
-		int index0,
-		const btCollisionObjectWrapper* playerBody,
-		int partId1,
-		int index1)
-	{
-		Player *player = (Player*)playerBody->getCollisionObject()->getUserPointer();
-		Geometry *geometry = (Geometry*)carrotBody->getCollisionObject()->getUserPointer();
+#ifdef _WIN32
+	Win32ThreadSupport::Win32ThreadConstructionInfo info(name, taskFunc, lsMemoryFunc, threadCount);
+	Win32ThreadSupport *threadSupport = new Win32ThreadSupport(info);
+#else
+	PosixThreadSupport::ThreadConstructionInfo info(name, taskFunc, lsMemoryFunc, threadCount);
+	PosixThreadSupport *threadSupport = new PosixThreadSupport(info);
+#endif
+	return threadSupport;
+}
+#endif
 
-		if (player->isEating()) {
-			return 0;
-		}
-		carrotBody->getCollisionObject()->setActivationState(DISABLE_SIMULATION);
+std::mutex Physics::bvhCacheMutex;
 
-		//removeCollisionObject(const_cast<btCollisionObject*>(colObj0Wrap->getCollisionObject()));
-		player->eat(geometry);
-		physicWorld->removeCollisionObject(const_cast<btCollisionObject*>(carrotBody->getCollisionObject()));
-		toDelete = (btRigidBody*)carrotBody->getCollisionObject();
+Physics::Physics(Player *player, int threadCount) : player(player), threadCount(threadCount)
+{
+}
 
-		return 0;
-	}
-};
+Physics::~Physics()
+{
+}
 
-struct BushContact : public btCollisionWorld::ContactResultCallback
+void Physics::init()
 {
-	BushContact() {}
-
-	btScalar addSingleResult(btManifoldPoint& cp,
-		const btCollisionObjectWrapper* bushBody,
-		int partId0,
-		int index0,
-		const btCollisionObjectWrapper* playerBody,
-		int partId1,
-		int index1)
-	{
+	drawDebug = false;
 
-		inBush = true;
+#ifdef SEGANKU_MULTITHREADED_PHYSICS
+	if (threadCount > 1) {
+		// the workers cannot grow the manifold pool, so reserve enough for the stress scene
+		btDefaultCollisionConstructionInfo constructionInfo;
+		constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 32768;
+		collisionConfiguration = new btDefaultCollisionConfiguration(constructionInfo);
 
-		return 0;
-	}
-};
+		collisionThreadSupport = createThreadSupport("collision", processCollisionTask, createCollisionLocalStoreMemory, threadCount);
+		dispatcher = new SpuGatheringCollisionDispatcher(collisionThreadSupport, threadCount, collisionConfiguration);
+		dispatcher->setDispatcherFlags(btCollisionDispatcher::CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION);
 
-struct CaveAreaContact : public btCollisionWorld::ContactResultCallback
-{
-	CaveAreaContact() {}
-
-	btScalar addSingleResult(btManifoldPoint& cp,
-		const btCollisionObjectWrapper* caveBody,
-		int partId0,
-		int index0,
-		const btCollisionObjectWrapper* playerBody,
-		int partId1,
-		int index1)
+		solverThreadSupport = createThreadSupport("solver", SolverThreadFunc, SolverlsMemoryFunc, threadCount);
+		solver = new btParallelConstraintSolver(solverThreadSupport);
+	}
+	else
+#endif
 	{
+		if (threadCount > 1) {
+			std::cerr << "WARNING: built without SEGANKU_MULTITHREADED_PHYSICS, physics runs on a single thread." << std::endl;
+			threadCount = 1;
+		}
+		collisionConfiguration = new btDefaultCollisionConfiguration();
+		dispatcher = new btCollisionDispatcher(collisionConfiguration);
+		solver = new btSequentialImpulseConstraintSolver();
+	}
+	overlappingPairCache = new btDbvtBroadphase();
 
-		inBush = true;
-
-		return 0;
+	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfiguration);
+#ifdef SEGANKU_MULTITHREADED_PHYSICS
+	if (threadCount > 1) {
+		// the parallel solver solves all islands in one batch
+		dynamicsWorld->getSimulationIslandManager()->setSplitIslands(false);
 	}
-};
+#endif
+	dynamicsWorld->setGravity(btVector3(0, -10, 0));
+
+	debugDrawerPhysics = new SimpleDebugDrawer();
+	dynamicsWorld->setDebugDrawer(debugDrawerPhysics);
+
+	// keep track of the pairs of ghost objects in the broadphase
+	ghostPairCallback = new btGhostPairCallback();
+	overlappingPairCache->getOverlappingPairCache()->setInternalGhostPairCallback(ghostPairCallback);
+}
 
-struct CaveContact : public btCollisionWorld::ContactResultCallback
+void Physics::stepSimulation(float stepSize)
 {
-	CaveContact() {}
-
-	btScalar addSingleResult(btManifoldPoint& cp,
-		const btCollisionObjectWrapper* caveBody,
-		int partId0,
-		int index0,
-		const btCollisionObjectWrapper* playerBody,
-		int partId1,
-		int index1)
-	{
+	Tracer::Scope scope("physics step");
 
-//		inCave = true;
+	// the ghost follows the player body, the narrowphase of its pairs is done during the step
+	playerGhost->setWorldTransform(player->getRigidBody()->getWorldTransform());
 
-		return 0;
-	}
-};
-CarrotContact carrotCallback;
-BushContact bushCallback;
-CaveAreaContact caveAreaCallback;
-CaveContact caveCallback;
+	auto stepStart = std::chrono::high_resolution_clock::now();
+	// exactly one substep of the given size, the caller runs the fixed timestep loop
+	lastStepSize = stepSize;
+	dynamicsWorld->stepSimulation(btScalar(stepSize), 1, btScalar(stepSize));
+	lastStepTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stepStart).count();
+	totalStepTime += lastStepTime;
+	++stepCount;
 
-Physics::Physics(Player *player) : player(player)
+	updateTriggers();
+}
+
+void Physics::interpolateMotionStates(float alpha)
 {
+	// same as the motion state interpolation bullet does internally, but with the interpolation
+	// factor of our own simulation clock: go back from the current transform along the velocities
+	for (int i = 0; i < dynamicsWorld->getNumCollisionObjects(); ++i) {
+		btRigidBody *body = btRigidBody::upcast(dynamicsWorld->getCollisionObjectArray()[i]);
+		if (!body || !body->getMotionState() || body->isStaticOrKinematicObject() || !body->isActive()) {
+			continue;
+		}
+
+		btTransform interpolatedTransform;
+		btTransformUtil::integrateTransform(body->getInterpolationWorldTransform(), body->getInterpolationLinearVelocity(),
+			body->getInterpolationAngularVelocity(), (alpha - 1) * lastStepSize, interpolatedTransform);
+		body->getMotionState()->setWorldTransform(interpolatedTransform);
+	}
 }
 
-Physics::~Physics()
+void Physics::addPlayerToPhysics()
 {
+	btRigidBody *playerBody = player->getRigidBody();
+	dynamicsWorld->addRigidBody(playerBody, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::SensorTrigger);
+
+	playerGhost = new btGhostObject();
+	playerGhost->setCollisionShape(playerBody->getCollisionShape());
+	playerGhost->setWorldTransform(playerBody->getWorldTransform());
+	playerGhost->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
+	playerGhost->setActivationState(DISABLE_DEACTIVATION);
+	playerGhost->setUserPointer(player);
+
+	dynamicsWorld->addCollisionObject(playerGhost, btBroadphaseProxy::CharacterFilter, btBroadphaseProxy::SensorTrigger);
 }
 
-void Physics::init()
+void Physics::addTrigger(Geometry *geometry, btCollisionShape *shape, const btVector3 &position, TriggerType type)
 {
-	drawDebug = false;
-	collisionConfiguration = new btDefaultCollisionConfiguration();
-	dispatcher = new btCollisionDispatcher(collisionConfiguration);
-	overlappingPairCache = new btDbvtBroadphase();
-	solver = new btSequentialImpulseConstraintSolver();
+	btTransform transform;
+	transform.setIdentity();
+	transform.setOrigin(position);
 
-	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfiguration);
-	dynamicsWorld->setGravity(btVector3(0, -10, 0));
+	btCollisionObject *trigger = new btCollisionObject();
+	trigger->setCollisionShape(shape);
+	trigger->setWorldTransform(transform);
+	trigger->setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+	trigger->setUserPointer(geometry);
 
-	debugDrawerPhysics = new SimpleDebugDrawer();
-	dynamicsWorld->setDebugDrawer(debugDrawerPhysics);
-	physicWorld = dynamicsWorld;
+	// triggers only pair with the player ghost in the broadphase, never with each other or the static world
+	dynamicsWorld->addCollisionObject(trigger, btBroadphaseProxy::SensorTrigger, btBroadphaseProxy::CharacterFilter);
+
+	collisionShapes.push_back(shape);
+	triggers[trigger] = { type, geometry };
 }
 
-void Physics::stepSimulation(float deltaT)
+void Physics::updateTriggers()
 {
-	inBush = false;
-	inCave = false;
-	dynamicsWorld->stepSimulation(btScalar(deltaT));
+	std::unordered_set<const btCollisionObject*> overlapped;
+	btOverlappingPairCache *pairCache = overlappingPairCache->getOverlappingPairCache();
+
+	// the ghost only knows the triggers whose aabb overlaps its own,
+	// the contact manifolds of the step tell whether the shapes really overlap
+	for (int i = 0; i < playerGhost->getNumOverlappingObjects(); ++i) {
+		btCollisionObject *other = playerGhost->getOverlappingObject(i);
+		btBroadphasePair *pair = pairCache->findPair(playerGhost->getBroadphaseHandle(), other->getBroadphaseHandle());
+		if (!pair || !pair->m_algorithm) {
+			continue;
+		}
 
-	for (std::vector<btRigidBody*>::iterator it = carrotsGeo.begin(); it != carrotsGeo.end(); ++it) {
-		dynamicsWorld->contactPairTest(*it, player->getRigidBody(), carrotCallback);
+		manifolds.resize(0);
+		pair->m_algorithm->getAllContactManifolds(manifolds);
+
+		bool touching = false;
+		for (int j = 0; j < manifolds.size() && !touching; ++j) {
+			for (int k = 0; k < manifolds[j]->getNumContacts(); ++k) {
+				if (manifolds[j]->getContactPoint(k).getDistance() < 0) {
+					touching = true;
+					break;
+				}
+			}
+		}
+
+		if (touching && triggers.count(other)) {
+			overlapped.insert(other);
+		}
 	}
 
-	for (std::vector<btRigidBody*>::iterator it = bushesGeo.begin(); it != bushesGeo.end(); ++it) {
-		dynamicsWorld->contactPairTest(*it, player->getRigidBody(), bushCallback);
+	for (const btCollisionObject *trigger : overlapped) {
+		const Trigger &info = triggers[trigger];
+		TriggerEvent::Phase phase = overlappedTriggers.count(trigger) ? TriggerEvent::STAY : TriggerEvent::ENTER;
+		triggerEvents.push_back({ phase, info.type, info.geometry, trigger });
 	}
 
-	dynamicsWorld->contactPairTest(caveArea, player->getRigidBody(), caveAreaCallback);
+	for (const btCollisionObject *trigger : overlappedTriggers) {
+		if (!overlapped.count(trigger)) {
+			const Trigger &info = triggers[trigger];
+			triggerEvents.push_back({ TriggerEvent::EXIT, info.type, info.geometry, trigger });
+		}
+	}
 
-	dynamicsWorld->contactPairTest(cave, player->getRigidBody(), caveCallback);
+	overlappedTriggers.swap(overlapped);
+}
 
-	// DELETE THE CARROT WE ALREADY ATE
-	
-	if (toDelete != nullptr) {
-		carrotsGeo.erase(std::find(carrotsGeo.begin(), carrotsGeo.end(), toDelete));
-		deletedBodies.push_back(toDelete);
-		toDelete = nullptr;
+bool Physics::pollTriggerEvent(TriggerEvent &event)
+{
+	if (triggerEvents.empty()) {
+		return false;
 	}
-	
-	player->setInBush(inBush);
-	player->setIsInCave(inCave);
+
+	event = triggerEvents.front();
+	triggerEvents.pop_front();
+	return true;
+}
+
+void Physics::removeTrigger(const btCollisionObject *trigger)
+{
+	if (!triggers.erase(trigger)) {
+		return;
+	}
+	overlappedTriggers.erase(trigger);
+
+	// drop queued events of the trigger so they do not reference the deleted object
+	triggerEvents.erase(std::remove_if(triggerEvents.begin(), triggerEvents.end(),
+		[trigger](const TriggerEvent &event) { return event.trigger == trigger; }), triggerEvents.end());
+
+	btCollisionObject *object = const_cast<btCollisionObject*>(trigger);
+	dynamicsWorld->removeCollisionObject(object);
+	delete object;
 }
 
 void Physics::addTerrainShapeToPhysics(Geometry *geometry)
 {
-	int vertStride = sizeof(btVector3);
-	int indexStride = 3 * sizeof(int);
-	
-	std::vector<Vertex> vertices = geometry->getSurface()->getVertices();
-	std::vector<GLuint> indices = geometry->getSurface()->getIndices();
-	
-	const int triangles = vertices.size() / 3;
-
-	btTriangleMesh *mTriMesh = new btTriangleMesh();
-	for (unsigned int i = 0; i < vertices.size(); i += 3) {
-		btVector3 v1(vertices.at(i).position.x, vertices.at(i).position.y, vertices.at(i).position.z);
-		btVector3 v2(vertices.at(i+1).position.x, vertices.at(i+1).position.y, vertices.at(i+1).position.z);
-		btVector3 v3(vertices.at(i+2).position.x, vertices.at(i+2).position.y, vertices.at(i+2).position.z);
-		mTriMesh->addTriangle(v1, v2, v3);
+	const std::vector<Vertex> &vertices = geometry->getSurface()->getVertices();
+	const std::vector<GLuint> &indices = geometry->getSurface()->getIndices();
+
+	// reference the indexed vertex data of the render mesh directly instead of copying it.
+	// only the position of each Vertex is read, the stride skips the other attributes.
+	btIndexedMesh mesh;
+	mesh.m_numTriangles = indices.size() / 3;
+	mesh.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(indices.data());
+	mesh.m_triangleIndexStride = 3 * sizeof(GLuint);
+	mesh.m_numVertices = vertices.size();
+	mesh.m_vertexBase = reinterpret_cast<const unsigned char*>(vertices.data()) + offsetof(Vertex, position);
+	mesh.m_vertexStride = sizeof(Vertex);
+	mesh.m_indexType = PHY_INTEGER;
+	mesh.m_vertexType = PHY_FLOAT;
+
+	terrainMesh = new btTriangleIndexVertexArray();
+	terrainMesh->addIndexedMesh(mesh, PHY_INTEGER);
+
+	// the bvh is cached next to the model file, e.g. terrain.dae -> terrain.bvh
+	std::string modelPath = geometry->getFilePath();
+	std::string cachePath = modelPath.substr(0, modelPath.find_last_of('.')) + ".bvh";
+
+	BvhCacheHeader header = {};
+	std::memcpy(header.magic, "SGKBVH\0\0", 8);
+	header.version = 1;
+	header.vertexCount = vertices.size();
+	header.indexCount = indices.size();
+	header.meshHash = hashMesh(vertices, indices);
+
+	// try to load the quantized bvh from the cache, otherwise build it and write the cache
+	terrainBvh = loadBvhCache(cachePath, header);
+	if (terrainBvh) {
+		terrainShape = new btBvhTriangleMeshShape(terrainMesh, true, false);
+		terrainShape->setOptimizedBvh(terrainBvh);
+		std::cout << "loaded terrain bvh: " << cachePath << std::endl;
+	}
+	else {
+		terrainShape = new btBvhTriangleMeshShape(terrainMesh, true, true);
+		saveBvhCache(cachePath, header, terrainShape->getOptimizedBvh());
 	}
 
-	btTriangleMeshShape *terrain = new btBvhTriangleMeshShape(mTriMesh, true);
-	
 	btScalar mass(0.);
 	btVector3 localInertia(0, 0, 0);
 
@@ -177,7 +283,7 @@ void Physics::addTerrainShapeToPhysics(Geometry *geometry)
 	
 	//using motionstate is recommended, it provides interpolation capabilities, and only synchronizes 'active' objects
 	btDefaultMotionState *myMotionState = new btDefaultMotionState(groundTransform);
-	btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, myMotionState, terrain, localInertia);
+	btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, myMotionState, terrainShape, localInertia);
 	floor = new btRigidBody(rbInfo);
 	floor->setActivationState(DISABLE_DEACTIVATION);
 	floor->setCollisionFlags(floor->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
@@ -187,105 +293,144 @@ void Physics::addTerrainShapeToPhysics(Geometry *geometry)
 
 }
 
-void Physics::addTreeCylinderToPhysics(Geometry *geometry, btScalar radius)
+unsigned int Physics::hashMesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices)
 {
-	btScalar mass(0.);
-	btVector3 localInertia(0, 0, 0);
-
-	btCollisionShape *shape = new btCylinderShape(btVector3(radius, 10, radius));
-	btTransform transform;
-	transform.setIdentity();
-	transform.setOrigin(btVector3(geometry->getLocation().x, radius, geometry->getLocation().z));
+	// FNV-1a hash over the raw bytes of all positions and indices
+	unsigned int hash = 2166136261u;
+	auto hashBytes = [&hash](const void *data, size_t size) {
+		const unsigned char *bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+	};
 
-	shape->calculateLocalInertia(mass, localInertia);
-	btDefaultMotionState *motionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shape, localInertia);
-	btRigidBody *body = new btRigidBody(info);
-	body->setActivationState(DISABLE_DEACTIVATION);
-	body->setCollisionFlags(body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+	for (const Vertex &vertex : vertices) {
+		hashBytes(&vertex.position, sizeof(vertex.position));
+	}
+	hashBytes(indices.data(), indices.size() * sizeof(GLuint));
 
-	dynamicsWorld->addRigidBody(body);
+	return hash;
 }
 
-void Physics::addFoodSphereToPhysics(Geometry *geometry, btScalar radius)
+btOptimizedBvh *Physics::loadBvhCache(const std::string &filePath, const BvhCacheHeader &expected)
 {
-	btScalar mass(0.);
-	btVector3 localInertia(0, 0, 0);
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		return nullptr;
+	}
 
-	btCollisionShape *shape = new btSphereShape(radius);
-	btTransform transform;
-	transform.setIdentity();
-	transform.setOrigin(btVector3(geometry->getLocation().x, geometry->getLocation().y, geometry->getLocation().z));
+	BvhCacheHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+	          || header.version != expected.version
+	          || header.vertexCount != expected.vertexCount
+	          || header.indexCount != expected.indexCount
+	          || header.meshHash != expected.meshHash) {
+		std::cerr << "WARNING: terrain bvh cache '" << filePath << "' is outdated, rebuilding." << std::endl;
+		return nullptr;
+	}
 
-	shape->calculateLocalInertia(mass, localInertia);
-	btDefaultMotionState *motionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shape, localInertia);
-	btRigidBody *body = new btRigidBody(info);
-	body->setActivationState(DISABLE_DEACTIVATION);
-	body->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
-	body->setUserPointer(geometry);
+	// the bvh is deserialized in place, so the buffer must be aligned and stay alive as long as the bvh is used
+	terrainBvhBuffer = btAlignedAlloc(header.bvhSize, 16);
+	file.read(static_cast<char*>(terrainBvhBuffer), header.bvhSize);
+	if (!file) {
+		std::cerr << "WARNING: terrain bvh cache '" << filePath << "' is incomplete, rebuilding." << std::endl;
+		btAlignedFree(terrainBvhBuffer);
+		terrainBvhBuffer = nullptr;
+		return nullptr;
+	}
 
-	carrotsGeo.push_back(body);
+	btOptimizedBvh *bvh = btOptimizedBvh::deSerializeInPlace(terrainBvhBuffer, header.bvhSize, false);
+	if (!bvh) {
+		std::cerr << "WARNING: terrain bvh cache '" << filePath << "' is damaged, rebuilding." << std::endl;
+		btAlignedFree(terrainBvhBuffer);
+		terrainBvhBuffer = nullptr;
+		return nullptr;
+	}
 
-	dynamicsWorld->addRigidBody(body);
+	return bvh;
 }
 
-void Physics::addBushSphereToPhysics(Geometry *geometry, btScalar radius)
+void Physics::saveBvhCache(const std::string &filePath, BvhCacheHeader header, const btOptimizedBvh *bvh)
+{
+	header.bvhSize = bvh->calculateSerializeBufferSize();
+
+	void *buffer = btAlignedAlloc(header.bvhSize, 16);
+	bvh->serializeInPlace(buffer, header.bvhSize, false);
+
+	// write to a temporary file and rename it, so worlds loading the cache meanwhile never read a partial file
+	std::lock_guard<std::mutex> lock(bvhCacheMutex);
+	std::string temporaryPath = filePath + ".tmp";
+	bool written;
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(buffer), header.bvhSize);
+		written = bool(file);
+	}
+	btAlignedFree(buffer);
+
+	std::remove(filePath.c_str());
+	if (!written || std::rename(temporaryPath.c_str(), filePath.c_str()) != 0) {
+		std::cerr << "WARNING: could not write terrain bvh cache '" << filePath << "'." << std::endl;
+		std::remove(temporaryPath.c_str());
+	}
+}
+
+void Physics::addTreeCylinderToPhysics(Geometry *geometry, btScalar radius)
 {
 	btScalar mass(0.);
 	btVector3 localInertia(0, 0, 0);
 
-	btCollisionShape *shape = new btSphereShape(radius);
-	
+	btCollisionShape *shape = new btCylinderShape(btVector3(radius, 10, radius));
 	btTransform transform;
 	transform.setIdentity();
-	transform.setOrigin(btVector3(geometry->getLocation().x, geometry->getLocation().y, geometry->getLocation().z));
+	transform.setOrigin(btVector3(geometry->getLocation().x, radius, geometry->getLocation().z));
 
 	shape->calculateLocalInertia(mass, localInertia);
 	btDefaultMotionState *motionState = new btDefaultMotionState(transform);
 	btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shape, localInertia);
 	btRigidBody *body = new btRigidBody(info);
 	body->setActivationState(DISABLE_DEACTIVATION);
-	body->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
-	body->setUserPointer(geometry);
-
-	bushesGeo.push_back(body);
+	body->setCollisionFlags(body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
 
 	dynamicsWorld->addRigidBody(body);
 }
 
+void Physics::addFoodSphereToPhysics(Geometry *geometry, btScalar radius)
+{
+	glm::vec3 location = geometry->getLocation();
+	addTrigger(geometry, new btSphereShape(radius), btVector3(location.x, location.y, location.z), FOOD_TRIGGER);
+}
+
+void Physics::addBushSphereToPhysics(Geometry *geometry, btScalar radius)
+{
+	glm::vec3 location = geometry->getLocation();
+	addTrigger(geometry, new btSphereShape(radius), btVector3(location.x, location.y, location.z), HIDING_TRIGGER);
+}
+
 void Physics::setupCaveObjects(Geometry *geometry)
 {
 	btScalar mass(0.);
 	btVector3 localInertia(0, 0, 0);
 
-	btCollisionShape *shapeArea = new btSphereShape(btScalar(3.));
-	btCollisionShape *shapeCave = new btSphereShape(btScalar(1.5));
-
 	// 1.5, 1.5, 2
 	// 4.5, 4, 4.5
 	btCollisionShape *shapeEnd = new btBoxShape(btVector3(2, 2, 0.15));
 	btCollisionShape *shapeSide1 = new btBoxShape(btVector3(0.15, 2, 2.25));
 	btCollisionShape *shapeSide2 = new btBoxShape(btVector3(0.15, 2, 2.25));
 
-	// setup Cave Area -> no collision
+	btVector3 caveLocation(geometry->getLocation().x, geometry->getLocation().y, geometry->getLocation().z);
+
+	// setup Cave Area -> no collision -> hides the player like a bush
+	addTrigger(geometry, new btSphereShape(btScalar(3.)), caveLocation, HIDING_TRIGGER);
+
+	// setup inside cave -> no collision -> zone to be in for win.
+	// the player sphere has radius 1, so the player is inside once closer than 2 to the cave
+	addTrigger(geometry, new btSphereShape(btScalar(1.)), caveLocation, CAVE_TRIGGER);
+
 	btTransform transform;
 	transform.setIdentity();
-	transform.setOrigin(btVector3(geometry->getLocation().x, geometry->getLocation().y, geometry->getLocation().z));
-	shapeArea->calculateLocalInertia(mass, localInertia);
-	btDefaultMotionState *motionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shapeArea, localInertia);
-	caveArea = new btRigidBody(info);
-	caveArea->setActivationState(DISABLE_DEACTIVATION);
-	caveArea->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
-
-	// setup inside cave -> no collision -> zone to be in for win
-	shapeCave->calculateLocalInertia(mass, localInertia);
-	btDefaultMotionState *motionState2 = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo info2(mass, motionState2, shapeCave, localInertia);
-	cave = new btRigidBody(info2);
-	cave->setActivationState(DISABLE_DEACTIVATION);
-	cave->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
 
 	// setup cave walls -> collision -> back wall
 	transform.setOrigin(btVector3(geometry->getLocation().x, geometry->getLocation().y, geometry->getLocation().z-2.5));
@@ -315,8 +460,52 @@ void Physics::setupCaveObjects(Geometry *geometry)
 	dynamicsWorld->addRigidBody(caveSide1);
 	dynamicsWorld->addRigidBody(caveSide2);
 	dynamicsWorld->addRigidBody(caveBack);
-	dynamicsWorld->addRigidBody(caveArea);
-	dynamicsWorld->addRigidBody(cave);
+}
+
+void Physics::addStressBodies(int count, const btVector3 &boundsMin, const btVector3 &boundsMax)
+{
+	btCollisionShape *sphereShape = new btSphereShape(btScalar(0.5));
+	btCollisionShape *boxShape = new btBoxShape(btVector3(0.4, 0.4, 0.4));
+	collisionShapes.push_back(sphereShape);
+	collisionShapes.push_back(boxShape);
+
+	// fixed seed so runs with different thread counts simulate the same scene
+	std::mt19937 randGen(1234);
+	std::uniform_real_distribution<float> randX(boundsMin.x(), boundsMax.x());
+	std::uniform_real_distribution<float> randY(boundsMin.y(), boundsMax.y());
+	std::uniform_real_distribution<float> randZ(boundsMin.z(), boundsMax.z());
+
+	btScalar mass(1.);
+	for (int i = 0; i < count; ++i) {
+		btCollisionShape *shape = (i % 2 == 0) ? sphereShape : boxShape;
+		btVector3 localInertia(0, 0, 0);
+		shape->calculateLocalInertia(mass, localInertia);
+
+		btTransform transform;
+		transform.setIdentity();
+		transform.setOrigin(btVector3(randX(randGen), randY(randGen), randZ(randGen)));
+
+		btDefaultMotionState *motionState = new btDefaultMotionState(transform);
+		btRigidBody::btRigidBodyConstructionInfo info(mass, motionState, shape, localInertia);
+		btRigidBody *body = new btRigidBody(info);
+
+		dynamicsWorld->addRigidBody(body);
+	}
+}
+
+int Physics::getThreadCount()
+{
+	return threadCount;
+}
+
+double Physics::getLastStepTime()
+{
+	return lastStepTime;
+}
+
+double Physics::getAverageStepTime()
+{
+	return stepCount > 0 ? totalStepTime / stepCount : 0;
 }
 
 void Physics::debugDrawWorld(bool draw)
@@ -356,17 +545,40 @@ void Physics::cleanUp()
 		delete obj;
 	}
 
+	// the ghost and the triggers were deleted with the other collision objects
+	playerGhost = nullptr;
+	triggers.clear();
+	overlappedTriggers.clear();
+	triggerEvents.clear();
+
 	for (int j = 0; j<collisionShapes.size(); j++) {
 		btCollisionShape* shape = collisionShapes[j];
 		collisionShapes[j] = 0;
 		delete shape;
 	}
 
+	// the terrain shape does not own a bvh loaded from the cache, which lives in its own buffer
+	delete terrainShape; terrainShape = nullptr;
+	delete terrainMesh; terrainMesh = nullptr;
+	if (terrainBvhBuffer) {
+		if (terrainBvh) {
+			terrainBvh->~btOptimizedBvh();
+		}
+		btAlignedFree(terrainBvhBuffer);
+		terrainBvhBuffer = nullptr;
+	}
+	terrainBvh = nullptr;
+
 	delete debugDrawerPhysics;
 	delete dynamicsWorld;
 	delete solver;
 	delete overlappingPairCache;
+	delete ghostPairCallback;
 	delete dispatcher;
+#ifdef SEGANKU_MULTITHREADED_PHYSICS
+	delete solverThreadSupport; solverThreadSupport = nullptr;
+	delete collisionThreadSupport; collisionThreadSupport = nullptr;
+#endif
 	delete collisionConfiguration;
 	collisionShapes.clear();
 }
@@ -3,14 +3,52 @@
 
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+
+#include <string>
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <mutex>
 #include "simpledebugdrawer.h"
 #include "geometry.h"
 #include "player.h"
 
+class btThreadSupportInterface;
+
 class Physics
 {
 public:
-	Physics(Player *player);
+	/**
+	* @brief what a trigger volume is used for in the game
+	*/
+	enum TriggerType { FOOD_TRIGGER, HIDING_TRIGGER, CAVE_TRIGGER };
+
+	/**
+	* @brief event generated when the player enters, stays in or exits a trigger volume
+	*/
+	struct TriggerEvent {
+		enum Phase { ENTER, STAY, EXIT };
+
+		Phase phase;
+		TriggerType type;
+		Geometry *geometry;                 // the geometry the trigger belongs to, may be nullptr
+		const btCollisionObject *trigger;   // pass to removeTrigger to remove the trigger volume
+	};
+
+	/**
+	* @param player the player
+	* @param threadCount number of worker threads for collision dispatching and constraint solving.
+	* more than one thread is only used if built with SEGANKU_MULTITHREADED_PHYSICS.
+	*/
+	Physics(Player *player, int threadCount = 1);
 	~Physics();
 
 	/**
@@ -24,10 +62,37 @@ public:
 	void cleanUp();
 
 	/**
-	* @brief step the physics simulation ahead
-	* @param deltaT deltaTime
+	* @brief step the physics simulation ahead by one step.
+	* the motion states of the bodies are left at the transform before the step, see interpolateMotionStates.
+	* @param stepSize the fixed simulation step size
+	*/
+	void stepSimulation(float stepSize);
+
+	/**
+	* @brief set the motion states of all dynamic bodies to their transform interpolated
+	* between the state before and after the last step, to be used for rendering
+	* @param alpha interpolation factor, 0 gives the previous and 1 the current transform
 	*/
-	void stepSimulation(float deltaT);
+	void interpolateMotionStates(float alpha);
+
+	/**
+	* @brief add the player rigid body and the ghost object used to detect trigger overlaps.
+	* the player body does not collide with trigger volumes, only the ghost overlaps them.
+	*/
+	void addPlayerToPhysics();
+
+	/**
+	* @brief take the next trigger event generated during the last stepSimulation calls
+	* @param event is set to the next event
+	* @return false if there are no more events
+	*/
+	bool pollTriggerEvent(TriggerEvent &event);
+
+	/**
+	* @brief remove a trigger volume from the physics world, no exit event is generated for it
+	* @param trigger the trigger of an event
+	*/
+	void removeTrigger(const btCollisionObject *trigger);
 
 	/**
 	* @brief use debugDrawer -> NOT IMPLEMENTED
@@ -36,14 +101,14 @@ public:
 	void debugDrawWorld(bool draw);
 
 	/**
-	* @brief add a new CollisionBody to the Physics World, no Collision Handling set
+	* @brief add a food trigger volume to the Physics World
 	* @param geometry the geometry object that is to be a collision object (-> use for Carrots and other food)
 	* @param radius radius for the Sphere Collision Object
 	*/
 	void addFoodSphereToPhysics(Geometry *geometry, btScalar radius);
 	
 	/**
-	* @brief add a new CollisionBody to the Physics World, no Collision Handling set
+	* @brief add a hiding trigger volume to the Physics World
 	* @param geometry the geometry object that is to be a collision object (-> use for Bushes and other objects for hiding)
 	* @param radius radius for the Sphere Collision Object
 	*/
@@ -57,7 +122,11 @@ public:
 	void addTreeCylinderToPhysics(Geometry *geometry, btScalar radius);
 
 	/**
-	* @brief add the TerrainShape to the physics world, for now btCollisionBox is made, later should be made with mesh
+	* @brief add the terrain mesh to the physics world as static triangle mesh.
+	* the collision shape references the vertex and index data of the terrain surface without copying it,
+	* so the surface must stay alive until cleanUp. the bvh of the mesh is loaded from a cache file
+	* next to the model file if it is valid, otherwise it is built and the cache file is written.
+	* @param geometry the terrain geometry, must consist of a single surface
 	*/
 	void addTerrainShapeToPhysics(Geometry *geometry);
 
@@ -73,20 +142,62 @@ public:
 	*/
 	btDiscreteDynamicsWorld *getDynamicsWorld();
 
+	/**
+	* @brief add the cave walls, a hiding trigger around the cave and a cave trigger inside it
+	* @param geometry the cave geometry
+	*/
 	void setupCaveObjects(Geometry *geometry);
 
+	/**
+	* @brief add dynamic spheres and boxes dropped at random positions, to stress test the simulation
+	* @param count number of bodies
+	* @param boundsMin minimum corner of the box the bodies are spawned in
+	* @param boundsMax maximum corner of the box the bodies are spawned in
+	*/
+	void addStressBodies(int count, const btVector3 &boundsMin, const btVector3 &boundsMax);
+
+	/**
+	* @return number of worker threads the simulation actually runs on
+	*/
+	int getThreadCount();
+
+	/**
+	* @return duration of the last stepSimulation call in milliseconds
+	*/
+	double getLastStepTime();
+
+	/**
+	* @return average duration of all stepSimulation calls in milliseconds
+	*/
+	double getAverageStepTime();
+
 private:
 
 	Player *player;
+	int threadCount;
+
+	float lastStepSize = 0;
+	double lastStepTime = 0;
+	double totalStepTime = 0;
+	unsigned int stepCount = 0;
 
 	btRigidBody *floor;
-	btRigidBody *cave, *caveArea;
+
+	// terrain collision mesh referencing the render mesh data, and its bvh
+	btTriangleIndexVertexArray *terrainMesh = nullptr;
+	btBvhTriangleMeshShape *terrainShape = nullptr;
+	btOptimizedBvh *terrainBvh = nullptr;
+	void *terrainBvhBuffer = nullptr; // aligned buffer the bvh was deserialized into, if loaded from cache
 
 	bool drawDebug;
 	btDefaultCollisionConfiguration *collisionConfiguration;
 	btCollisionDispatcher *dispatcher;
 	btBroadphaseInterface *overlappingPairCache;
 	btSequentialImpulseConstraintSolver *solver;
+
+	// worker threads of the multithreaded dispatcher and solver, nullptr if single threaded
+	btThreadSupportInterface *collisionThreadSupport = nullptr;
+	btThreadSupportInterface *solverThreadSupport = nullptr;
 	
 	btDiscreteDynamicsWorld *dynamicsWorld;
 
@@ -94,9 +205,66 @@ private:
 	
 	SimpleDebugDrawer *debugDrawerPhysics;
 
-	std::vector<btRigidBody*> carrotsGeo;
-	std::vector<btRigidBody*> bushesGeo;
-	std::vector<btRigidBody*> deletedBodies;
+	// trigger volumes are only tested against the player ghost through the broadphase collision filter,
+	// so a step only visits the triggers the player is actually near
+	struct Trigger {
+		TriggerType type;
+		Geometry *geometry;
+	};
+	btGhostObject *playerGhost = nullptr;
+	btGhostPairCallback *ghostPairCallback = nullptr;
+	std::unordered_map<const btCollisionObject*, Trigger> triggers;
+	std::unordered_set<const btCollisionObject*> overlappedTriggers; // triggers overlapped after the last step
+	std::deque<TriggerEvent> triggerEvents;
+	btManifoldArray manifolds; // reused to collect the contact manifolds of a pair
+
+	/**
+	* @brief add a static trigger volume that only generates events for the player
+	*/
+	void addTrigger(Geometry *geometry, btCollisionShape *shape, const btVector3 &position, TriggerType type);
+
+	/**
+	* @brief find the triggers overlapping the player ghost and queue enter, stay and exit events
+	*/
+	void updateTriggers();
+
+	// serializes writing the bvh cache file, several game worlds may add their terrain in parallel.
+	// reading needs no lock, the file is replaced as a whole
+	static std::mutex bvhCacheMutex;
+
+	/**
+	* @brief header of the terrain bvh cache file, used to validate that the cache matches the mesh
+	*/
+	struct BvhCacheHeader {
+		char magic[8];
+		unsigned int version;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		unsigned int meshHash;
+		unsigned int bvhSize;
+	};
+
+	/**
+	* @brief calculate a hash of the vertex positions and indices of a mesh
+	* @return the hash value
+	*/
+	static unsigned int hashMesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices);
+
+	/**
+	* @brief load a serialized bvh from a cache file into terrainBvhBuffer
+	* @param filePath the path of the cache file
+	* @param expected the header the file must match (apart from the bvh size)
+	* @return the deserialized bvh, or nullptr if the file is missing or does not match
+	*/
+	btOptimizedBvh *loadBvhCache(const std::string &filePath, const BvhCacheHeader &expected);
+
+	/**
+	* @brief serialize a bvh to a cache file
+	* @param filePath the path of the cache file
+	* @param header the header to write, the bvh size is set here
+	* @param bvh the bvh to serialize
+	*/
+	void saveBvhCache(const std::string &filePath, BvhCacheHeader header, const btOptimizedBvh *bvh);
 };
 
 #endif// PHYSICS_H
@@ -1,16 +1,12 @@
 #include "player.h"
 
 Player::CameraNavigationMode Player::cameraNavMode = FOLLOW_PLAYER;
-double Player::scrollY = 0.0;
 
-Player::Player(const glm::mat4 &matrix_, Camera *camera_, GLFWwindow *window_, const std::string &filePath)
+Player::Player(const glm::mat4 &matrix_, Camera *camera_, InputSource *input_, const std::string &filePath)
     : Geometry(matrix_, filePath)
     , camera(camera_)    
-    , window(window_)
+    , input(input_)
 {
-	// set glfw callbacks
-	glfwSetScrollCallback(window, onScroll);
-
 	camera->setTransform(glm::translate(glm::mat4(1.0f), getLocation()+glm::vec3(0,2,6)));  //move camera back a bit
 	lastCamTransform = camera->getMatrix();
 	camDirection = glm::normalize(camera->getLocation() - getLocation());
@@ -38,7 +34,7 @@ Player::Player(const glm::mat4 &matrix_, Camera *camera_, GLFWwindow *window_, c
 Player::~Player()
 {
 	delete camera; camera = nullptr;
-	window = nullptr;
+	input = nullptr;
 }
 
 void Player::update(float timeDelta)
@@ -65,13 +61,12 @@ void Player::update(float timeDelta)
 
 	if (cameraNavMode == FOLLOW_PLAYER) {
 
-		handleInput(window, timeDelta);
-		glm::vec3 v = glm::normalize(getLocation() - camera->getLocation()) * 5.0f;
-		viewMat = glm::lookAt(getLocation()-v, getLocation() + glm::vec3(0, 1, 0), camUp);
+		handleInput(timeDelta);
+		viewMat = calculateFollowViewMat(getLocation(), camera->getLocation());
 	}
 	else {
 
-		handleInputFreeCamera(window, timeDelta);
+		handleInputFreeCamera(timeDelta);
 		viewMat = camera->getViewMatrix();
 	}
 
@@ -90,19 +85,39 @@ void Player::update(float timeDelta)
 
 }
 
-void Player::draw(Shader *shader, bool useFrustumCulling, Texture::FilterType filterType, const glm::mat4 &viewMat)
+void Player::storePreviousMatrix()
 {
-	Geometry::draw(shader, camera, useFrustumCulling, filterType, viewMat);
+	Geometry::storePreviousMatrix();
+	camera->storePreviousMatrix();
+}
+
+void Player::interpolateRenderMatrix(float alpha)
+{
+	Geometry::interpolateRenderMatrix(alpha);
+	camera->interpolateRenderMatrix(alpha);
+
+	if (cameraNavMode == FOLLOW_PLAYER) {
+		renderViewMat = calculateFollowViewMat(getRenderMatrix()[3].xyz(), camera->getRenderMatrix()[3].xyz());
+	}
+	else {
+		renderViewMat = glm::inverse(camera->getRenderMatrix());
+	}
 }
 
-void Player::handleInput(GLFWwindow *window, float timeDelta)
+glm::mat4 Player::calculateFollowViewMat(const glm::vec3 &location, const glm::vec3 &cameraLocation)
+{
+	glm::vec3 v = glm::normalize(location - cameraLocation) * 5.0f;
+	return glm::lookAt(location - v, location + glm::vec3(0, 1, 0), camUp);
+}
+
+void Player::handleInput(float timeDelta)
 {
 	bool speeding = false;
 
 	float moveSpeed = 8;
 
 	// speeding is only allowed if player is not overweight and he has not run for longer than MAX_RUN_TIME
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) && !overWeight && canRun) {
+	if (input->isKeyDown(GLFW_KEY_LEFT_SHIFT) && !overWeight && canRun) {
 		moveSpeed = 16;
 		speeding = true;
 
@@ -131,20 +146,17 @@ void Player::handleInput(GLFWwindow *window, float timeDelta)
 	// player movement
 	// note: we apply rotation before translation since we dont want the distance from the origin
 	// to affect how we rotate
-    if (glfwGetKey(window, 'W')) { //  && timePassed == 0
+    if (input->isKeyDown('W')) { //  && timePassed == 0
 		playerBody->setLinearVelocity(btVector3(dirWorld.x, -1, dirWorld.z) * moveSpeed);
-		btTransform trans; 
-		playerBody->getMotionState()->getWorldTransform(trans);//->getWorldTransform(trans);
+		btTransform trans = playerBody->getWorldTransform();
 
 		setLocation(glm::vec3(trans.getOrigin().getX(), trans.getOrigin().getY(), trans.getOrigin().getZ()));
 		
 		moving = true;
     }
-	else if (glfwGetKey(window, 'S')) { // && timePassed == 0
+	else if (input->isKeyDown('S')) { // && timePassed == 0
 		playerBody->setLinearVelocity(btVector3(-dirWorld.x, -1, -dirWorld.z) * moveSpeed);
-		//btTransform trans = playerBody->getWorldTransform();//->getWorldTransform(trans);
-		btTransform trans;
-		playerBody->getMotionState()->getWorldTransform(trans);//->getWorldTransform(trans);
+		btTransform trans = playerBody->getWorldTransform();
 
 		setLocation(glm::vec3(trans.getOrigin().getX(), trans.getOrigin().getY(), trans.getOrigin().getZ()));
 
@@ -153,25 +165,23 @@ void Player::handleInput(GLFWwindow *window, float timeDelta)
 	else {
 		playerBody->setLinearVelocity(btVector3(0, 0, 0) * moveSpeed);
 
-		btTransform trans;
-		playerBody->getMotionState()->getWorldTransform(trans);//->getWorldTransform(trans);
+		btTransform trans = playerBody->getWorldTransform();
 
 		setLocation(glm::vec3(trans.getOrigin().getX(), trans.getOrigin().getY(), trans.getOrigin().getZ()));
 	}
 
-	if (glfwGetKey(window, 'A')) {
+	if (input->isKeyDown('A')) {
 		rotateY(timeDelta * glm::radians(200.f), SceneObject::RIGHT);
     }
-	else if (glfwGetKey(window, 'D')) {
+	else if (input->isKeyDown('D')) {
 		rotateY(timeDelta * glm::radians(-200.f), SceneObject::RIGHT);
     }
 
 	
-	//// rotate camera based on mouse movement
-	//// the mouse pointer is reset to (0, 0) every frame, and we just take the displacement of that frame
+	//// rotate camera based on mouse movement since the last update
 	const float mouseSensitivity = 0.01f;
-	double mouseX, mouseY;
-	glfwGetCursorPos(window, &mouseX, &mouseY);
+	glm::vec2 mouseDelta = input->takeCursorDelta();
+	float mouseX = mouseDelta.x, mouseY = mouseDelta.y;
 
 	glm::vec3 camToTarget = camera->getLocation() - getLocation();
 	glm::vec3 rightVec = glm::normalize(glm::cross(camToTarget, glm::vec3(0, 1, 0)));
@@ -183,16 +193,13 @@ void Player::handleInput(GLFWwindow *window, float timeDelta)
 	camToTarget = camToTarget + getLocation();
 	camera->setLocation(camToTarget);
 
-	glfwSetCursorPos(window, 0, 0); // reset the mouse, so it doesn't leave the window
-
 
 	//// handle camera zoom by changing the field of view depending on mouse scroll since last frame
 	float zoomSensitivity = -0.1f;
-	float fieldOfView = camera->getFieldOfView() + zoomSensitivity * (float)scrollY;
+	float fieldOfView = camera->getFieldOfView() + zoomSensitivity * (float)input->takeScrollDelta();
 	if (fieldOfView < glm::radians(ZOOM_MIN)) fieldOfView = glm::radians(ZOOM_MIN);
 	if (fieldOfView > glm::radians(ZOOM_MAX)) fieldOfView = glm::radians(ZOOM_MAX);
 	camera->setFieldOfView(fieldOfView);
-	scrollY = 0.0;	
 
 
 	// Handle Carrot Consumption
@@ -220,11 +227,11 @@ void Player::handleInput(GLFWwindow *window, float timeDelta)
 
 }
 
-void Player::handleInputFreeCamera(GLFWwindow *window, float timeDelta)
+void Player::handleInputFreeCamera(float timeDelta)
 {
 
 	float moveSpeed = 10.0f;
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT)) {
+	if (input->isKeyDown(GLFW_KEY_LEFT_SHIFT)) {
 		moveSpeed = 50.0f;
 	}
 	
@@ -235,54 +242,46 @@ void Player::handleInputFreeCamera(GLFWwindow *window, float timeDelta)
 	// camera movement
 	// note: we apply rotation before translation since we dont want the distance from the origin
 	// to affect how we rotate
-    if (glfwGetKey(window, 'W')) {
+    if (input->isKeyDown('W')) {
 		camera->translate(camera->getMatrix()[2].xyz() * -timeDelta * moveSpeed, SceneObject::LEFT);
     }
-	else if (glfwGetKey(window, 'S')) {
+	else if (input->isKeyDown('S')) {
 		camera->translate(camera->getMatrix()[2].xyz() * timeDelta * moveSpeed, SceneObject::LEFT);
 	}
 
-	if (glfwGetKey(window, 'A')) {
+	if (input->isKeyDown('A')) {
 		camera->translate(camera->getMatrix()[0].xyz() * -timeDelta * moveSpeed, SceneObject::LEFT);
     }
-	else if (glfwGetKey(window, 'D')) {
+	else if (input->isKeyDown('D')) {
 		camera->translate(camera->getMatrix()[0].xyz() * timeDelta * moveSpeed, SceneObject::LEFT);
     }
 
-	if (glfwGetKey(window, 'Q')) {
+	if (input->isKeyDown('Q')) {
 	    camera->translate(glm::vec3(0,1,0) * timeDelta * moveSpeed, SceneObject::LEFT);
 	}
-	else if (glfwGetKey(window, 'E')) {
+	else if (input->isKeyDown('E')) {
 	    camera->translate(glm::vec3(0,1,0) * -timeDelta * moveSpeed, SceneObject::LEFT);
 	}
 
-	// rotate camera based on mouse movement
-	// the mouse pointer is reset to (0, 0) every frame, and we just take the displacement of that frame
+	// rotate camera based on mouse movement since the last update
 	const float mouseSensitivity = 0.01f;
-	double mouseX, mouseY;
-	glfwGetCursorPos(window, &mouseX, &mouseY);
+	glm::vec2 mouseDelta = input->takeCursorDelta();
+	float mouseX = mouseDelta.x, mouseY = mouseDelta.y;
 	camera->rotateX(-mouseSensitivity * (float)mouseY, SceneObject::RIGHT); // rotate around local x axis (tilt up/down)
 	glm::vec3 location = camera->getLocation();
 	camera->translate(-location, SceneObject::LEFT);
 	camera->rotateY(-mouseSensitivity * (float)mouseX, SceneObject::LEFT); // rotate around global y at local position
 	camera->translate(location, SceneObject::LEFT);
-	glfwSetCursorPos(window, 0, 0); // reset the mouse, so it doesn't leave the window
 
 	// handle camera zoom by changing the field of view depending on mouse scroll since last frame
 	float zoomSensitivity = -0.1f;
-	float fieldOfView = camera->getFieldOfView() + zoomSensitivity * (float)scrollY;
+	float fieldOfView = camera->getFieldOfView() + zoomSensitivity * (float)input->takeScrollDelta();
 	if (fieldOfView < glm::radians(ZOOM_MIN)) fieldOfView = glm::radians(ZOOM_MIN);
 	if (fieldOfView > glm::radians(ZOOM_MAX)) fieldOfView = glm::radians(ZOOM_MAX);
 	camera->setFieldOfView(fieldOfView);
-	scrollY = 0.0;
 
 }
 
-void Player::onScroll(GLFWwindow *window, double deltaX, double deltaY)
-{
-	scrollY += deltaY;
-}
-
 void Player::toggleNavMode()
 {
 	if (cameraNavMode == FOLLOW_PLAYER) {
@@ -365,6 +364,11 @@ glm::mat4 Player::getViewMat()
 	return viewMat;
 }
 
+glm::mat4 Player::getRenderViewMat()
+{
+	return renderViewMat;
+}
+
 glm::mat4 Player::getProjMat()
 {
 	return projMat;
@@ -399,7 +403,7 @@ void Player::resetPlayer()
 
 bool Player::isEating()
 {
-	return animDur > 0;
+	return currentFood != nullptr;
 }
 
 std::string Player::getFoodReaction()
@@ -6,23 +6,25 @@
 #include <btBulletDynamicsCommon.h>
 #include "geometry.h"
 #include "camera.h"
+#include "inputsource.h"
 
 #define ZOOM_MIN 30.0f
 #define ZOOM_MAX 80.0f
 
 /**
  * @brief The Player class. This stores the player Geometry and a Camera,
- * as well as a GLFWwindow to handle input.
+ * as well as an InputSource to handle input.
  */
 class Player : public Geometry
 {
 	// CAMERA SPECS 
 	Camera *camera;
-	GLFWwindow *window;
+	InputSource *input;
 	glm::vec3 camDirection;
 	glm::vec3 camRight;
 	glm::vec3 camUp;
 	glm::mat4 viewMat;
+	glm::mat4 renderViewMat; // view matrix interpolated between simulation steps
 	glm::mat4 projMat;
 
 	enum CameraNavigationMode
@@ -71,44 +73,50 @@ class Player : public Geometry
 
 	std::vector<Geometry*> eatenCarrots;
 
-	static double scrollY; // amount scrolled since last frame
-
 	/**
 	 * @brief check if the camera navigation mode has changed and set camera accordingly
 	 * note: currently only works if there are only 2 nav modes
 	 */
 	void handleNavModeChange();
 
-	/**
-	 * @brief glfw callback on mouse scroll
-	 * @param window pointer to active window
-	 * @param deltaX the scroll delta on scroll axis X
-	 * @param deltaY the scroll delta on scroll axis Y
-	 */
-	static void onScroll(GLFWwindow *window, double deltaX, double deltaY);
-
 	/**
 	 * @brief handle input to control player and camera.
 	 * the camera follows the player geometry and looks at it, while allowing to be rotated around it.
-	 * @param window pointer to active window
 	 * @param timeDelta the time passed since the last frame in seconds
 	 */
-	void handleInput(GLFWwindow *window, float timeDelta);
+	void handleInput(float timeDelta);
 
 	/**
 	 * @brief handle input to control camera in free fly mode.
-	 * @param window pointer to active window
 	 * @param timeDelta the time passed since the last frame in seconds
 	 */
-	void handleInputFreeCamera(GLFWwindow *window, float timeDelta);
+	void handleInputFreeCamera(float timeDelta);
+
+	/**
+	 * @brief calculate the view matrix of the camera following the player
+	 * @param location the player location
+	 * @param cameraLocation the camera location
+	 * @return the view matrix
+	 */
+	glm::mat4 calculateFollowViewMat(const glm::vec3 &location, const glm::vec3 &cameraLocation);
 
 
 public:
-	Player(const glm::mat4 &matrix_, Camera *camera_, GLFWwindow *window_, const std::string &filePath);
+	Player(const glm::mat4 &matrix_, Camera *camera_, InputSource *input_, const std::string &filePath);
 	virtual ~Player();
 
 	virtual void update(float timeDelta);
-	virtual void draw(Shader *shader, bool useFrustumCulling, Texture::FilterType filterType, const glm::mat4 &viewMat);
+
+	/**
+	 * @brief remember the player and camera matrices before the next simulation step
+	 */
+	virtual void storePreviousMatrix();
+
+	/**
+	 * @brief interpolate the player and camera matrices and the view matrix for rendering
+	 * @param alpha interpolation factor between the previous and the last simulation step
+	 */
+	virtual void interpolateRenderMatrix(float alpha);
 
 	/**
 	 * @brief toggle the camera navigation mode
@@ -121,6 +129,12 @@ public:
 	 */
 	glm::mat4 getViewMat();
 
+	/**
+	 * @brief get the view matrix of the player camera interpolated for rendering
+	 * @return the interpolated view matrix
+	 */
+	glm::mat4 getRenderViewMat();
+
 	/**
 	 * @brief get the current projection matrix of the player camera
 	 * @return the current projection matrix
@@ -1,21 +1,18 @@
 #include "poissondisksampler.h"
 
-std::random_device PoissonDiskSampler::rd;
-std::mt19937 PoissonDiskSampler::gen(rd());
-std::uniform_real_distribution<float> PoissonDiskSampler::distribution(0.0, 1.0);
-
-float PoissonDiskSampler::randomFloat()
+float PoissonDiskSampler::randomFloat(std::mt19937 &gen)
 {
+	std::uniform_real_distribution<float> distribution(0.0, 1.0);
 	auto rand = std::bind(distribution, std::ref(gen));
 	return static_cast<float>(float(rand()));
 }
 
-glm::vec2 PoissonDiskSampler::generateRandomNeighbour(const glm::vec2 &position, float minDist)
+glm::vec2 PoissonDiskSampler::generateRandomNeighbour(const glm::vec2 &position, float minDist, std::mt19937 &gen)
 {
 	// random radius in range [minDist, 2*minDist]
 	// random angle in range [0, 2*pi]
-	float radius = (1.0f + randomFloat()) * minDist;
-	float angle = 2 * 3.141592653589f * randomFloat();
+	float radius = (1.0f + randomFloat(gen)) * minDist;
+	float angle = 2 * 3.141592653589f * randomFloat(gen);
 
 	return glm::vec2(position.x + radius*cos(angle), position.y + radius*sin(angle));
 }
@@ -45,7 +42,7 @@ bool PoissonDiskSampler::isInNeighbourhood(const glm::vec2 &position, const std:
 	return false;
 }
 
-std::vector<glm::vec2> PoissonDiskSampler::generatePoissonSample(unsigned int sampleSize, float minDist, int maxNeighboursToTry)
+std::vector<glm::vec2> PoissonDiskSampler::generatePoissonSample(unsigned int sampleSize, float minDist, std::mt19937 &gen, int maxNeighboursToTry)
 {
 	std::vector<glm::vec2> samplePositions; // resulting positions
 	std::vector<glm::vec2> processPositions; // positions from which to generate fitting neighbours in other cells
@@ -56,7 +53,7 @@ std::vector<glm::vec2> PoissonDiskSampler::generatePoissonSample(unsigned int sa
 	grid.resize(int(ceil(1.0f/gridUnitLength)));
 	for (auto i = grid.begin(); i != grid.end(); ++i) { i->resize(int(ceil(1.0f/gridUnitLength))); }
 
-	glm::vec2 initialPosition = glm::vec2(randomFloat(), randomFloat());
+	glm::vec2 initialPosition = glm::vec2(randomFloat(gen), randomFloat(gen));
 	samplePositions.push_back(initialPosition);
 	processPositions.push_back(initialPosition);
 	grid[int(initialPosition.x / gridUnitLength)][int(initialPosition.y / gridUnitLength)] = initialPosition; // one random float position in each grid cell
@@ -64,11 +61,11 @@ std::vector<glm::vec2> PoissonDiskSampler::generatePoissonSample(unsigned int sa
 	// generate new points for each point in the queue
 	while (!processPositions.empty() && samplePositions.size() < sampleSize) {
 
-		glm::vec2 position = popRandomVectorElem<glm::vec2>(processPositions);
+		glm::vec2 position = popRandomVectorElem<glm::vec2>(processPositions, gen);
 
 		for (int i = 0; i < maxNeighboursToTry; ++i) {
 
-			glm::vec2 newPosition = generateRandomNeighbour(position, minDist);
+			glm::vec2 newPosition = generateRandomNeighbour(position, minDist, gen);
 
 			if (newPosition.x >= 0 && newPosition.x <= 1 && newPosition.y >= 0 && newPosition.y <= 1
 			    && !isInNeighbourhood(newPosition, grid, minDist, gridUnitLength)) {
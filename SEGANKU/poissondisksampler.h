@@ -36,14 +36,10 @@ class PoissonDiskSampler
 	PoissonDiskSampler();
 	~PoissonDiskSampler();
 
-	static std::random_device rd;
-	static std::mt19937 gen;
-	static std::uniform_real_distribution<float> distribution;
-
-	static float randomFloat();
+	static float randomFloat(std::mt19937 &gen);
 
 	template<typename Type>
-	static Type popRandomVectorElem(std::vector<Type> &vect)
+	static Type popRandomVectorElem(std::vector<Type> &vect, std::mt19937 &gen)
 	{
 		std::uniform_int_distribution<> indexDistribution(0, vect.size() - 1);
 		auto rand = std::bind(indexDistribution, std::ref(gen));
@@ -53,7 +49,7 @@ class PoissonDiskSampler
 		return elem;
 	}
 
-	static glm::vec2 generateRandomNeighbour(const glm::vec2 &position, float minDist);
+	static glm::vec2 generateRandomNeighbour(const glm::vec2 &position, float minDist, std::mt19937 &gen);
 
 	static bool isInNeighbourhood(const glm::vec2 &position, const std::vector<std::vector<glm::vec2> > &grid, float minDist, float gridUnitLength);
 
@@ -63,10 +59,11 @@ public:
 	 * @brief generate a sample of approximately poisson disk distributed positions
 	 * @param sampleSize the number of positions to generate
 	 * @param minDist the minimum distance between any positions (if this is too small, some areas might not get covered!)
+	 * @param gen the random generator to draw from, the same seed gives the same positions
 	 * @param maxNeighboursToTry the number of positions attempted to be found for the current grid cell until the grid cell index is rejected
 	 * @return the generated poisson disk distributed positions
 	 */
-	static std::vector<glm::vec2> generatePoissonSample(unsigned int sampleSize, float minDist, int maxNeighboursToTry = 30);
+	static std::vector<glm::vec2> generatePoissonSample(unsigned int sampleSize, float minDist, std::mt19937 &gen, int maxNeighboursToTry = 30);
 
 };
 
@@ -0,0 +1,228 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+Profiler::Scope::Scope(Profiler *profiler_, const std::string &name, bool gpu)
+	: profiler(profiler_)
+	, phase(-1)
+{
+	if (profiler) {
+		phase = profiler->beginPhase(name, gpu);
+	}
+}
+
+Profiler::Scope::~Scope()
+{
+	if (profiler) {
+		profiler->endPhase(phase);
+	}
+}
+
+Profiler::Profiler()
+{
+}
+
+Profiler::~Profiler()
+{
+	for (Phase &phase : phases) {
+		if (phase.queries[0]) {
+			glDeleteQueries(QUERY_COUNT, phase.queries);
+		}
+	}
+}
+
+void Profiler::beginFrame()
+{
+	for (Phase &phase : phases) {
+		if (phase.measuredThisFrame) {
+			phase.cpuHistory.add(phase.cpuTime);
+		}
+		phase.cpuTime = 0;
+		phase.measuredThisFrame = false;
+
+		// results of earlier frames from the oldest on, without waiting for the ones not finished yet.
+		// the gpu finishes the queries in order, so a pending one means the newer ones are pending as well
+		for (int i = 1; i <= QUERY_COUNT; ++i) {
+			if (!readQuery(phase, (frameIndex + i) % QUERY_COUNT)) {
+				break;
+			}
+		}
+	}
+
+	++frameIndex;
+}
+
+void Profiler::reset()
+{
+	for (Phase &phase : phases) {
+		phase.cpuHistory.clear();
+		phase.gpuHistory.clear();
+		std::fill(phase.queryPending, phase.queryPending + QUERY_COUNT, false);
+	}
+}
+
+int Profiler::beginPhase(const std::string &name, bool gpu)
+{
+	int index = findPhase(name);
+	Phase &phase = phases[index];
+
+	// each query can only be used once per frame
+	if (gpu && !gpuPhaseActive && phase.gpuFrame != frameIndex) {
+		if (!phase.queries[0]) {
+			glGenQueries(QUERY_COUNT, phase.queries);
+		}
+
+		// a result still pending from QUERY_COUNT frames ago is dropped instead of waited for
+		int slot = frameIndex % QUERY_COUNT;
+		phase.queryPending[slot] = false;
+
+		glBeginQuery(GL_TIME_ELAPSED, phase.queries[slot]);
+		phase.gpuActive = true;
+		phase.gpuFrame = frameIndex;
+		gpuPhaseActive = true;
+	}
+
+	phase.traced = Tracer::isRecording();
+	if (phase.traced) {
+		Tracer::begin(phase.name.c_str());
+	}
+
+	phase.cpuStart = std::chrono::steady_clock::now();
+	return index;
+}
+
+void Profiler::endPhase(int index)
+{
+	Phase &phase = phases[index];
+
+	phase.cpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - phase.cpuStart).count();
+	phase.measuredThisFrame = true;
+
+	if (phase.traced) {
+		Tracer::end();
+		phase.traced = false;
+	}
+
+	if (phase.gpuActive) {
+		glEndQuery(GL_TIME_ELAPSED);
+		phase.queryPending[frameIndex % QUERY_COUNT] = true;
+		phase.gpuActive = false;
+		gpuPhaseActive = false;
+	}
+}
+
+void Profiler::addCpuTime(const std::string &name, double milliseconds)
+{
+	Phase &phase = phases[findPhase(name)];
+	phase.cpuTime += milliseconds;
+	phase.measuredThisFrame = true;
+}
+
+int Profiler::getPhaseCount() const
+{
+	return int(phases.size());
+}
+
+const std::string &Profiler::getPhaseName(int phase) const
+{
+	return phases[phase].name;
+}
+
+Profiler::Statistics Profiler::getCpuStatistics(int phase) const
+{
+	return phases[phase].cpuHistory.calculateStatistics();
+}
+
+double Profiler::getFrameCpuTime(int phase) const
+{
+	return phases[phase].measuredThisFrame ? phases[phase].cpuTime : 0.0;
+}
+
+Profiler::Statistics Profiler::getGpuStatistics(int phase) const
+{
+	return phases[phase].gpuHistory.calculateStatistics();
+}
+
+double Profiler::getCpuTotalAverage(int phase) const
+{
+	return phases[phase].cpuHistory.calculateTotalAverage();
+}
+
+double Profiler::getGpuTotalAverage(int phase) const
+{
+	return phases[phase].gpuHistory.calculateTotalAverage();
+}
+
+int Profiler::findPhase(const std::string &name)
+{
+	auto existingPhase = phaseIndices.find(name);
+	if (existingPhase != phaseIndices.end()) {
+		return existingPhase->second;
+	}
+
+	Phase phase;
+	phase.name = name;
+	phases.push_back(phase);
+	phaseIndices[name] = int(phases.size()) - 1;
+	return int(phases.size()) - 1;
+}
+
+bool Profiler::readQuery(Phase &phase, int slot)
+{
+	if (!phase.queryPending[slot]) {
+		return true;
+	}
+
+	GLint available = 0;
+	glGetQueryObjectiv(phase.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		return false;
+	}
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(phase.queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	phase.gpuHistory.add(nanoseconds / 1.0e6);
+	phase.queryPending[slot] = false;
+	return true;
+}
+
+void Profiler::History::add(double sample)
+{
+	samples[next] = sample;
+	next = (next + 1) % HISTORY_LENGTH;
+	count = (std::min)(count + 1, int(HISTORY_LENGTH));
+	total += sample;
+	++totalCount;
+}
+
+void Profiler::History::clear()
+{
+	next = 0;
+	count = 0;
+	total = 0;
+	totalCount = 0;
+}
+
+Profiler::Statistics Profiler::History::calculateStatistics() const
+{
+	Statistics statistics;
+	if (count == 0) {
+		return statistics;
+	}
+
+	double sum = 0;
+	for (int i = 0; i < count; ++i) {
+		sum += samples[i];
+		statistics.max = (std::max)(statistics.max, samples[i]);
+	}
+
+	statistics.current = samples[(next + HISTORY_LENGTH - 1) % HISTORY_LENGTH];
+	statistics.average = sum / count;
+	statistics.sampleCount = count;
+	return statistics;
+}
+
+double Profiler::History::calculateTotalAverage() const
+{
+	return totalCount > 0 ? total / totalCount : 0.0;
+}
@@ -0,0 +1,183 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+#include "tracer.h"
+
+/**
+ * @brief The Profiler measures the phases of a frame (render passes, text, physics...)
+ * on the cpu with a clock and on the gpu with GL_TIME_ELAPSED timer queries.
+ * Every phase keeps the samples of the last frames, from which the current, average and max time are shown.
+ *
+ * The gpu result of a phase is only available some time after the commands have been issued,
+ * usually two or three frames later. Each phase therefore owns a ring of queries used in turn, one per frame,
+ * and results are read back oldest first once they are available, so measuring never stalls the pipeline.
+ * Only results still pending when their query comes round again, QUERY_COUNT frames later, are dropped.
+ * Timer queries cannot be nested, phases begun while another gpu phase is running are timed on the cpu only.
+ *
+ * Phases are recorded by the Tracer as well while it captures.
+ * The profiler must be used on the render thread only.
+ */
+class Profiler
+{
+public:
+	// the number of frames the statistics are calculated over
+	static const int HISTORY_LENGTH = 120;
+
+	// the number of timer queries per phase, more than the frames the gpu usually lags behind
+	static const int QUERY_COUNT = 4;
+
+	struct Statistics {
+		double current = 0;  // the last sample in ms
+		double average = 0;
+		double max = 0;
+		int sampleCount = 0;
+	};
+
+	/**
+	 * @brief times a phase from construction until the scope is left
+	 */
+	class Scope
+	{
+		Profiler *profiler;
+		int phase;
+
+	public:
+		/**
+		 * @param profiler_ the profiler to record to, may be nullptr to time nothing
+		 * @param name the name of the phase
+		 * @param gpu true to measure the gpu time of the phase as well
+		 */
+		Scope(Profiler *profiler_, const std::string &name, bool gpu = true);
+		~Scope();
+	};
+
+	Profiler();
+	~Profiler();
+
+	/**
+	 * @brief start a new frame, reading back the gpu times that have become available
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief forget all samples, e.g. when the measured settings change.
+	 * gpu results still pending from before are dropped, the phases are kept.
+	 */
+	void reset();
+
+	/**
+	 * @brief start timing a phase, phases of the same name are accumulated within a frame
+	 * @param name the name of the phase, shown in the overlay
+	 * @param gpu true to measure the gpu time of the phase as well
+	 * @return the index of the phase, to be passed to endPhase
+	 */
+	int beginPhase(const std::string &name, bool gpu = true);
+
+	/**
+	 * @brief stop timing a phase
+	 * @param phase the index returned by beginPhase
+	 */
+	void endPhase(int phase);
+
+	/**
+	 * @brief record a cpu time measured elsewhere, e.g. on another thread
+	 * @param name the name of the phase
+	 * @param milliseconds the measured time
+	 */
+	void addCpuTime(const std::string &name, double milliseconds);
+
+	/**
+	 * @brief get the number of phases measured so far, in order of their first appearance
+	 */
+	int getPhaseCount() const;
+
+	const std::string &getPhaseName(int phase) const;
+
+	Statistics getCpuStatistics(int phase) const;
+
+	/**
+	 * @brief get the cpu time of a phase in the current frame
+	 * @return the time in ms, 0 if the phase has not been measured in this frame
+	 */
+	double getFrameCpuTime(int phase) const;
+
+	/**
+	 * @brief the gpu statistics, without samples for cpu only phases
+	 */
+	Statistics getGpuStatistics(int phase) const;
+
+	/**
+	 * @brief get the average cpu time of a phase over all frames since the profiler was created or reset,
+	 * not only over the history
+	 */
+	double getCpuTotalAverage(int phase) const;
+
+	/**
+	 * @brief get the average gpu time of a phase over all frames since the profiler was created or reset
+	 */
+	double getGpuTotalAverage(int phase) const;
+
+private:
+
+	/**
+	 * @brief ring buffer of the last samples of a phase
+	 */
+	struct History {
+		double samples[HISTORY_LENGTH];
+		int next = 0;
+		int count = 0;
+
+		// all samples since the last clear, also the ones no longer in the ring buffer
+		double total = 0;
+		long long totalCount = 0;
+
+		void add(double sample);
+		void clear();
+		Statistics calculateStatistics() const;
+		double calculateTotalAverage() const;
+	};
+
+	struct Phase {
+		std::string name;
+		History cpuHistory;
+		History gpuHistory;
+
+		// cpu time of the current frame, added to the history when the next frame begins
+		double cpuTime = 0;
+		bool measuredThisFrame = false;
+		std::chrono::steady_clock::time_point cpuStart;
+
+		// timer queries used in turn by consecutive frames, 0 until first needed
+		GLuint queries[QUERY_COUNT] = {};
+		bool queryPending[QUERY_COUNT] = {};
+		bool gpuActive = false;
+		bool traced = false;
+		unsigned int gpuFrame = 0xFFFFFFFF;  // the frame the gpu was last measured in
+	};
+
+	std::vector<Phase> phases;
+	std::unordered_map<std::string, int> phaseIndices;
+
+	unsigned int frameIndex = 0;
+
+	// timer queries cannot be nested, only one gpu phase may be active at a time
+	bool gpuPhaseActive = false;
+
+	int findPhase(const std::string &name);
+
+	/**
+	 * @brief add the result of a pending query to the gpu history if it is available
+	 * @return false if the query is still pending
+	 */
+	bool readQuery(Phase &phase, int slot);
+};
+
+#endif // PROFILER_H
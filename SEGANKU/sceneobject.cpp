@@ -37,6 +37,41 @@ void SceneObject::setTransform(const glm::mat4 &matrix_) {
 	inverseMatrix = glm::inverse(modelMatrix);
 }
 
+void SceneObject::storePreviousMatrix()
+{
+	if (!interpolated) {
+		renderMatrix = modelMatrix;
+		interpolated = true;
+	}
+	previousMatrix = modelMatrix;
+}
+
+void SceneObject::interpolateRenderMatrix(float alpha)
+{
+	if (!interpolated) {
+		return;
+	}
+
+	glm::vec3 previousScale(glm::length(previousMatrix[0]), glm::length(previousMatrix[1]), glm::length(previousMatrix[2]));
+	glm::vec3 currentScale(glm::length(modelMatrix[0]), glm::length(modelMatrix[1]), glm::length(modelMatrix[2]));
+
+	// separate the rotation from the scale to interpolate it as quaternion
+	glm::mat3 previousRotation(previousMatrix[0].xyz() / previousScale.x, previousMatrix[1].xyz() / previousScale.y, previousMatrix[2].xyz() / previousScale.z);
+	glm::mat3 currentRotation(modelMatrix[0].xyz() / currentScale.x, modelMatrix[1].xyz() / currentScale.y, modelMatrix[2].xyz() / currentScale.z);
+	glm::mat3 rotation = glm::mat3_cast(glm::slerp(glm::quat_cast(previousRotation), glm::quat_cast(currentRotation), alpha));
+	glm::vec3 scale = glm::mix(previousScale, currentScale, alpha);
+
+	renderMatrix[0] = glm::vec4(rotation[0] * scale.x, 0);
+	renderMatrix[1] = glm::vec4(rotation[1] * scale.y, 0);
+	renderMatrix[2] = glm::vec4(rotation[2] * scale.z, 0);
+	renderMatrix[3] = glm::mix(previousMatrix[3], modelMatrix[3], alpha);
+}
+
+const glm::mat4& SceneObject::getRenderMatrix() const
+{
+	return interpolated ? renderMatrix : modelMatrix;
+}
+
 void SceneObject::applyTransformation(const glm::mat4 &transform_, const glm::mat4 &inverse_, Order multOrder)
 {
 	if (multOrder == LEFT) {
@@ -8,6 +8,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <sstream>
 
@@ -23,6 +24,11 @@ private:
 	glm::mat4 modelMatrix;
 	glm::mat4 inverseMatrix;
 
+	// model matrix before the last simulation step, and the matrix interpolated for rendering
+	glm::mat4 previousMatrix;
+	glm::mat4 renderMatrix;
+	bool interpolated = false;
+
 public:
 	SceneObject(const glm::mat4 &modelMatrix_);
 	virtual ~SceneObject();
@@ -131,6 +137,24 @@ public:
 	 */
 	void scale(const glm::vec3 &s_, Order multOrder);
 
+	/**
+	 * @brief remember the current matrix as the one before the next simulation step.
+	 * once called, the object is rendered with the matrix set by interpolateRenderMatrix.
+	 */
+	virtual void storePreviousMatrix();
+
+	/**
+	 * @brief interpolate the matrix used for rendering between the matrix before and after the last simulation step.
+	 * the translation is interpolated linearly, the rotation spherically.
+	 * @param alpha interpolation factor, 0 gives the previous and 1 the current matrix
+	 */
+	virtual void interpolateRenderMatrix(float alpha);
+
+	/**
+	 * @return the matrix to render the object with, the model matrix unless it is interpolated
+	 */
+	const glm::mat4& getRenderMatrix() const;
+
 	/**
 	 * @brief get a string to visualize the given matrix
 	 * @param matrix the matrix to get a string representation of
@@ -1,10 +1,14 @@
 #include "shader.h"
 
+int Shader::avoidedLookupCount = 0;
+
 Shader::Shader(const std::string &vertexShader, const std::string &fragmentShader)
     : vertexHandle(0)
     , fragmentHandle(0)
     , programHandle(0)
-
+    , modelMat(-1)
+    , normalMat(-1)
+    , materialDiffuse(-1)
 {
 	programHandle = glCreateProgram();
 
@@ -30,17 +34,12 @@ Shader::~Shader()
 
 void Shader::loadShader(const std::string &shader, GLenum shaderType, GLuint &handle)
 {
-	std::ifstream shaderFile(shader);
-
-	if (!shaderFile.good()) {
+	Asset shaderFile;
+	if (!AssetPack::read(shader, shaderFile)) {
 		std::cerr << "ERROR in Shader::loadShader: Could not read shader file " << shader << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
-	std::string shaderSource = std::string(std::istreambuf_iterator<char>(shaderFile),
-	                                       std::istreambuf_iterator<char>());
-	shaderFile.close();
-
 	handle = glCreateShader(shaderType);
 
 	if (handle == 0) {
@@ -48,8 +47,10 @@ void Shader::loadShader(const std::string &shader, GLenum shaderType, GLuint &ha
 		exit(EXIT_FAILURE);
 	}
 
-	const char *shaderSourcePtr = shaderSource.c_str();
-	glShaderSource(handle, 1, &shaderSourcePtr, nullptr);
+	// the source is passed with its length, since assets are not zero terminated
+	const char *shaderSourcePtr = shaderFile.getData();
+	GLint shaderSourceLength = GLint(shaderFile.getSize());
+	glShaderSource(handle, 1, &shaderSourcePtr, &shaderSourceLength);
 	glCompileShader(handle);
 
 	// print log on failure
@@ -73,7 +74,7 @@ void Shader::loadShader(const std::string &shader, GLenum shaderType, GLuint &ha
 
 void Shader::useShader() const
 {
-	glUseProgram(programHandle);
+	GLState::useProgram(programHandle);
 }
 
 void Shader::linkShaders()
@@ -97,4 +98,118 @@ void Shader::linkShaders()
 
 		exit(EXIT_FAILURE);
 	}
+
+	// bind the per frame uniform block to its fixed binding point, if the shader uses it
+	GLuint frameDataIndex = glGetUniformBlockIndex(programHandle, "FrameData");
+	if (frameDataIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(programHandle, frameDataIndex, FrameData::BINDING_POINT);
+	}
+
+	findUniformLocations();
+}
+
+void Shader::findUniformLocations()
+{
+	GLint uniformCount, maxNameLength;
+	glGetProgramiv(programHandle, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(programHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	GLchar *name = new GLchar[maxNameLength];
+
+	for (GLint i = 0; i < uniformCount; ++i) {
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(programHandle, i, maxNameLength, nullptr, &size, &type, name);
+
+		// uniforms inside uniform blocks have no location
+		GLint location = glGetUniformLocation(programHandle, name);
+		if (location == -1) {
+			continue;
+		}
+
+		std::string uniformName(name);
+		uniformLocations[uniformName] = location;
+
+		// arrays are reported as "name[0]", but should also be found as "name"
+		std::size_t bracket = uniformName.find('[');
+		if (bracket != std::string::npos) {
+			uniformLocations[uniformName.substr(0, bracket)] = location;
+		}
+	}
+
+	delete[] name;
+
+	modelMat = uniform("modelMat");
+	normalMat = uniform("normalMat");
+	materialDiffuse = uniform("material.diffuse");
+}
+
+Shader::Uniform Shader::uniform(const std::string &name)
+{
+	std::unordered_map<std::string, GLint>::const_iterator it = uniformLocations.find(name);
+	if (it == uniformLocations.end()) {
+		return Uniform(-1);
+	}
+
+	return Uniform(it->second);
+}
+
+Shader::Uniform::Uniform(GLint location_)
+    : location(location_)
+{
+}
+
+GLint Shader::Uniform::getLocation() const
+{
+	return location;
+}
+
+void Shader::Uniform::countAvoidedLookup() const
+{
+	// without the cached location every set on an active uniform would need a glGetUniformLocation call first
+	if (location != -1) {
+		avoidedLookupCount += 1;
+	}
+}
+
+void Shader::Uniform::set(GLint value) const
+{
+	countAvoidedLookup();
+	glUniform1i(location, value);
+}
+
+void Shader::Uniform::set(GLuint value) const
+{
+	countAvoidedLookup();
+	glUniform1i(location, value);
+}
+
+void Shader::Uniform::set(bool value) const
+{
+	countAvoidedLookup();
+	glUniform1i(location, value);
+}
+
+void Shader::Uniform::set(GLfloat value) const
+{
+	countAvoidedLookup();
+	glUniform1f(location, value);
+}
+
+void Shader::Uniform::set(const glm::vec3 &value) const
+{
+	countAvoidedLookup();
+	glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::Uniform::set(const glm::mat3 &value) const
+{
+	countAvoidedLookup();
+	glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value)); // location, count, transpose?, value pointer
+}
+
+void Shader::Uniform::set(const glm::mat4 &value) const
+{
+	countAvoidedLookup();
+	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
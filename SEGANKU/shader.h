@@ -4,14 +4,26 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
+
+#include "glstate.h"
+#include "assetpack.h"
+#include "framedata.h"
 
 /**
  * @brief Shader class.
  * This loads and compiles glsl shader files and creates a linked shader program.
  * The program can later be activated when needed.
+ * All active uniform locations are queried once after linking,
+ * so that drawing code does not need to call glGetUniformLocation every frame.
+ * The uniforms set for every drawn object are additionally resolved into members, so drawing does not look up names at all.
  */
 class Shader
 {
@@ -19,9 +31,12 @@ class Shader
 	GLuint vertexHandle;
 	GLuint fragmentHandle;
 
+	// locations of all active uniforms of the linked program, by uniform name
+	std::unordered_map<std::string, GLint> uniformLocations;
+
 	/**
 	 * @brief load and compile glsl shader
-	 * @param shader the glsl shader source file
+	 * @param shader the glsl shader source file, read from the asset pack if it is packed
 	 * @param shaderType the type of the shader
 	 * @param handle the id by which the shader is retrieved within the gl context
 	 */
@@ -32,6 +47,12 @@ class Shader
 	 */
 	void linkShaders();
 
+	/**
+	 * @brief query the locations of all active uniforms of the linked program
+	 * and store them in the uniformLocations map
+	 */
+	void findUniformLocations();
+
 public:
 	Shader(const std::string& vertexShader, const std::string& fragmentShader);
 	~Shader();
@@ -44,6 +65,50 @@ public:
 	 */
 	void useShader() const;
 
+	/**
+	 * @brief A Uniform is a pre-resolved handle to a uniform location in a shader program.
+	 * The setters only work if the owning shader program is the active one.
+	 * Setting a uniform not active in the program (location -1) is silently ignored, as in opengl.
+	 */
+	class Uniform
+	{
+		GLint location;
+
+		/**
+		 * @brief count the glGetUniformLocation call this set does not need, see avoidedLookupCount
+		 */
+		void countAvoidedLookup() const;
+
+	public:
+		Uniform(GLint location_);
+
+		GLint getLocation() const;
+
+		void set(GLint value) const;
+		void set(GLuint value) const;
+		void set(bool value) const;
+		void set(GLfloat value) const;
+		void set(const glm::vec3 &value) const;
+		void set(const glm::mat3 &value) const;
+		void set(const glm::mat4 &value) const;
+	};
+
+	/**
+	 * @brief get the handle to the uniform of given name, as found after linking.
+	 * this does not query the gl driver.
+	 * @param name the name of the uniform in the glsl source, e.g. "light.position"
+	 * @return the uniform handle (with location -1 if not an active uniform)
+	 */
+	Uniform uniform(const std::string &name);
+
+	// the uniforms set for every drawn geometry and surface, resolved after linking (location -1 if not active)
+	Uniform modelMat;
+	Uniform normalMat;
+	Uniform materialDiffuse;
+
+	// the number of glGetUniformLocation calls replaced by cached locations, one per set on an active uniform
+	static int avoidedLookupCount;
+
 };
 
 #endif // SHADER_H
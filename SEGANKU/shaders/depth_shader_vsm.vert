@@ -2,13 +2,35 @@
 
 layout(location = 0) in vec3 position;
 
+// per instance attributes, only used for instanced drawing (see InstancedGeometry class)
+layout(location = 3) in mat4 instanceModelMat; // occupies locations 3 to 6
+
 out vec4 pos;
 
-uniform mat4 lightVP;
 uniform mat4 modelMat;
+uniform bool instanced; // use the per instance model matrix instead of modelMat
+
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
 void main()
 {
-    gl_Position = lightVP * modelMat * vec4(position, 1.0f);
+    gl_Position = lightVP * (instanced ? instanceModelMat : modelMat) * vec4(position, 1.0f);
 	pos = gl_Position;
 }
@@ -8,15 +8,29 @@ in vec3 P; // world space position
 in vec2 texCoord; // interpolated texture coordinates
 in mat3 TBN; // the tangent space of the given vertex (tangent, bitangent, normal)
 
-uniform vec3 cameraPos;
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
 uniform sampler2D diffuseTexture;
 uniform sampler2D specularTexture;
 uniform sampler2D normalTexture;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-
 const float ambientFactor = 0.2f;
 
 // TODO: these should be made uniforms and defined by object materials
@@ -25,19 +39,19 @@ const float shininess = 16.0f;
 void main()
 {
 	vec3 N = normalize(TBN * (texture(normalTexture, texCoord).rgb * 2 - 1));
-	vec3 L = normalize(lightPos - P); // light vector (point to light)
+	vec3 L = normalize(light.position - P); // light vector (point to light)
 	vec3 V = normalize(cameraPos - P);
 
 	vec3 diffuseColor = texture(diffuseTexture, texCoord).rgb;
 	vec3 specularColor = vec3(1.0f); //texture(specularTexture, texCoord).rgb;
 
-	vec3 ambient = ambientFactor * lightColor * diffuseColor;
-	vec3 diffuse = max(dot(N, L), 0.0f) * lightColor * diffuseColor;
+	vec3 ambient = ambientFactor * light.diffuse * diffuseColor;
+	vec3 diffuse = max(dot(N, L), 0.0f) * light.diffuse * diffuseColor;
 
 	vec3 H = normalize(L + V); // half vector of light and view vectors
 
 	// note that N is the half vector of light vector and its specular reflection
-	vec3 specular = pow(max(dot(H, N), 0.0f), shininess) * lightColor * diffuseColor;
+	vec3 specular = pow(max(dot(H, N), 0.0f), shininess) * light.diffuse * diffuseColor;
 
 	outColor = vec4(ambient + diffuse + specular, 1);
 }
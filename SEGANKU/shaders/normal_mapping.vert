@@ -13,7 +13,25 @@ out mat3 TBN; // the tangent space of the given vertex (tangent, bitangent, norm
 // uniforms use the same value for all vertices
 uniform mat4 modelMat;
 uniform mat3 normalMat;
-uniform mat4 viewProjMat;
+
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
 mat3 approximateTangentSpace(vec3 normal);
 
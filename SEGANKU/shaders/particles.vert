@@ -7,12 +7,30 @@ out vec2 texCoord;
 out float timeToLive;
 
 // uniforms use the same value for all vertices
-uniform mat4 modelViewMat;
-uniform mat4 projMat;
+uniform mat4 modelMat;
+
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
 void main()
 {
-    gl_Position = projMat * (modelViewMat * vec4(particleData.xyz, 1) + vec4(particleQuadVertex.xy*2, 0, 1)); // particles face camera
+    gl_Position = projMat * (viewMat * modelMat * vec4(particleData.xyz, 1) + vec4(particleQuadVertex.xy*2, 0, 1)); // particles face camera
 	texCoord = particleQuadVertex.zw;
 	timeToLive = particleData.w;
 }
@@ -6,7 +6,6 @@ layout(location = 0) out vec4 outColor;
 const float SAMPLE_RADIUS = 2.5f; // reference uses 1.5 [causes issues, currently not used]
 
 uniform sampler2D viewPosTexture; // interpolated vertex positions in view space
-uniform mat4 projMat;
 uniform int random_vector_array_size; // reference uses 64 [increase for higher quality]
 
 // we use a uniform buffer object for better performance
@@ -15,6 +14,25 @@ layout (std140) uniform RandomVectors
     vec3 randomVectors[128]; // array size must be static, so we just allocate as much as we might need
 };
 
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
+
 void main()
 {
 
@@ -9,6 +9,12 @@ struct Material {
 	float shininess;
 };
 
+in vec3 P;
+in vec3 N;
+in vec2 texCoord;
+in vec4 PLightSpace;
+in vec4 PViewSpace;
+
 struct Light {
 	vec3 position;
 	vec3 ambient;
@@ -16,15 +22,19 @@ struct Light {
 	vec3 specular;
 };
 
-in vec3 P;
-in vec3 N;
-in vec2 texCoord;
-in vec4 PLightSpace;
-in vec4 PViewSpace;
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
-uniform vec3 cameraPos;
 uniform Material material;
-uniform Light light;
 
 uniform sampler2D shadowMap; // texture unit 1
 uniform sampler2D ssaoTexture; // texture unit 2
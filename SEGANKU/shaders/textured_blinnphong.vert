@@ -4,6 +4,10 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uv;
 
+// per instance attributes, only used for instanced drawing (see InstancedGeometry class)
+layout(location = 3) in mat4 instanceModelMat;  // occupies locations 3 to 6
+layout(location = 7) in mat3 instanceNormalMat; // occupies locations 7 to 9
+
 // these will be interpolated by the gpu
 // the interpolated values can be accessed by same name in fragment shader
 out vec3 P;
@@ -15,16 +19,36 @@ out vec4 PViewSpace;
 // uniforms use the same value for all vertices
 uniform mat4 modelMat;
 uniform mat3 normalMat;
-uniform mat4 viewProjMat;
-uniform mat4 viewMat;
-uniform mat4 lightVP;
+uniform bool instanced; // use the per instance matrices instead of modelMat and normalMat
+
+struct Light {
+	vec3 position;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// per frame data shared by all shaders, filled once per frame (see FrameData class)
+// the layout must match on all shader stages and the FrameData::Block struct
+layout (std140) uniform FrameData
+{
+	mat4 viewProjMat;
+	mat4 viewMat;
+	mat4 projMat;
+	mat4 lightVP;
+	vec3 cameraPos;
+	Light light;
+};
 
 void main()
 {
-	gl_Position = viewProjMat * modelMat * vec4(position, 1);
+	mat4 M = instanced ? instanceModelMat : modelMat;
+	mat3 NM = instanced ? instanceNormalMat : normalMat;
+
+	gl_Position = viewProjMat * M * vec4(position, 1);
 
-	P = (modelMat * vec4(position, 1)).xyz;
-	N = normalMat * normal;
+	P = (M * vec4(position, 1)).xyz;
+	N = NM * normal;
 	texCoord = uv;
 
 	PLightSpace = lightVP * vec4(P, 1.0);
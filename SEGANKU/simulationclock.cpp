@@ -0,0 +1,34 @@
+#include "simulationclock.h"
+
+SimulationClock::SimulationClock(double stepSize_, int maxSteps_)
+	: stepSize(stepSize_)
+	, maxSteps(maxSteps_)
+{
+}
+
+int SimulationClock::advance(double frameTime)
+{
+	accumulator += frameTime;
+
+	int steps = int(accumulator / stepSize);
+	if (steps > maxSteps) {
+		// drop the time we cannot catch up with
+		steps = maxSteps;
+		accumulator = 0;
+	}
+	else {
+		accumulator -= steps * stepSize;
+	}
+
+	return steps;
+}
+
+double SimulationClock::getStepSize() const
+{
+	return stepSize;
+}
+
+float SimulationClock::getInterpolationAlpha() const
+{
+	return float(accumulator / stepSize);
+}
@@ -0,0 +1,43 @@
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+
+/**
+ * @brief A SimulationClock lets the simulation advance in steps of fixed size, independent of the frame rate.
+ * The passed frame time is accumulated and consumed in whole steps, the remainder is carried over
+ * to the next frame and used to interpolate the rendered transforms between the last two steps.
+ * To avoid a spiral of ever longer frames, at most maxSteps steps are taken per frame and
+ * the time beyond that is dropped, i.e. the simulation slows down instead.
+ */
+class SimulationClock
+{
+	double stepSize;
+	int maxSteps;
+	double accumulator = 0;
+
+public:
+	/**
+	 * @param stepSize_ simulated time per step in seconds
+	 * @param maxSteps_ maximum number of steps per frame
+	 */
+	SimulationClock(double stepSize_, int maxSteps_);
+
+	/**
+	 * @brief add the time passed since the last frame
+	 * @param frameTime the time passed since the last frame in seconds
+	 * @return the number of steps to simulate this frame
+	 */
+	int advance(double frameTime);
+
+	/**
+	 * @return simulated time per step in seconds
+	 */
+	double getStepSize() const;
+
+	/**
+	 * @brief get how far the accumulated time is between the last and the next step
+	 * @return the interpolation factor in [0, 1)
+	 */
+	float getInterpolationAlpha() const;
+};
+
+#endif // SIMULATIONCLOCK_H
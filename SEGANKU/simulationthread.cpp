@@ -0,0 +1,146 @@
+#include "simulationthread.h"
+#include "tracer.h"
+
+#include <iostream>
+#include <chrono>
+
+SimulationThread::SimulationThread(GameWorld *world_, QueuedInputSource *input_, const std::vector<std::shared_ptr<InstancedGeometry>> &carrotGroups_)
+	: world(world_)
+	, input(input_)
+	, carrotGroups(carrotGroups_)
+	, running(false)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+	world = nullptr;
+	input = nullptr;
+}
+
+void SimulationThread::start()
+{
+	if (running) {
+		return;
+	}
+
+	// the render thread has a valid snapshot from the first frame on
+	publishSnapshot();
+
+	running = true;
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::publishSnapshot()
+{
+	world->interpolateRenderState();
+	writeSnapshot(snapshots.getWriteBuffer(), 0);
+	snapshots.publish();
+}
+
+void SimulationThread::stop()
+{
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+bool SimulationThread::acquireSnapshot()
+{
+	return snapshots.acquire();
+}
+
+const SceneSnapshot &SimulationThread::getSnapshot() const
+{
+	return snapshots.getReadBuffer();
+}
+
+void SimulationThread::run()
+{
+	Tracer::setThreadName("simulation");
+
+	std::chrono::steady_clock::time_point lastTime = std::chrono::steady_clock::now();
+
+	while (running) {
+		Tracer::Scope scope("simulation frame");
+
+		std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+		double frameTime = std::chrono::duration<double>(time - lastTime).count();
+		lastTime = time;
+
+		pressedKeys.clear();
+		input->processEvents(pressedKeys);
+		for (int key : pressedKeys) {
+			handleKeyPress(key);
+		}
+
+		int steps = world->advance(frameTime);
+		world->interpolateRenderState();
+
+		double simulationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time).count();
+		writeSnapshot(snapshots.getWriteBuffer(), simulationTime);
+		snapshots.publish();
+
+		// between steps only the interpolation changes, so give the cpu to the render thread for a moment
+		// instead of spinning. the snapshots are still published often enough to interpolate smoothly.
+		if (steps == 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void SimulationThread::handleKeyPress(int key)
+{
+	switch (key) {
+	case GLFW_KEY_TAB:
+		world->getPlayer()->toggleNavMode();
+		break;
+	case GLFW_KEY_BACKSPACE:
+		world->reset();
+		std::cout << "GAME RESTARTED" << std::endl;
+		break;
+	case GLFW_KEY_F:
+		if (world->activateDefense()) {
+			std::cout << "PARTICLE SYSTEM RESPAWNED" << std::endl;
+		}
+		break;
+	}
+}
+
+void SimulationThread::writeSnapshot(SceneSnapshot &snapshot, double simulationFrameTime)
+{
+	Player *player = world->getPlayer();
+	Eagle *eagle = world->getEagle();
+	Light *sun = world->getSun();
+	ParticleSystem *particleSystem = world->getParticleSystem();
+
+	snapshot.viewMat = player->getRenderViewMat();
+	snapshot.projMat = player->getProjMat();
+	snapshot.cameraLocation = glm::vec3(world->getCamera()->getRenderMatrix()[3]);
+
+	snapshot.lightLocation = sun->getLocation();
+	snapshot.lightColor = sun->getColor();
+
+	snapshot.playerMatrix = player->getRenderMatrix();
+	snapshot.eagleMatrix = eagle->getRenderMatrix();
+	snapshot.carrotMatrices.clear();
+	for (const std::shared_ptr<InstancedGeometry> &group : carrotGroups) {
+		group->captureModelMatrices(snapshot.carrotMatrices);
+	}
+	snapshot.particleMatrix = particleSystem->getMatrix();
+	snapshot.particleInstanceData = particleSystem->getInstanceData();
+
+	snapshot.outcome = world->getOutcome();
+	snapshot.timeUntilStarvation = world->getTimeUntilStarvation();
+	snapshot.foodCount = player->getFoodCount();
+	snapshot.neededFood = player->getNeededFood();
+	snapshot.eating = player->isEating();
+	snapshot.foodReaction = snapshot.eating ? player->getFoodReaction() : std::string();
+	snapshot.playerHidden = player->isInBush();
+	snapshot.eagleState = eagle->getState();
+	snapshot.physicsStepTime = world->getPhysics()->getLastStepTime();
+	snapshot.physicsThreadCount = world->getPhysics()->getThreadCount();
+	snapshot.simulationFrameTime = simulationFrameTime;
+}
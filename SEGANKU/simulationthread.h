@@ -0,0 +1,129 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+#include "gameworld.h"
+#include "inputsource.h"
+#include "instancedgeometry.h"
+#include "triplebuffer.h"
+
+/**
+ * @brief The SceneSnapshot holds everything the render thread needs from the simulation for one frame:
+ * the interpolated transforms of the moving objects, the light, the particles and the values shown in the hud.
+ * Objects not contained here (terrain, cave, trees, shrubs) are never changed after the world has been created.
+ */
+struct SceneSnapshot {
+	// camera
+	glm::mat4 viewMat;
+	glm::mat4 projMat;
+	glm::vec3 cameraLocation;
+
+	// light
+	glm::vec3 lightLocation;
+	glm::vec3 lightColor;
+
+	// moving objects
+	glm::mat4 playerMatrix;
+	glm::mat4 eagleMatrix;
+	std::vector<glm::mat4> carrotMatrices;  // model matrices of the carrot instance groups, one after another
+	glm::mat4 particleMatrix;
+	std::vector<float> particleInstanceData;
+
+	// hud
+	GameWorld::Outcome outcome = GameWorld::RUNNING;
+	double timeUntilStarvation = 0;
+	int foodCount = 0;
+	int neededFood = 0;
+	bool eating = false;
+	std::string foodReaction;
+	bool playerHidden = false;
+	EagleState eagleState = CIRCLING;
+	double physicsStepTime = 0;
+	int physicsThreadCount = 1;
+	double simulationFrameTime = 0;         // wall time of the last simulation frame in ms
+};
+
+
+/**
+ * @brief The SimulationThread advances the game world on its own thread, so simulating the next frame
+ * overlaps with rendering the current one.
+ * Input reaches the simulation through the lock-free queue of a QueuedInputSource. After every simulation
+ * frame the interpolated state is written to a SceneSnapshot and published through a triple buffer,
+ * from which the render thread acquires the latest snapshot. Neither thread ever waits for the other,
+ * and the render thread must not touch the world while the simulation thread is running.
+ */
+class SimulationThread
+{
+public:
+	/**
+	 * @param world_ the world to simulate
+	 * @param input_ the input source of the player in the world
+	 * @param carrotGroups_ the instance groups drawing the carrots, their model matrices are captured in the snapshots
+	 */
+	SimulationThread(GameWorld *world_, QueuedInputSource *input_, const std::vector<std::shared_ptr<InstancedGeometry>> &carrotGroups_);
+	~SimulationThread();
+
+	/**
+	 * @brief publish a first snapshot and start simulating
+	 */
+	void start();
+
+	/**
+	 * @brief publish a snapshot of the current state without simulating, e.g. to render a world that stands still.
+	 * must not be called while the thread is running.
+	 */
+	void publishSnapshot();
+
+	/**
+	 * @brief stop simulating and wait for the thread to finish, after this the world may be used again
+	 */
+	void stop();
+
+	/**
+	 * @brief take the latest snapshot published by the simulation, for the render thread only
+	 * @return true if a new snapshot has been acquired
+	 */
+	bool acquireSnapshot();
+
+	/**
+	 * @brief get the last acquired snapshot, for the render thread only
+	 */
+	const SceneSnapshot &getSnapshot() const;
+
+private:
+	GameWorld *world;
+	QueuedInputSource *input;
+	std::vector<std::shared_ptr<InstancedGeometry>> carrotGroups;
+
+	TripleBuffer<SceneSnapshot> snapshots;
+	std::thread thread;
+	std::atomic<bool> running;
+
+	std::vector<int> pressedKeys;   // reused to collect the keys pressed since the last frame
+
+	/**
+	 * @brief the simulation loop, runs until stop is called
+	 */
+	void run();
+
+	/**
+	 * @brief trigger the game action bound to a key
+	 * @param key the glfw key code of the pressed key
+	 */
+	void handleKeyPress(int key);
+
+	/**
+	 * @brief copy the state needed for rendering from the world into the snapshot
+	 */
+	void writeSnapshot(SceneSnapshot &snapshot, double simulationFrameTime);
+};
+
+#endif // SIMULATIONTHREAD_H
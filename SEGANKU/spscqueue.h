@@ -0,0 +1,56 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief A lock-free single producer single consumer queue of fixed capacity.
+ * One thread may push while another thread pops, without locking.
+ * The ring buffer holds Capacity - 1 elements, one slot is kept free to tell a full from an empty queue.
+ */
+template<typename Type, size_t Capacity>
+class SpscQueue
+{
+	Type elements[Capacity];
+	std::atomic<size_t> head; // next element to pop, only written by the consumer
+	std::atomic<size_t> tail; // next free slot, only written by the producer
+
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	/**
+	 * @brief append an element, to be called by the producer thread only
+	 * @param element the element to append
+	 * @return false if the queue is full and the element was dropped
+	 */
+	bool push(const Type &element)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		size_t nextTail = (currentTail + 1) % Capacity;
+		if (nextTail == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		elements[currentTail] = element;
+		tail.store(nextTail, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief take the oldest element, to be called by the consumer thread only
+	 * @param element is set to the oldest element
+	 * @return false if the queue is empty
+	 */
+	bool pop(Type &element)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		element = elements[currentHead];
+		head.store((currentHead + 1) % Capacity, std::memory_order_release);
+		return true;
+	}
+};
+
+#endif // SPSCQUEUE_H
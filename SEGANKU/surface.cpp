@@ -7,26 +7,62 @@ Surface::Surface(const std::vector<Vertex> &vertices_, const std::vector<GLuint>
 	, texSpecular(texSpecular_)
 	, texNormal(texNormal_)
 {
-	calculateBoundingSphere();
-	initBuffers();
+	calculateBoundingSphere(vertices.data(), vertices.size(), boundingSphereCenter, boundingSphereFarthestPoint);
+
+	// without an opengl context only the mesh data is kept, e.g. for the terrain height field and physics
+	if (GLState::contextAvailable) {
+		initBuffers(vertices.data(), indices.data());
+	}
 }
 
-void Surface::initBuffers()
+Surface::Surface(const Vertex *vertexData, size_t vertexCount, const GLuint *indexData, size_t indexCount, const glm::vec3 &boundingSphereCenter_, const glm::vec3 &boundingSphereFarthestPoint_,
+                 const std::shared_ptr<Texture> &texDiffuse_, const std::shared_ptr<Texture> &texSpecular_, const std::shared_ptr<Texture> &texNormal_)
+	: vertices(vertexData, vertexData + vertexCount)
+	, indices(indexData, indexData + indexCount)
+	, boundingSphereCenter(boundingSphereCenter_)
+	, boundingSphereFarthestPoint(boundingSphereFarthestPoint_)
+	, texDiffuse(texDiffuse_)
+	, texSpecular(texSpecular_)
+	, texNormal(texNormal_)
+{
+	if (GLState::contextAvailable) {
+		initBuffers(vertexData, indexData);
+	}
+}
+
+void Surface::initBuffers(const Vertex *vertexData, const GLuint *indexData)
 {
 	// generate vertex array object (vao) bindings. the vao simply stores the state of the subsequent bindings
 	// so that they can be reactived quickly later, instead of doing it all over again
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	GLState::bindVertexArray(vao);
 
 	// copy vertex data to GL_ARRAY_BUFFER in vram.
 	glGenBuffers(1, &vertexBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer); // bind to active context
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW); // copy data
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertexData, GL_STATIC_DRAW); // copy data
 
 	// copy indices to GL_ELEMENT_ARRAY_BUFFER in vram. these define the mesh structure.
 	glGenBuffers(1, &indexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indexData, GL_STATIC_DRAW);
+
+	setupVertexAttributes();
+
+	// unbind vao. the state of bindings until here are stored in vao.
+	GLState::bindVertexArray(0);
+
+	// unbind buffers
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+}
+
+void Surface::setupVertexAttributes() const
+{
+	// bind the buffers of this surface to the currently bound vao
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
 
 	// enable shader attributes at given indices to supply vertex data to them
 	// the indices/layout of the shader attribute are defined in the shader source file
@@ -44,84 +80,92 @@ void Surface::initBuffers()
 	glVertexAttribPointer(positionAttribIndex, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
 	glVertexAttribPointer(normalAttribIndex, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, normal));
 	glVertexAttribPointer(uvAttribIndex, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, uv));
-
-	// unbind vao. the state of bindings until here are stored in vao.
-	glBindVertexArray(0);
-
-	// unbind buffers
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
 }
 
-void Surface::calculateBoundingSphere()
+void Surface::calculateBoundingSphere(const Vertex *vertexData, size_t vertexCount, glm::vec3 &center, glm::vec3 &farthestPoint)
 {
 	// approximate bounding sphere center using arithmetic mean
 	glm::vec3 arithmeticMeanPosition;
-	for (Vertex v : vertices) {
-		arithmeticMeanPosition += v.position;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		arithmeticMeanPosition += vertexData[i].position;
 	}
-	arithmeticMeanPosition /= vertices.size();
+	arithmeticMeanPosition /= vertexCount;
 
-	boundingSphereCenter = arithmeticMeanPosition;
+	center = arithmeticMeanPosition;
 
 	// determine bounding sphere radius as distance to farthest vertex from center
 	float maxRadius = 0;
-	for (Vertex v : vertices) {
-		float currentRadius = glm::length(v.position - boundingSphereCenter);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		float currentRadius = glm::length(vertexData[i].position - center);
 		if (currentRadius > maxRadius) {
-			boundingSphereFarthestPoint = v.position;
+			farthestPoint = vertexData[i].position;
 		}
 	}
 }
 
-glm::vec3 Surface::getBoundingSphereCenter()
+glm::vec3 Surface::getBoundingSphereCenter() const
 {
 	return boundingSphereCenter;
 }
 
-glm::vec3 Surface::getBoundingSphereFarthestPoint()
+glm::vec3 Surface::getBoundingSphereFarthestPoint() const
 {
 	return boundingSphereFarthestPoint;
 }
 
 Surface::~Surface()
 {
+	if (vao == 0) {
+		return; // buffers were never created
+	}
+
 	// delete buffers (free vram)
 	glDeleteBuffers(1, &vertexBuffer);
 	glDeleteBuffers(1, &indexBuffer);
 
 	glDeleteVertexArrays(1, &vao);
+	GLState::invalidate();
 }
 
-void Surface::draw(Shader *shader, Texture::FilterType filterType)
+void Surface::draw(Shader *shader) const
+{
+	bindTextures(shader);
+
+	// draw triangles from given indices
+	// the vao is left bound, so consecutive draws of the same surface skip the rebind
+	GLState::bindVertexArray(vao); // bind the vertex array used to supply vertices
+	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0); // use given indices
+}
+
+void Surface::drawInstanced(Shader *shader, GLuint instancedVAO, GLsizei instanceCount) const
+{
+	bindTextures(shader);
+
+	// draw all instances at once. the vao supplies the vertex data of this surface
+	// and the per instance attributes, which advance once per instance (glVertexAttribDivisor)
+	GLState::bindVertexArray(instancedVAO);
+	glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, instanceCount);
+}
+
+void Surface::bindTextures(Shader *shader) const
 {
 	// pass textures to shader
 	// for now just uses the diffuse texture
 
 	if (texDiffuse) {
-		GLint diffuseTexLocation = glGetUniformLocation(shader->programHandle, "material.diffuse"); // get uniform location in shader
-		glUniform1i(diffuseTexLocation, 0); // bind shader texture location with texture unit 0
-		texDiffuse->bind(0); // activate texture unit 0 and bind texture to it
-		texDiffuse->setFilterMode(filterType);
+		shader->materialDiffuse.set(0); // bind shader texture location with texture unit 0
+		texDiffuse->bind(0); // activate texture unit 0 and bind texture to it (filtered by the sampler of unit 0)
 	}
 	/*
 	if (texSpecular) {
-		GLint specularTexLocation = glGetUniformLocation(shader->programHandle, "material.specular");
-		glUniform1i(specularTexLocation, 1);
+		shader->uniform("material.specular").set(1);
 		texSpecular->bind(1);
 	}
 	if (texNormal) {
-		GLint normalsTexLocation = glGetUniformLocation(shader->programHandle, "normalTexture");
-		glUniform1i(normalsTexLocation, 2);
+		shader->uniform("normalTexture").set(2);
 		texNormal->bind(2);
 	}*/
 
-	// draw triangles from given indices
-	glBindVertexArray(vao); // bind the vertex array used to supply vertices
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0); // use given indices
-	glBindVertexArray(0);
-
 	// DEBUG PRINT VERTICES
 	//std::cout << vertices.size() << std::endl;
 	/*//
@@ -135,12 +179,12 @@ void Surface::draw(Shader *shader, Texture::FilterType filterType)
 
 }
 
-std::vector<Vertex> Surface::getVertices()
+const std::vector<Vertex> &Surface::getVertices() const
 {
 	return vertices;
 }
 
-std::vector<GLuint> Surface::getIndices()
+const std::vector<GLuint> &Surface::getIndices() const
 {
 	return indices;
 }
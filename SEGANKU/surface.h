@@ -10,6 +10,7 @@
 
 #include "shader.h"
 #include "texture.h"
+#include "glstate.h"
 
 /**
  * @brief Vertex struct for internal representation
@@ -41,36 +42,74 @@ class Surface
 
 	// handle for vertex array object (vao). the vao simply stores the bindings set when its active
 	// so that they can be reactived quickly later, instead of setting it up all over again.
-	GLuint vao;
+	GLuint vao = 0;
 
 	// handles for vram buffers.
-	GLuint vertexBuffer, indexBuffer;
+	GLuint vertexBuffer = 0, indexBuffer = 0;
 
 	/**
 	 * @brief initialize vba, copy vertex data to vram buffers and associate with shader attributes
+	 * @param vertexData the vertices to upload, e.g. the own ones or the ones of a mapped baked model
+	 * @param indexData the indices to upload
 	 */
-	void initBuffers();
+	void initBuffers(const Vertex *vertexData, const GLuint *indexData);
+
+	/**
+	 * @brief pass the textures of this surface to the shader and bind them to their texture units
+	 * @param shader the shader program used for drawing
+	 */
+	void bindTextures(Shader *shader) const;
 
 public:
 	Surface(const std::vector<Vertex> &vertices_, const std::vector<GLuint> &indices_, const std::shared_ptr<Texture> &texDiffuse_, const std::shared_ptr<Texture> &texSpecular_, const std::shared_ptr<Texture> &texNormal_);
+
+	/**
+	 * @brief create a surface from mesh data with a known bounding sphere, e.g. from a baked model.
+	 * the buffers are uploaded directly from the given data, which is copied once for the cpu side.
+	 * @param vertexData the vertices
+	 * @param vertexCount the number of vertices
+	 * @param indexData the indices
+	 * @param indexCount the number of indices
+	 * @param boundingSphereCenter_ the bounding sphere center, see calculateBoundingSphere
+	 * @param boundingSphereFarthestPoint_ the farthest point of the bounding sphere
+	 */
+	Surface(const Vertex *vertexData, size_t vertexCount, const GLuint *indexData, size_t indexCount, const glm::vec3 &boundingSphereCenter_, const glm::vec3 &boundingSphereFarthestPoint_,
+	        const std::shared_ptr<Texture> &texDiffuse_, const std::shared_ptr<Texture> &texSpecular_, const std::shared_ptr<Texture> &texNormal_);
 	~Surface();
 
-	std::vector<Vertex> getVertices();
-	std::vector<GLuint> getIndices();
+	const std::vector<Vertex> &getVertices() const;
+	const std::vector<GLuint> &getIndices() const;
 
 	/**
 	 * @brief draw triangles from vertex data from buffers bound as specified by the vba.
 	 * note: the transformation matrices must be set already in shader program!
+	 * the diffuse texture is bound to texture unit 0, filtering is defined by the sampler bound to that unit.
 	 * @param shader the compiled shader program to use for drawing
 	 */
-	void draw(Shader *shader, Texture::FilterType filterType);
+	void draw(Shader *shader) const;
+
+	/**
+	 * @brief draw multiple instances of this surface with a single draw call.
+	 * note: the shader must read the model and normal matrices from the per instance attributes.
+	 * @param shader the compiled shader program to use for drawing
+	 * @param instancedVAO a vao set up with setupVertexAttributes() and per instance attributes
+	 * @param instanceCount the number of instances to draw
+	 */
+	void drawInstanced(Shader *shader, GLuint instancedVAO, GLsizei instanceCount) const;
+
+	/**
+	 * @brief bind the vertex and index buffers of this surface to the currently bound vao
+	 * and set up the vertex attributes (position, normal, uv at locations 0, 1, 2).
+	 * used to share the vram buffers with other vaos, e.g. for instancing.
+	 */
+	void setupVertexAttributes() const;
 
 	/**
 	 * @brief get the center of the bounding sphere
 	 * for this surface to be used in view frustum culling
 	 * @return the bounding sphere center
 	 */
-	glm::vec3 getBoundingSphereCenter();
+	glm::vec3 getBoundingSphereCenter() const;
 
 	/**
 	 * @brief get the farthest point on the bounding sphere
@@ -78,15 +117,17 @@ public:
 	 * used for view frustum culling
 	 * @return the farthest point on the bounding sphere
 	 */
-	glm::vec3 getBoundingSphereFarthestPoint();
-
-private:
+	glm::vec3 getBoundingSphereFarthestPoint() const;
 
 	/**
 	 * @brief calculate parameters defining a bounding sphere
-	 * for this surface to be used in view frustum culling
+	 * for a surface to be used in view frustum culling
+	 * @param vertexData the vertices of the surface
+	 * @param vertexCount the number of vertices
+	 * @param center is set to the center of the bounding sphere
+	 * @param farthestPoint is set to the farthest point on the bounding sphere
 	 */
-	void calculateBoundingSphere();
+	static void calculateBoundingSphere(const Vertex *vertexData, size_t vertexCount, glm::vec3 &center, glm::vec3 &farthestPoint);
 
 };
 
@@ -0,0 +1,138 @@
+#include "terrainheightfield.h"
+
+TerrainHeightField::TerrainHeightField(const Surface *surface, const glm::mat4 &modelMat, float cellSize_)
+	: cellSize(cellSize_)
+{
+	const std::vector<Vertex> &vertices = surface->getVertices();
+	const std::vector<GLuint> &indices = surface->getIndices();
+
+	// transform vertices to world space and find the bounds in the xz plane
+	std::vector<glm::vec3> positions(vertices.size());
+	boundsMin = glm::vec2(std::numeric_limits<float>::max());
+	boundsMax = glm::vec2(-std::numeric_limits<float>::max());
+
+	for (GLuint i = 0; i < vertices.size(); ++i) {
+		positions[i] = glm::vec3(modelMat * glm::vec4(vertices[i].position, 1));
+		boundsMin = glm::min(boundsMin, glm::vec2(positions[i].x, positions[i].z));
+		boundsMax = glm::max(boundsMax, glm::vec2(positions[i].x, positions[i].z));
+	}
+
+	if (positions.empty()) {
+		boundsMin = boundsMax = glm::vec2(0);
+	}
+
+	sampleCountX = int(glm::ceil((boundsMax.x - boundsMin.x) / cellSize)) + 1;
+	sampleCountZ = int(glm::ceil((boundsMax.y - boundsMin.y) / cellSize)) + 1;
+
+	// samples not covered by any triangle keep height 0 and an up facing normal
+	heights.assign(sampleCountX * sampleCountZ, 0.0f);
+	normals.assign(sampleCountX * sampleCountZ, glm::vec3(0, 1, 0));
+	std::vector<bool> covered(sampleCountX * sampleCountZ, false);
+
+	for (GLuint i = 0; i + 2 < indices.size(); i += 3) {
+		const glm::vec3 &a = positions[indices[i]];
+		const glm::vec3 &b = positions[indices[i+1]];
+		const glm::vec3 &c = positions[indices[i+2]];
+
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		if (glm::length(normal) == 0) {
+			continue; // degenerate triangle
+		}
+		normal = glm::normalize(normal);
+		if (normal.y < 0) {
+			normal = -normal;
+		}
+
+		rasterizeTriangle(a, b, c, normal, covered);
+	}
+}
+
+void TerrainHeightField::rasterizeTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &normal, std::vector<bool> &covered)
+{
+	// range of grid samples inside the bounding rectangle of the triangle
+	int minX = glm::max(0, int(glm::ceil((glm::min(a.x, glm::min(b.x, c.x)) - boundsMin.x) / cellSize)));
+	int maxX = glm::min(sampleCountX - 1, int(glm::floor((glm::max(a.x, glm::max(b.x, c.x)) - boundsMin.x) / cellSize)));
+	int minZ = glm::max(0, int(glm::ceil((glm::min(a.z, glm::min(b.z, c.z)) - boundsMin.y) / cellSize)));
+	int maxZ = glm::min(sampleCountZ - 1, int(glm::floor((glm::max(a.z, glm::max(b.z, c.z)) - boundsMin.y) / cellSize)));
+
+	// barycentric coordinates in the xz plane
+	glm::vec2 v0(b.x - a.x, b.z - a.z);
+	glm::vec2 v1(c.x - a.x, c.z - a.z);
+	float denominator = v0.x * v1.y - v1.x * v0.y;
+	if (glm::abs(denominator) < 1e-8f) {
+		return; // triangle is vertical or degenerate in the xz plane
+	}
+
+	const float epsilon = 1e-4f;
+
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int x = minX; x <= maxX; ++x) {
+
+			glm::vec2 p(boundsMin.x + x * cellSize - a.x, boundsMin.y + z * cellSize - a.z);
+			float u = (p.x * v1.y - v1.x * p.y) / denominator;
+			float v = (v0.x * p.y - p.x * v0.y) / denominator;
+
+			if (u < -epsilon || v < -epsilon || u + v > 1 + epsilon) {
+				continue;
+			}
+
+			// if triangles overlap (e.g. overhangs), the highest surface is used
+			float height = a.y + u * (b.y - a.y) + v * (c.y - a.y);
+			int index = z * sampleCountX + x;
+			if (!covered[index] || height > heights[index]) {
+				heights[index] = height;
+				normals[index] = normal;
+				covered[index] = true;
+			}
+		}
+	}
+}
+
+void TerrainHeightField::findCell(const glm::vec2 &pos2D, int &cellX, int &cellZ, glm::vec2 &weights) const
+{
+	glm::vec2 gridPos = (glm::clamp(pos2D, boundsMin, boundsMax) - boundsMin) / cellSize;
+
+	cellX = glm::min(int(gridPos.x), glm::max(sampleCountX - 2, 0));
+	cellZ = glm::min(int(gridPos.y), glm::max(sampleCountZ - 2, 0));
+	weights = glm::clamp(gridPos - glm::vec2(cellX, cellZ), 0.0f, 1.0f);
+}
+
+float TerrainHeightField::getHeight(const glm::vec2 &pos2D) const
+{
+	int x, z;
+	glm::vec2 w;
+	findCell(pos2D, x, z, w);
+
+	int x1 = glm::min(x + 1, sampleCountX - 1);
+	int z1 = glm::min(z + 1, sampleCountZ - 1);
+
+	float h0 = glm::mix(heights[z * sampleCountX + x], heights[z * sampleCountX + x1], w.x);
+	float h1 = glm::mix(heights[z1 * sampleCountX + x], heights[z1 * sampleCountX + x1], w.x);
+
+	return glm::mix(h0, h1, w.y);
+}
+
+glm::vec3 TerrainHeightField::getNormal(const glm::vec2 &pos2D) const
+{
+	int x, z;
+	glm::vec2 w;
+	findCell(pos2D, x, z, w);
+
+	int x1 = glm::min(x + 1, sampleCountX - 1);
+	int z1 = glm::min(z + 1, sampleCountZ - 1);
+
+	glm::vec3 n0 = glm::mix(normals[z * sampleCountX + x], normals[z * sampleCountX + x1], w.x);
+	glm::vec3 n1 = glm::mix(normals[z1 * sampleCountX + x], normals[z1 * sampleCountX + x1], w.x);
+
+	return glm::normalize(glm::mix(n0, n1, w.y));
+}
+
+glm::vec2 TerrainHeightField::getBoundsMin() const
+{
+	return boundsMin;
+}
+
+glm::vec2 TerrainHeightField::getBoundsMax() const
+{
+	return boundsMax;
+}
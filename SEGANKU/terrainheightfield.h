@@ -0,0 +1,92 @@
+#ifndef TERRAINHEIGHTFIELD_H
+#define TERRAINHEIGHTFIELD_H
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <limits>
+
+#include "surface.h"
+
+/**
+ * @brief A TerrainHeightField stores the terrain height and normal on a regular grid in the xz plane.
+ * The grid is baked once from the terrain mesh triangles, so that height and normal queries
+ * take constant time instead of searching through all terrain vertices.
+ * Values between grid samples are bilinearly interpolated.
+ */
+class TerrainHeightField
+{
+	// number of grid samples along x and z
+	int sampleCountX, sampleCountZ;
+
+	// distance between neighbouring grid samples
+	float cellSize;
+
+	// bounds of the terrain in the xz plane (x and y component of the vectors store x and z)
+	glm::vec2 boundsMin, boundsMax;
+
+	// heights and normals of the grid samples, stored row by row (index = z * sampleCountX + x)
+	std::vector<float> heights;
+	std::vector<glm::vec3> normals;
+
+	/**
+	 * @brief rasterize the triangle into the grid, setting height and normal of all covered samples
+	 * @param a first triangle vertex in world space
+	 * @param b second triangle vertex in world space
+	 * @param c third triangle vertex in world space
+	 * @param normal the triangle normal in world space
+	 * @param covered flags marking already covered samples, updated for the samples set here
+	 */
+	void rasterizeTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &normal, std::vector<bool> &covered);
+
+	/**
+	 * @brief get the grid cell containing the given point and the position within the cell
+	 * @param pos2D the point in the xz plane, clamped to the terrain bounds
+	 * @param cellX is set to the x index of the cell
+	 * @param cellZ is set to the z index of the cell
+	 * @param weights is set to the position inside the cell in range [0, 1]
+	 */
+	void findCell(const glm::vec2 &pos2D, int &cellX, int &cellZ, glm::vec2 &weights) const;
+
+public:
+
+	/**
+	 * @brief bake the height field from the triangles of the terrain surface
+	 * @param surface the terrain surface
+	 * @param modelMat the model matrix of the terrain
+	 * @param cellSize_ the distance between grid samples in world space units
+	 */
+	TerrainHeightField(const Surface *surface, const glm::mat4 &modelMat, float cellSize_);
+
+	/**
+	 * @brief get the interpolated terrain height at the given point.
+	 * points outside the terrain bounds are clamped to the bounds.
+	 * @param pos2D the point in the xz plane (x and y component store x and z)
+	 * @return the terrain height (y coordinate) at the point
+	 */
+	float getHeight(const glm::vec2 &pos2D) const;
+
+	/**
+	 * @brief get the interpolated terrain normal at the given point.
+	 * points outside the terrain bounds are clamped to the bounds.
+	 * @param pos2D the point in the xz plane (x and y component store x and z)
+	 * @return the normalized terrain normal at the point
+	 */
+	glm::vec3 getNormal(const glm::vec2 &pos2D) const;
+
+	/**
+	 * @brief get the minimum x and z coordinates of the terrain
+	 * @return the minimum bounds (x and y component store x and z)
+	 */
+	glm::vec2 getBoundsMin() const;
+
+	/**
+	 * @brief get the maximum x and z coordinates of the terrain
+	 * @return the maximum bounds (x and y component store x and z)
+	 */
+	glm::vec2 getBoundsMax() const;
+
+};
+
+#endif // TERRAINHEIGHTFIELD_H
@@ -14,7 +14,7 @@ TextRenderer::TextRenderer(const std::string &fontPath, const GLuint &windowWidt
 	glm::mat4 projMat = glm::ortho(0.0f, static_cast<GLfloat>(windowWidth), 0.0f, static_cast<GLfloat>(windowHeight));
 	projMat = glm::translate(projMat, glm::vec3(0, 0, 1)); // closer to camera to make sure it doesnt get occluded
 	textShader->useShader();
-	glUniformMatrix4fv(glGetUniformLocation(textShader->programHandle, "projMat"), 1, GL_FALSE, glm::value_ptr(projMat));
+	textShader->uniform("projMat").set(projMat);
 
 	// load FreeType glyphs for each character of 7-bit ASCII and create opengl textures from glyph bitmaps
 	// the resulting Glyph structs (texture and glyph metrics) are stored in the glyphs map
@@ -29,14 +29,14 @@ TextRenderer::TextRenderer(const std::string &fontPath, const GLuint &windowWidt
 	// for each vertex we store the x and y position and the uv coordinates, thus 4 floats.
 	// we do not yet copy the data, so the memory space is reserved but uninitialized!
 	// DYNAMIC usage hint is given to GL implementation, since data will be 'modified repeatedly and used many times'.
-	glBindVertexArray(vao);
+	GLState::bindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
 	glEnableVertexAttribArray(0);
 	GLint vertexAttribIndex = 0;
 	glVertexAttribPointer(vertexAttribIndex, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, 0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 
 }
 
@@ -49,9 +49,9 @@ void TextRenderer::renderText(const std::string &text, GLfloat x, GLfloat y, GLf
 {
 	// set bindings
 	textShader->useShader();
-	glUniform3f(glGetUniformLocation(textShader->programHandle, "textColor"), color.x, color.y, color.z);
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(vao);
+	textShader->uniform("textColor").set(color);
+	textShader->uniform("textBitmap").set(3); // glyphs are bound to texture unit 3, which has no sampler bound
+	GLState::bindVertexArray(vao);
 
 	// for each character in the text, get the corresponding glyph and render its texture to a quad
 	std::string::const_iterator character;
@@ -77,7 +77,7 @@ void TextRenderer::renderText(const std::string &text, GLfloat x, GLfloat y, GLf
 		};
 
 		// render the glyph opengl texture onto the quad
-		glBindTexture(GL_TEXTURE_2D, glyph.textureId);
+		GLState::bindTexture(3, glyph.textureId);
 
 		// update vbo memory with new quad vertex data
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -93,10 +93,6 @@ void TextRenderer::renderText(const std::string &text, GLfloat x, GLfloat y, GLf
 	}
 
 
-	// unbind
-	glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
 }
 
 void TextRenderer::loadGlyphs(const std::string &fontPath)
@@ -110,9 +106,14 @@ void TextRenderer::loadGlyphs(const std::string &fontPath)
 	    std::cerr << "ERROR FREETYPE: Could not init FreeType Library." << std::endl;
 	}
 
-	// create a new FreeType typeface
+	// create a new FreeType typeface from the font in the asset pack or the font file.
+	// FreeType reads the font in place, so the asset has to stay loaded until the face is done
+	Asset fontFile;
+	if (!AssetPack::read(fontPath, fontFile)) {
+	    std::cerr << "ERROR FREETYPE: Failed to load font '" << fontPath << "'." << std::endl;
+	}
 	FT_Face typeface;
-	if (FT_New_Face(ft, fontPath.c_str(), 0, &typeface)) {
+	if (FT_New_Memory_Face(ft, reinterpret_cast<const FT_Byte*>(fontFile.getData()), FT_Long(fontFile.getSize()), 0, &typeface)) {
 	    std::cerr << "ERROR FREETYPE: Failed to load font '" << fontPath << "'." << std::endl;
 	}
 
@@ -139,7 +140,7 @@ void TextRenderer::loadGlyphs(const std::string &fontPath)
 		// so we just store them in one of the 8-bit channels, here GL_RED is used
 	    GLuint texture;
 	    glGenTextures(1, &texture);
-	    glBindTexture(GL_TEXTURE_2D, texture);
+	    GLState::bindTexture(0, texture);
 	    glTexImage2D(
 	        GL_TEXTURE_2D,
 	        0,
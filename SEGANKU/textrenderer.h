@@ -18,6 +18,8 @@
 #include FT_FREETYPE_H
 
 #include "shader.h"
+#include "glstate.h"
+#include "assetpack.h"
 
 /**
  * @brief holds information defining the glyph (visual representation) of a character.
@@ -1,18 +1,79 @@
 #include "texture.h"
 
+GLuint Texture::samplers[6] = { 0, 0, 0, 0, 0, 0 };
+
 Texture::Texture(const std::string &filePath_, bool alpha)
 	: filePath(filePath_)
+	, loaded(true)
 {
-	glGenTextures(1, &handle);
-	glActiveTexture(GL_TEXTURE0); // select the active texture unit of the context
-	glBindTexture(GL_TEXTURE_2D, handle);
+	CompressedTexture compressed;
+	if (CompressedTexture::isSupported() && compressed.load(filePath)) {
+		uploadCompressed(compressed);
+		return;
+	}
 
-	// load image from file using FreeImagePlus (the FreeImage C++ wrapper)
 	fipImage img;
-	if (!img.load(filePath.c_str(), 0)) {
+	decode(filePath, img);
+	upload(img, alpha);
+}
+
+Texture::Texture(const std::string &filePath_, fipImage &image, bool alpha)
+	: filePath(filePath_)
+	, loaded(true)
+{
+	upload(image, alpha);
+}
+
+Texture::Texture(const std::string &filePath_, const CompressedTexture &compressed)
+	: filePath(filePath_)
+	, loaded(true)
+{
+	uploadCompressed(compressed);
+}
+
+Texture::Texture(const std::string &filePath_)
+	: filePath(filePath_)
+	, loaded(false)
+{
+	// a single texel is mipmap complete, so it can be sampled with every filter type
+	const GLubyte gray[3] = { 128, 128, 128 };
+
+	glGenTextures(1, &handle);
+	GLState::bindTexture(0, handle);
+	GLint unpackAlignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, gray);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+	setFilterMode(LINEAR_MIPMAP_OFF);
+}
+
+bool Texture::decode(const std::string &filePath, fipImage &image)
+{
+	// load image from the asset pack or the file using FreeImagePlus (the FreeImage C++ wrapper).
+	// FreeImage decodes the image directly from the mapped asset, it only reads the memory
+	Tracer::Scope scope("decode texture " + filePath);
+	Asset imageFile;
+	if (!AssetPack::read(filePath, imageFile)) {
 		std::cerr << "ERROR: FreeImage could not load image file '" << filePath << "'." << std::endl;
+		return false;
 	}
 
+	fipMemoryIO memory(reinterpret_cast<BYTE*>(const_cast<char*>(imageFile.getData())), DWORD(imageFile.getSize()));
+	if (!image.loadFromMemory(memory, 0)) {
+		std::cerr << "ERROR: FreeImage could not load image file '" << filePath << "'." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void Texture::upload(fipImage &img, bool alpha)
+{
+	Tracer::Scope scope("upload texture " + filePath);
+
+	glGenTextures(1, &handle);
+	GLState::bindTexture(0, handle); // select texture unit 0 of the context and bind the texture to it
+
 	// specify a texture of the active texture unit at given target
 	// a unit can contain multiple texture targets, but recommended to use only one per unit
 	// parameters: target, mipmap level, internal format, width, heigth, border width, internal format, data format, image data
@@ -33,43 +94,96 @@ Texture::Texture(const std::string &filePath_, bool alpha)
 
 }
 
+void Texture::uploadCompressed(const CompressedTexture &compressed)
+{
+	Tracer::Scope scope("upload compressed texture " + filePath);
+
+	glGenTextures(1, &handle);
+	GLState::bindTexture(0, handle);
+
+	// the mip chain was built when baking, every level is uploaded as it is stored
+	const std::vector<CompressedTexture::Level> &levels = compressed.getLevels();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+	for (size_t i = 0; i < levels.size(); ++i) {
+		glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), compressed.getGLFormat(), levels[i].width, levels[i].height, 0, GLsizei(levels[i].size), levels[i].data);
+	}
+
+	setFilterMode(LINEAR_MIPMAP_LINEAR);
+}
+
 Texture::~Texture()
 {
 	glDeleteTextures(1, &handle);
+	GLState::invalidate();
 }
 
 void Texture::bind(int unit)
 {
-	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_2D, handle);
+	GLState::bindTexture(unit, handle);
 }
 
 void Texture::setFilterMode(FilterType filterType)
+{
+	GLint minFilter, magFilter;
+	getFilterParameters(filterType, minFilter, magFilter);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+}
+
+void Texture::initSamplers()
+{
+	// sampler objects store the sampling parameters separately from the texture objects.
+	// wrap modes are left at the default GL_REPEAT, same as for the textures.
+	glGenSamplers(6, samplers);
+
+	for (int i = 0; i < 6; ++i) {
+		GLint minFilter, magFilter;
+		getFilterParameters(static_cast<FilterType>(i), minFilter, magFilter);
+
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MIN_FILTER, minFilter);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MAG_FILTER, magFilter);
+	}
+}
+
+void Texture::deleteSamplers()
+{
+	glDeleteSamplers(6, samplers);
+	GLState::invalidate();
+}
+
+void Texture::bindSampler(GLuint unit, FilterType filterType)
+{
+	GLState::bindSampler(unit, samplers[filterType]);
+}
+
+void Texture::getFilterParameters(FilterType filterType, GLint &minFilter, GLint &magFilter)
 {
 	switch (filterType) {
 		case NEAREST_MIPMAP_OFF:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			minFilter = GL_NEAREST;
+			magFilter = GL_NEAREST;
 			break;
 		case NEAREST_MIPMAP_NEAREST:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			minFilter = GL_NEAREST_MIPMAP_NEAREST;
+			magFilter = GL_NEAREST;
 			break;
 		case NEAREST_MIPMAP_LINEAR:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			minFilter = GL_NEAREST_MIPMAP_LINEAR;
+			magFilter = GL_NEAREST;
 			break;
 		case LINEAR_MIPMAP_OFF:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			minFilter = GL_LINEAR;
+			magFilter = GL_LINEAR;
 			break;
 		case LINEAR_MIPMAP_NEAREST:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			minFilter = GL_LINEAR_MIPMAP_NEAREST;
+			magFilter = GL_LINEAR;
 			break;
 		case LINEAR_MIPMAP_LINEAR:
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		default:
+			minFilter = GL_LINEAR_MIPMAP_LINEAR;
+			magFilter = GL_LINEAR;
 			break;
 	}
 }
@@ -79,3 +193,15 @@ std::string Texture::getFilePath() const
 	return filePath;
 }
 
+bool Texture::isLoaded() const
+{
+	return loaded;
+}
+
+void Texture::replaceHandle(GLuint handle_)
+{
+	glDeleteTextures(1, &handle);
+	GLState::invalidate();
+	handle = handle_;
+}
+
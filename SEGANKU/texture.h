@@ -8,6 +8,11 @@
 #include <iostream>
 #include <string>
 
+#include "glstate.h"
+#include "assetpack.h"
+#include "compressedtexture.h"
+#include "tracer.h"
+
 /**
  * @brief Texture class.
  * This loads an opengl texture from an image file and stores a handle to it.
@@ -15,12 +20,45 @@
  */
 class Texture
 {
+	friend class TextureStreamer;
 
 	GLuint handle;
 	const std::string filePath;
 
+	// false while the texture shows a placeholder, until a TextureStreamer has uploaded the image
+	bool loaded;
+
+	// one prebuilt sampler object per FilterType, shared by all textures
+	static GLuint samplers[6];
+
 public:
+	/**
+	 * @brief load a texture, from its compressed file if there is one up to date, else by decoding the image
+	 * @param filePath the image file
+	 * @param alpha true if the image has an alpha channel
+	 */
 	Texture(const std::string &filePath, bool alpha);
+
+	/**
+	 * @brief create a texture from an image decoded before, e.g. on a worker thread
+	 * @param filePath the image file the image was decoded from
+	 * @param image the decoded image, see decode()
+	 * @param alpha true if the image has an alpha channel
+	 */
+	Texture(const std::string &filePath, fipImage &image, bool alpha);
+
+	/**
+	 * @brief create a texture from a compressed file loaded before, with the mip levels it contains
+	 * @param filePath the image file the compressed file was baked from
+	 * @param compressed the loaded compressed file, see CompressedTexture::load()
+	 */
+	Texture(const std::string &filePath, const CompressedTexture &compressed);
+
+	/**
+	 * @brief create a texture showing a gray placeholder, the image is streamed in later by a TextureStreamer
+	 * @param filePath the image file to stream
+	 */
+	explicit Texture(const std::string &filePath);
 	~Texture();
 
 	enum FilterType {
@@ -39,18 +77,79 @@ public:
 	void bind(int unit);
 
 	/**
-	 * @brief set texture minification and magnification filters
+	 * @brief set texture minification and magnification filters of this texture object.
+	 * these are only used if no sampler is bound to the texture unit, see bindSampler().
 	 * minification:  how to filter downsampled texture when there's not enough space
 	 * magnification: how to interpolate texture to fill remaining space
 	 * @param filterType
 	 */
 	void setFilterMode(FilterType filterType);
 
+	/**
+	 * @brief create the sampler objects for all filter types.
+	 * must be called once after the opengl context is created, before bindSampler().
+	 */
+	static void initSamplers();
+
+	/**
+	 * @brief delete the sampler objects created by initSamplers()
+	 */
+	static void deleteSamplers();
+
+	/**
+	 * @brief bind the sampler of the given filter type to a texture unit.
+	 * the sampler stays bound and applies to every texture bound to that unit,
+	 * so switching the filter mode does not touch any texture object.
+	 * @param unit the opengl texture unit to bind to
+	 * @param filterType the filter type of the sampler
+	 */
+	static void bindSampler(GLuint unit, FilterType filterType);
+
 	/**
 	 * @brief get the texture file path
 	 * @return the texture file path
 	 */
 	std::string getFilePath() const;
+
+	/**
+	 * @return false while the texture still shows its placeholder
+	 */
+	bool isLoaded() const;
+
+	/**
+	 * @brief decode an image file from the asset pack or the file.
+	 * needs no opengl context, so images can be decoded on any thread
+	 * @param filePath the image file
+	 * @param image is set to the decoded image
+	 * @return false if the image could not be decoded
+	 */
+	static bool decode(const std::string &filePath, fipImage &image);
+
+private:
+
+	/**
+	 * @brief create the opengl texture of a decoded image
+	 */
+	void upload(fipImage &image, bool alpha);
+
+	/**
+	 * @brief create the opengl texture of a compressed file, no mipmaps are generated
+	 */
+	void uploadCompressed(const CompressedTexture &compressed);
+
+	/**
+	 * @brief replace the opengl texture, e.g. the placeholder by the streamed image, deleting the old one
+	 * @param handle_ the new texture, it is owned by this texture from now on
+	 */
+	void replaceHandle(GLuint handle_);
+
+	/**
+	 * @brief get the minification and magnification filter parameters for a filter type
+	 * @param filterType the filter type
+	 * @param minFilter is set to the minification filter
+	 * @param magFilter is set to the magnification filter
+	 */
+	static void getFilterParameters(FilterType filterType, GLint &minFilter, GLint &magFilter);
 };
 
 #endif // TEXTURE_H
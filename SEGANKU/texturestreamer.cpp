@@ -0,0 +1,218 @@
+#include "texturestreamer.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+TextureStreamer::TextureStreamer(JobSystem *jobs_, size_t frameBudget_)
+	: jobs(jobs_)
+	, frameBudget(frameBudget_)
+	, nextPixelBuffer(0)
+	, pendingCount(0)
+	, uploadedBytesLastFrame(0)
+	, updateCount(0)
+{
+	glGenBuffers(PIXEL_BUFFER_COUNT, pixelBuffers);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	jobs->wait(decodeJobs);
+
+	for (Upload &upload : uploads) {
+		if (upload.handle) {
+			glDeleteTextures(1, &upload.handle);
+		}
+	}
+	GLState::invalidate();
+	glDeleteBuffers(PIXEL_BUFFER_COUNT, pixelBuffers);
+}
+
+std::shared_ptr<Texture> TextureStreamer::request(const std::string &filePath, bool alpha)
+{
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>(filePath);
+	++pendingCount;
+
+	jobs->run(decodeJobs, [this, texture, filePath, alpha]() {
+		Upload upload;
+		upload.texture = texture;
+		upload.compressed = std::make_shared<CompressedTexture>();
+		upload.image = std::make_shared<fipImage>();
+		upload.alpha = alpha;
+		upload.handle = 0;
+		upload.nextRow = 0;
+		upload.nextLevel = 0;
+		upload.uploadedBytes = 0;
+		upload.firstUpdate = 0;
+
+		// a compressed file is only mapped, its levels are uploaded as they are stored
+		if (CompressedTexture::isSupported() && upload.compressed->load(filePath)) {
+			upload.image.reset();
+		}
+		else {
+			upload.compressed.reset();
+
+			// the rows are copied as they are, so bring the image into the format uploaded here instead of on the render thread
+			if (Texture::decode(filePath, *upload.image)) {
+				if (alpha) {
+					upload.image->convertTo32Bits();
+				}
+				else {
+					upload.image->convertTo24Bits();
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		decoded.push_back(upload);
+	});
+
+	return texture;
+}
+
+void TextureStreamer::update()
+{
+	Tracer::Scope scope("stream textures");
+	uploadedBytesLastFrame = 0;
+	++updateCount;
+
+	{
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		uploads.insert(uploads.end(), decoded.begin(), decoded.end());
+		decoded.clear();
+	}
+	if (uploads.empty()) {
+		return;
+	}
+
+	// the rows are packed tightly in the pixel buffers
+	GLint unpackAlignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t budget = frameBudget;
+	bool uploaded = false;
+	while (!uploads.empty() && (budget > 0 || !uploaded)) {
+		Upload &upload = uploads.front();
+
+		// images that could not be decoded keep their placeholder
+		if (!upload.compressed && (upload.image->getWidth() == 0 || upload.image->getHeight() == 0)) {
+			uploads.pop_front();
+			--pendingCount;
+			continue;
+		}
+
+		if (!upload.handle) {
+			upload.firstUpdate = updateCount;
+		}
+		uploaded = true;
+		if (!(upload.compressed ? continueCompressedUpload(upload, budget) : continueUpload(upload, budget))) {
+			break;
+		}
+		finishUpload(upload);
+		uploads.pop_front();
+		--pendingCount;
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+}
+
+int TextureStreamer::getPendingCount() const
+{
+	return pendingCount;
+}
+
+size_t TextureStreamer::getUploadedBytesLastFrame() const
+{
+	return uploadedBytesLastFrame;
+}
+
+bool TextureStreamer::continueUpload(Upload &upload, size_t &budget)
+{
+	fipImage &image = *upload.image;
+	unsigned int width = image.getWidth(), height = image.getHeight();
+	size_t rowSize = size_t(width) * (upload.alpha ? 4 : 3);
+
+	// allocate the texture on the first rows, it is not drawn before it is complete
+	if (!upload.handle) {
+		glGenTextures(1, &upload.handle);
+		GLState::bindTexture(0, upload.handle);
+		glTexImage2D(GL_TEXTURE_2D, 0, upload.alpha ? GL_RGBA : GL_RGB, width, height, 0, upload.alpha ? GL_BGRA : GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+	}
+
+	// as many rows as fit into the budget, but at least one so every texture gets done
+	unsigned int rowCount = unsigned((std::min)(size_t(height - upload.nextRow), (std::max)(budget / rowSize, size_t(1))));
+	size_t size = rowCount * rowSize;
+
+	// orphan the buffer before writing, so the driver does not wait for a transfer still reading it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextPixelBuffer]);
+	nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	char *pixels = static_cast<char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (pixels) {
+		// freeimage pads its rows to 4 bytes, the buffer holds them without padding
+		for (unsigned int row = 0; row < rowCount; ++row) {
+			std::memcpy(pixels + row * rowSize, image.getScanLine(upload.nextRow + row), rowSize);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// the copy from the pixel buffer into the texture runs asynchronously
+		GLState::bindTexture(0, upload.handle);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.nextRow, width, rowCount, upload.alpha ? GL_BGRA : GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+		upload.nextRow += rowCount;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	budget -= (std::min)(budget, size);
+	uploadedBytesLastFrame += size;
+	upload.uploadedBytes += size;
+	return upload.nextRow == height;
+}
+
+bool TextureStreamer::continueCompressedUpload(Upload &upload, size_t &budget)
+{
+	const std::vector<CompressedTexture::Level> &levels = upload.compressed->getLevels();
+	const CompressedTexture::Level &level = levels[upload.nextLevel];
+
+	// the levels are allocated one by one, the texture is not drawn before all of them are there
+	if (!upload.handle) {
+		glGenTextures(1, &upload.handle);
+		GLState::bindTexture(0, upload.handle);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+	}
+
+	// a level is uploaded as a whole, the blocks of a level are not split across frames
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextPixelBuffer]);
+	nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, level.size, nullptr, GL_STREAM_DRAW);
+	char *blocks = static_cast<char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, level.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (blocks) {
+		std::memcpy(blocks, level.data, level.size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		GLState::bindTexture(0, upload.handle);
+		glCompressedTexImage2D(GL_TEXTURE_2D, upload.nextLevel, upload.compressed->getGLFormat(), level.width, level.height, 0, GLsizei(level.size), nullptr);
+		++upload.nextLevel;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	budget -= (std::min)(budget, level.size);
+	uploadedBytesLastFrame += level.size;
+	upload.uploadedBytes += level.size;
+	return upload.nextLevel == levels.size();
+}
+
+void TextureStreamer::finishUpload(Upload &upload)
+{
+	GLState::bindTexture(0, upload.handle);
+	if (!upload.compressed) {
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	upload.texture->replaceHandle(upload.handle);
+	upload.texture->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR);
+	upload.texture->loaded = true;
+	upload.handle = 0;
+
+	std::cout << "streamed texture: " << upload.texture->getFilePath() << " (" << upload.uploadedBytes << " bytes in " << updateCount - upload.firstUpdate + 1 << " frames)" << std::endl;
+}
@@ -0,0 +1,117 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <FreeImagePlus.h>
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "texture.h"
+#include "jobsystem.h"
+
+/**
+ * @brief The TextureStreamer loads textures without stalling the render thread, e.g. for objects created mid-game.
+ * A requested texture is returned at once showing a placeholder. Its image is decoded by a job,
+ * then uploaded through pixel buffer objects a number of rows per frame, up to a byte budget per frame,
+ * into a new texture object that replaces the placeholder once it is complete and has its mipmaps.
+ * If the image has a compressed file (see CompressedTexture), that is mapped instead and uploaded a mip level per step.
+ * Except for the decoding jobs everything runs on the context thread.
+ */
+class TextureStreamer
+{
+public:
+	/**
+	 * @param jobs_ the job system decoding the images
+	 * @param frameBudget_ the number of bytes uploaded per frame at most, at least one row is uploaded per frame
+	 */
+	TextureStreamer(JobSystem *jobs_, size_t frameBudget_);
+
+	/**
+	 * @brief wait for the decoding jobs still running, textures not uploaded yet keep their placeholder
+	 */
+	~TextureStreamer();
+
+	/**
+	 * @brief create a texture showing a placeholder and start loading its image
+	 * @param filePath the image file
+	 * @param alpha true if the image has an alpha channel
+	 * @return the texture, it shows the image once update has uploaded it
+	 */
+	std::shared_ptr<Texture> request(const std::string &filePath, bool alpha);
+
+	/**
+	 * @brief upload the decoded images for up to the byte budget, to be called once per frame
+	 */
+	void update();
+
+	/**
+	 * @return the number of textures requested but not completely uploaded yet
+	 */
+	int getPendingCount() const;
+
+	/**
+	 * @return the number of bytes uploaded by the last update
+	 */
+	size_t getUploadedBytesLastFrame() const;
+
+private:
+	// the pixel buffers are used in turn, so the driver can still read the last one while the next is written
+	static const int PIXEL_BUFFER_COUNT = 2;
+
+	struct Upload {
+		std::shared_ptr<Texture> texture;
+		std::shared_ptr<CompressedTexture> compressed;   // the mapped compressed file if there is one up to date
+		std::shared_ptr<fipImage> image;                 // otherwise the decoded image
+		bool alpha;
+		GLuint handle;            // the texture object being filled, 0 until the upload has started
+		unsigned int nextRow;     // the first row not uploaded yet
+		unsigned int nextLevel;   // the first mip level of the compressed file not uploaded yet
+		size_t uploadedBytes;     // the bytes uploaded so far, reported when the upload is done
+		unsigned int firstUpdate; // the update the upload was started in
+	};
+
+	JobSystem *jobs;
+	JobSystem::TaskGroup decodeJobs;
+	size_t frameBudget;
+
+	// images decoded by the jobs, waiting to be uploaded
+	std::mutex decodedMutex;
+	std::deque<Upload> decoded;
+
+	// uploads in the order they are done, the first one may be in progress
+	std::deque<Upload> uploads;
+
+	GLuint pixelBuffers[PIXEL_BUFFER_COUNT];
+	int nextPixelBuffer;
+
+	int pendingCount;
+	size_t uploadedBytesLastFrame;
+	unsigned int updateCount;
+
+	/**
+	 * @brief upload rows of an image through the next pixel buffer
+	 * @param upload the upload to continue
+	 * @param budget the bytes left in this frame, reduced by the bytes uploaded
+	 * @return true if the image is completely uploaded
+	 */
+	bool continueUpload(Upload &upload, size_t &budget);
+
+	/**
+	 * @brief upload the next mip level of a compressed file through the next pixel buffer
+	 * @param upload the upload to continue
+	 * @param budget the bytes left in this frame, reduced by the bytes uploaded
+	 * @return true if all levels are uploaded
+	 */
+	bool continueCompressedUpload(Upload &upload, size_t &budget);
+
+	/**
+	 * @brief generate the mipmaps of a completely uploaded image, unless it brought its own, and replace the placeholder with it
+	 */
+	void finishUpload(Upload &upload);
+};
+
+#endif // TEXTURESTREAMER_H
@@ -0,0 +1,204 @@
+/**
+ * seganku_bakemodels: converts the model files of the game to baked models (see BakedModel) and their textures
+ * to compressed textures (see CompressedTexture), which the game maps and uploads directly instead of parsing
+ * the model files, decoding the images and generating their mipmaps at every start.
+ * run it from the directory the game is started from, the model paths are relative to it.
+ *
+ * usage: seganku_bakemodels [--measure] [model files...]
+ *
+ * without model files all models of the game world are baked. models and textures whose baked file is up to date are skipped.
+ * with --measure the time to load every model from the model file and from the baked file is reported
+ * afterwards, both cold (file evicted from the page cache first, linux only) and warm, one csv row per model:
+ *     model,parse_cold_ms,parse_warm_ms,baked_cold_ms,baked_warm_ms
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../glstate.h"
+#include "../geometry.h"
+#include "../bakedmodel.h"
+#include "../compressedtexture.h"
+#include "../gameworld.h"
+
+/**
+ * @brief drop a file from the page cache, so the next read has to go to the disk
+ * @return false if this is not supported on this platform
+ */
+bool evictFile(const std::string &filePath)
+{
+#ifdef __linux__
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	fdatasync(fileDescriptor);
+	bool evicted = posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fileDescriptor);
+	return evicted;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief load a model the way the game does without baked files: parse it and build the surfaces
+ * @return the time in ms, negative if the model could not be loaded
+ */
+double measureParse(const std::string &modelPath)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::vector<Geometry::MeshData> meshes;
+	if (!Geometry::importMeshes(modelPath, meshes)) {
+		return -1;
+	}
+	std::vector<std::shared_ptr<Surface>> surfaces;
+	std::shared_ptr<Texture> noTexture;
+	for (const Geometry::MeshData &mesh : meshes) {
+		surfaces.push_back(std::make_shared<Surface>(mesh.vertices, mesh.indices, noTexture, noTexture, noTexture));
+	}
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief load a model the way the game does from its baked file: map it and build the surfaces
+ * @return the time in ms, negative if the model could not be loaded
+ */
+double measureBaked(const std::string &modelPath)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	BakedModel bakedModel;
+	if (!bakedModel.load(modelPath)) {
+		return -1;
+	}
+	std::vector<std::shared_ptr<Surface>> surfaces;
+	std::shared_ptr<Texture> noTexture;
+	for (const BakedModel::SurfaceView &surface : bakedModel.getSurfaces()) {
+		surfaces.push_back(std::make_shared<Surface>(surface.vertices, surface.vertexCount, surface.indices, surface.indexCount,
+		                                             surface.boundingSphereCenter, surface.boundingSphereFarthestPoint, noTexture, noTexture, noTexture));
+	}
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief get the textures of a baked model, relative to the working directory
+ */
+std::set<std::string> getTexturePaths(const std::string &modelPath)
+{
+	std::set<std::string> texturePaths;
+	BakedModel bakedModel;
+	if (bakedModel.load(modelPath)) {
+		for (const BakedModel::SurfaceView &surface : bakedModel.getSurfaces()) {
+			for (const std::string &texturePath : surface.texturePaths) {
+				if (!texturePath.empty()) {
+					texturePaths.insert(Geometry::getTexturePath(modelPath, texturePath));
+				}
+			}
+		}
+	}
+	return texturePaths;
+}
+
+/**
+ * @brief print a time, or "-" if it could not be measured
+ */
+void printTime(double time)
+{
+	std::cout << ',';
+	if (time < 0) {
+		std::cout << '-';
+	}
+	else {
+		std::cout << std::fixed << std::setprecision(3) << time;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool measure = false;
+	std::vector<std::string> modelPaths;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--measure") {
+			measure = true;
+		}
+		else if (!arg.empty() && arg[0] == '-') {
+			std::cerr << "usage: " << argv[0] << " [--measure] [model files...]" << std::endl;
+			return EXIT_FAILURE;
+		}
+		else {
+			modelPaths.push_back(arg);
+		}
+	}
+	if (modelPaths.empty()) {
+		modelPaths = GameWorld::getModelPaths();
+	}
+
+	// only the meshes are baked, nothing is uploaded
+	GLState::contextAvailable = false;
+
+	int failed = 0;
+	std::set<std::string> texturePaths;
+	for (const std::string &modelPath : modelPaths) {
+		if (BakedModel::isUpToDate(modelPath)) {
+			std::cout << "up to date: " << BakedModel::getBakedPath(modelPath) << std::endl;
+		}
+		else if (BakedModel::bake(modelPath)) {
+			std::cout << "baked: " << BakedModel::getBakedPath(modelPath) << std::endl;
+		}
+		else {
+			std::cerr << "ERROR: could not bake " << modelPath << std::endl;
+			++failed;
+			continue;
+		}
+
+		std::set<std::string> modelTextures = getTexturePaths(modelPath);
+		texturePaths.insert(modelTextures.begin(), modelTextures.end());
+	}
+
+	// textures shared by several models are baked once
+	for (const std::string &texturePath : texturePaths) {
+		if (CompressedTexture::isUpToDate(texturePath)) {
+			std::cout << "up to date: " << CompressedTexture::getCompressedPath(texturePath) << std::endl;
+		}
+		else if (CompressedTexture::bake(texturePath)) {
+			std::cout << "baked: " << CompressedTexture::getCompressedPath(texturePath) << std::endl;
+		}
+		else {
+			std::cerr << "ERROR: could not bake " << texturePath << std::endl;
+			++failed;
+		}
+	}
+
+	if (measure) {
+		std::cout << "model,parse_cold_ms,parse_warm_ms,baked_cold_ms,baked_warm_ms" << std::endl;
+		for (const std::string &modelPath : modelPaths) {
+			std::cout << modelPath;
+
+			// the first load after evicting is cold, the second one finds the file in the page cache
+			printTime(evictFile(modelPath) ? measureParse(modelPath) : -1);
+			printTime(measureParse(modelPath));
+			printTime(evictFile(BakedModel::getBakedPath(modelPath)) ? measureBaked(modelPath) : -1);
+			printTime(measureBaked(modelPath));
+			std::cout << std::endl;
+		}
+	}
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
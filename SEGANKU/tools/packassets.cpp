@@ -0,0 +1,106 @@
+/**
+ * seganku_packassets: writes the asset pack (see AssetPack), which the game maps at start instead of opening
+ * every asset file on its own. run it from the directory the game is started from, the asset paths are relative to it
+ * and the game looks assets up by the same paths.
+ *
+ * usage: seganku_packassets [--compress] [--output <pack file>] <asset files...>
+ *
+ * model files (.dae) are baked if their baked model is not up to date, and the baked model is packed instead
+ * of the model file. images (.png, .jpg, .jpeg, .tga, .bmp) are packed together with their compressed texture,
+ * the image is decoded instead where the context cannot sample compressed textures. with --compress assets are compressed with lz4 where that makes them smaller,
+ * which needs a build with SEGANKU_LZ4.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "../glstate.h"
+#include "../assetpack.h"
+#include "../bakedmodel.h"
+#include "../compressedtexture.h"
+
+const std::string DEFAULT_OUTPUT = "seganku.pack";
+const std::string MODEL_EXTENSION = ".dae";
+const std::vector<std::string> IMAGE_EXTENSIONS = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+/**
+ * @brief check if a path ends with the given extension
+ */
+bool hasExtension(const std::string &path, const std::string &extension)
+{
+	return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	bool compress = false;
+	std::string outputPath = DEFAULT_OUTPUT;
+	std::vector<std::string> assetPaths;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--compress") {
+			compress = true;
+		}
+		else if (arg == "--output" && i + 1 < argc) {
+			outputPath = argv[++i];
+		}
+		else if (!arg.empty() && arg[0] == '-') {
+			assetPaths.clear();
+			break;
+		}
+		else {
+			assetPaths.push_back(arg);
+		}
+	}
+	if (assetPaths.empty()) {
+		std::cerr << "usage: " << argv[0] << " [--compress] [--output <pack file>] <asset files...>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (compress && !AssetPack::isCompressionAvailable()) {
+		std::cerr << "ERROR: --compress needs a build with SEGANKU_LZ4" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// only the meshes and textures are baked, nothing is uploaded
+	GLState::contextAvailable = false;
+
+	// the pack must not read assets from an older pack
+	AssetPack::close();
+
+	std::vector<std::string> packedPaths;
+	for (const std::string &path : assetPaths) {
+		bool image = false;
+		for (const std::string &extension : IMAGE_EXTENSIONS) {
+			image = image || hasExtension(path, extension);
+		}
+
+		if (hasExtension(path, MODEL_EXTENSION)) {
+			if (!BakedModel::isUpToDate(path) && !BakedModel::bake(path)) {
+				std::cerr << "ERROR: could not bake " << path << std::endl;
+				return EXIT_FAILURE;
+			}
+			packedPaths.push_back(BakedModel::getBakedPath(path));
+		}
+		else if (image) {
+			if (!CompressedTexture::isUpToDate(path) && !CompressedTexture::bake(path)) {
+				std::cerr << "ERROR: could not bake " << path << std::endl;
+				return EXIT_FAILURE;
+			}
+			packedPaths.push_back(CompressedTexture::getCompressedPath(path));
+			packedPaths.push_back(path);
+		}
+		else {
+			packedPaths.push_back(path);
+		}
+	}
+
+	if (!AssetPack::write(outputPath, packedPaths, compress)) {
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "packed " << packedPaths.size() << " assets into " << outputPath << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include "tracer.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+std::atomic<bool> Tracer::recording(false);
+std::vector<std::unique_ptr<Tracer::ThreadBuffer>> Tracer::threadBuffers;
+std::mutex Tracer::threadBuffersMutex;
+unsigned int Tracer::frame = 0;
+unsigned int Tracer::firstFrame = 1;
+unsigned int Tracer::lastFrame = 0;
+std::string Tracer::filePath;
+std::chrono::steady_clock::time_point Tracer::startTime = std::chrono::steady_clock::now();
+
+Tracer::Scope::Scope(const char *name)
+	: recorded(isRecording())
+{
+	if (recorded) {
+		record('B', name);
+	}
+}
+
+Tracer::Scope::Scope(const std::string &name)
+	: recorded(isRecording())
+{
+	if (recorded) {
+		record('B', name.c_str());
+	}
+}
+
+Tracer::Scope::~Scope()
+{
+	// only end what has been begun, in case the capture started within the scope
+	if (recorded) {
+		record('E', "");
+	}
+}
+
+void Tracer::setCapture(unsigned int firstFrame_, unsigned int lastFrame_, const std::string &filePath_)
+{
+	firstFrame = firstFrame_;
+	lastFrame = lastFrame_;
+	filePath = filePath_;
+	frame = 0;
+
+	if (firstFrame == 0) {
+		std::cout << "TRACE CAPTURE STARTED" << std::endl;
+		recording = true;
+	}
+}
+
+void Tracer::beginFrame()
+{
+	++frame;
+
+	if (filePath.empty()) {
+		return;
+	}
+
+	if (frame == firstFrame) {
+		std::cout << "TRACE CAPTURE STARTED" << std::endl;
+		recording = true;
+	}
+	else if (frame == lastFrame + 1 && recording) {
+		finishCapture();
+	}
+}
+
+void Tracer::finishCapture()
+{
+	if (!recording) {
+		return;
+	}
+
+	recording = false;
+	writeJson();
+	filePath.clear();
+}
+
+void Tracer::setThreadName(const std::string &name)
+{
+	ThreadBuffer &buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	buffer.threadName = name;
+}
+
+bool Tracer::isRecording()
+{
+	return recording.load(std::memory_order_relaxed);
+}
+
+void Tracer::begin(const char *name)
+{
+	if (isRecording()) {
+		record('B', name);
+	}
+}
+
+void Tracer::end()
+{
+	if (isRecording()) {
+		record('E', "");
+	}
+}
+
+Tracer::ThreadBuffer &Tracer::getThreadBuffer()
+{
+	static thread_local ThreadBuffer *threadBuffer = nullptr;
+
+	if (!threadBuffer) {
+		std::lock_guard<std::mutex> lock(threadBuffersMutex);
+		threadBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+		threadBuffer = threadBuffers.back().get();
+		threadBuffer->threadId = int(threadBuffers.size());
+	}
+
+	return *threadBuffer;
+}
+
+void Tracer::record(char type, const char *name)
+{
+	ThreadBuffer &buffer = getThreadBuffer();
+
+	// the events are only allocated once a thread records, not for every thread that sets its name
+	if (!buffer.events) {
+		buffer.events.reset(new Event[EVENTS_PER_THREAD]);
+	}
+
+	std::uint64_t count = buffer.eventCount.load(std::memory_order_relaxed);
+	Event &event = buffer.events[count % EVENTS_PER_THREAD];
+	event.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	event.type = type;
+	std::strncpy(event.name, name, MAX_NAME_LENGTH);
+	event.name[MAX_NAME_LENGTH] = '\0';
+
+	// publish the event to the thread writing the trace
+	buffer.eventCount.store(count + 1, std::memory_order_release);
+}
+
+/**
+ * @brief write a string as json string literal
+ */
+static void writeJsonString(std::ofstream &file, const char *text)
+{
+	file << '"';
+	for (const char *c = text; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			file << '\\' << *c;
+		}
+		else if (*c >= 0 && *c < 0x20) {
+			file << ' ';
+		}
+		else {
+			file << *c;
+		}
+	}
+	file << '"';
+}
+
+void Tracer::writeJson()
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		std::cerr << "ERROR: Could not write trace to " << filePath << std::endl;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+	std::uint64_t totalEvents = 0;
+
+	for (const std::unique_ptr<ThreadBuffer> &buffer : threadBuffers) {
+		if (!buffer->threadName.empty()) {
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+			writeJsonString(file, buffer->threadName.c_str());
+			file << "}}";
+			first = false;
+		}
+
+		// threads still running may record further events meanwhile, only the ones published so far are written.
+		// if the ring buffer has wrapped around, the oldest events are lost.
+		std::uint64_t count = buffer->eventCount.load(std::memory_order_acquire);
+		std::uint64_t begin = count > std::uint64_t(EVENTS_PER_THREAD) ? count - EVENTS_PER_THREAD : 0;
+		for (std::uint64_t i = begin; i < count; ++i) {
+			const Event &event = buffer->events[i % EVENTS_PER_THREAD];
+			file << (first ? "" : ",\n") << "{\"ph\":\"" << event.type << "\",\"ts\":" << event.timestamp << ",\"pid\":1,\"tid\":" << buffer->threadId;
+			if (event.type == 'B') {
+				file << ",\"name\":";
+				writeJsonString(file, event.name);
+			}
+			file << "}";
+			first = false;
+		}
+		totalEvents += count - begin;
+	}
+
+	file << "\n]}\n";
+
+	std::cout << "TRACE CAPTURE WRITTEN: " << totalEvents << " events to " << filePath << std::endl;
+}
@@ -0,0 +1,117 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief The Tracer records begin and end events of named scopes on all threads during a chosen
+ * range of frames and writes them in the chrome trace event format, to be viewed in chrome://tracing
+ * or https://ui.perfetto.dev.
+ *
+ * Every thread writes its events to a ring buffer of its own, so recording needs no locks. Outside a
+ * capture recording costs one relaxed atomic load per scope. Names longer than MAX_NAME_LENGTH are cut.
+ *
+ * Usage:
+ *     Tracer::setCapture(100, 200, "trace.json");   // frames 100 to 200, 0 includes the loading
+ *     ...
+ *     Tracer::beginFrame();                         // once per frame on the main thread
+ *     {
+ *         Tracer::Scope scope("shadow pass");
+ *         ...
+ *     }
+ */
+class Tracer
+{
+public:
+	static const int MAX_NAME_LENGTH = 63;
+
+	// the number of events each thread keeps, older events are overwritten
+	static const int EVENTS_PER_THREAD = 1 << 15;
+
+	/**
+	 * @brief records a begin event on construction and an end event when the scope is left
+	 */
+	class Scope
+	{
+		bool recorded;
+
+	public:
+		explicit Scope(const char *name);
+		explicit Scope(const std::string &name);
+		~Scope();
+	};
+
+	/**
+	 * @brief set the range of frames to record, frames are counted by beginFrame starting at 1.
+	 * a first frame of 0 starts recording immediately, e.g. to include loading the world.
+	 * @param firstFrame the first frame to record
+	 * @param lastFrame the last frame to record, the trace is written when it is over
+	 * @param filePath the json file to write the trace to
+	 */
+	static void setCapture(unsigned int firstFrame, unsigned int lastFrame, const std::string &filePath);
+
+	/**
+	 * @brief count a new frame, starting or finishing the capture when its range begins or ends
+	 */
+	static void beginFrame();
+
+	/**
+	 * @brief write the trace if a capture is still recording, e.g. when the program ends within the range
+	 */
+	static void finishCapture();
+
+	/**
+	 * @brief set the name the calling thread is shown with
+	 */
+	static void setThreadName(const std::string &name);
+
+	static bool isRecording();
+
+	static void begin(const char *name);
+	static void end();
+
+private:
+	struct Event {
+		std::int64_t timestamp;  // microseconds since the start of the program
+		char type;               // 'B' for begin, 'E' for end
+		char name[MAX_NAME_LENGTH + 1];
+	};
+
+	/**
+	 * @brief the events of one thread, written by the thread only
+	 */
+	struct ThreadBuffer {
+		int threadId;
+		std::string threadName;
+		std::unique_ptr<Event[]> events;
+		std::atomic<std::uint64_t> eventCount;  // events written so far, the ring buffer holds the last ones
+
+		ThreadBuffer() : threadId(0), eventCount(0) {}
+	};
+
+	static std::atomic<bool> recording;
+
+	// all thread buffers, the mutex is only locked when a thread records its first event and when writing
+	static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+	static std::mutex threadBuffersMutex;
+
+	static unsigned int frame;
+	static unsigned int firstFrame;
+	static unsigned int lastFrame;
+	static std::string filePath;
+	static std::chrono::steady_clock::time_point startTime;
+
+	Tracer();
+
+	static ThreadBuffer &getThreadBuffer();
+	static void record(char type, const char *name);
+	static void writeJson();
+};
+
+#endif // TRACER_H
@@ -0,0 +1,64 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * @brief A TripleBuffer passes the latest state written by one thread to another thread without locking.
+ * The writer fills the back buffer and publishes it, the reader acquires the latest published buffer.
+ * Neither side ever waits: the third buffer holds the last published state until the reader takes it,
+ * and if the writer publishes again before that, the older state is simply overwritten.
+ */
+template<typename Type>
+class TripleBuffer
+{
+	static const int INDEX_MASK = 3;
+	static const int NEW_DATA = 4; // set on the middle index when it holds a state the reader has not acquired yet
+
+	Type buffers[3];
+	int back = 0;               // only used by the writer
+	std::atomic<int> middle;    // exchanged between writer and reader
+	int front = 2;              // only used by the reader
+
+public:
+	TripleBuffer() : middle(1) {}
+
+	/**
+	 * @brief get the buffer to write the next state to, for the writer thread only
+	 */
+	Type &getWriteBuffer()
+	{
+		return buffers[back];
+	}
+
+	/**
+	 * @brief make the written state available to the reader, for the writer thread only
+	 */
+	void publish()
+	{
+		back = middle.exchange(back | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	/**
+	 * @brief take the latest published state if there is a new one, for the reader thread only
+	 * @return true if a new state has been acquired
+	 */
+	bool acquire()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & NEW_DATA)) {
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	/**
+	 * @brief get the last acquired state, for the reader thread only
+	 */
+	const Type &getReadBuffer() const
+	{
+		return buffers[front];
+	}
+};
+
+#endif // TRIPLEBUFFER_H